@@ -0,0 +1,221 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Bench.h"
+#include "littlepolygon/fastmath.h"
+
+// Output is one record per benchmark, either tab-separated (the default, with
+// '#' comment lines) or a single JSON document with --json:
+//
+//   # name              ns/op     ops
+//   pool/alloc_release  11.204    8388608
+//
+// ns/op is the best of --repetitions runs, each of which performs ops
+// operations and lasts at least --min-time seconds.  --ops runs each benchmark
+// exactly once with a fixed count instead, which is what "make check" uses to
+// exercise the self-checking benchmarks in a DEBUG build.
+
+//--------------------------------------------------------------------------------
+// REGISTRY
+
+static Benchmark* firstBenchmark = 0;
+static Benchmark* lastBenchmark = 0;
+
+Benchmark::Benchmark(const char* aName, BenchFunc aFunc, int anArg) :
+name(aName),
+func(aFunc),
+arg(anArg),
+next(0)
+{
+	// keep registration order, so that related benchmarks are reported together
+	if (lastBenchmark) {
+		lastBenchmark->next = this;
+	} else {
+		firstBenchmark = this;
+	}
+	lastBenchmark = this;
+}
+
+NullRenderBackend& benchRenderBackend()
+{
+	static NullRenderBackend backend;
+	return backend;
+}
+
+//--------------------------------------------------------------------------------
+// RUNNER
+
+struct BenchOptions {
+	const char* filter;
+	double minTime;
+	int repetitions;
+	int64_t ops;
+	bool json;
+	bool list;
+	bool accuracy;
+};
+
+static double runOnce(const Benchmark* bench, int64_t* ioOps)
+{
+	// (the benchmark may round ops up to the number it actually performed)
+	BenchState state(*ioOps, bench->arg);
+	bench->func(&state);
+	*ioOps = state.ops;
+	return state.elapsedSeconds();
+}
+
+static double measure(const Benchmark* bench, const BenchOptions& options, int64_t* outOps)
+{
+	// grow ops geometrically until a single run is long enough to trust,
+	// aiming a little past minTime so that we usually only overshoot once
+
+	if (options.ops > 0) {
+		*outOps = options.ops;
+		return 1e9 * runOnce(bench, outOps) / double(*outOps);
+	}
+
+	const int64_t kMaxOps = int64_t(1) << 40;
+	int64_t ops = 1;
+	double seconds = runOnce(bench, &ops);
+	while(seconds < options.minTime && ops < kMaxOps) {
+		double scale = seconds > 0.0 ? 1.4 * options.minTime / seconds : 100.0;
+		scale = MIN(MAX(scale, 2.0), 100.0);
+		ops = (int64_t) (ops * scale);
+		seconds = runOnce(bench, &ops);
+	}
+
+	double best = seconds;
+	for(int i=1; i<options.repetitions; ++i) {
+		auto repOps = ops;
+		auto repSeconds = runOnce(bench, &repOps);
+		best = MIN(best, repSeconds * double(ops) / double(repOps));
+	}
+	*outOps = ops;
+	return 1e9 * best / double(ops);
+}
+
+static bool matches(const Benchmark* bench, const BenchOptions& options)
+{
+	return options.filter == 0 || strstr(bench->name, options.filter) != 0;
+}
+
+static void printAccuracy(const BenchOptions& options)
+{
+	static const char* names[] = { "low", "medium", "libm" };
+	if (options.json) {
+		printf("  \"fastmath_accuracy\": [\n");
+	} else {
+		printf("# fastmath accuracy (max error vs libm)\n");
+		printf("# precision\tsin\tcos\tatan2\texp\tlog\tpow\n");
+	}
+	for(int p=LP_FAST_MATH_LOW; p<=LP_FAST_MATH_LIBM; ++p) {
+		auto acc = lpMeasureFastMathAccuracy(p);
+		if (options.json) {
+			printf(
+				"    {\"precision\": \"%s\", \"sin\": %.3e, \"cos\": %.3e, \"atan2\": %.3e, \"exp\": %.3e, \"log\": %.3e, \"pow\": %.3e}%s\n",
+				names[p], acc.sinError, acc.cosError, acc.atan2Error, acc.expError, acc.logError, acc.powError,
+				p == LP_FAST_MATH_LIBM ? "" : ","
+			);
+		} else {
+			printf(
+				"# %s\t%.3e\t%.3e\t%.3e\t%.3e\t%.3e\t%.3e\n",
+				names[p], acc.sinError, acc.cosError, acc.atan2Error, acc.expError, acc.logError, acc.powError
+			);
+		}
+	}
+	if (options.json) {
+		printf("  ],\n");
+	}
+}
+
+static void usage(const char* exe)
+{
+	printf(
+		"usage: %s [--filter SUBSTRING] [--min-time SECONDS] [--repetitions N] [--ops N] [--json] [--accuracy] [--list]\n",
+		exe
+	);
+}
+
+int main(int argc, char* argv[])
+{
+	lpSetRenderBackend(&benchRenderBackend());
+
+	BenchOptions options = { 0, 0.2, 3, 0, false, false, false };
+	for(int i=1; i<argc; ++i) {
+		if (strcmp(argv[i], "--filter") == 0 && i+1 < argc) {
+			options.filter = argv[++i];
+		} else if (strcmp(argv[i], "--min-time") == 0 && i+1 < argc) {
+			options.minTime = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--repetitions") == 0 && i+1 < argc) {
+			auto repetitions = atoi(argv[++i]);
+			options.repetitions = MAX(repetitions, 1);
+		} else if (strcmp(argv[i], "--ops") == 0 && i+1 < argc) {
+			options.ops = atoll(argv[++i]);
+		} else if (strcmp(argv[i], "--json") == 0) {
+			options.json = true;
+		} else if (strcmp(argv[i], "--accuracy") == 0) {
+			options.accuracy = true;
+		} else if (strcmp(argv[i], "--list") == 0) {
+			options.list = true;
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (options.list) {
+		for(auto b=firstBenchmark; b; b=b->next) {
+			if (matches(b, options)) { printf("%s\n", b->name); }
+		}
+		return 0;
+	}
+
+	if (options.json) {
+		printf("{\n");
+	}
+	if (options.accuracy) {
+		printAccuracy(options);
+	}
+	if (options.json) {
+		printf("  \"benchmarks\": [\n");
+	} else {
+		printf("# name\tns/op\tops\n");
+	}
+
+	bool first = true;
+	for(auto b=firstBenchmark; b; b=b->next) {
+		if (!matches(b, options)) {
+			continue;
+		}
+		int64_t ops;
+		double nsPerOp = measure(b, options, &ops);
+		if (options.json) {
+			printf(
+				"%s    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"ops\": %lld}",
+				first ? "" : ",\n", b->name, nsPerOp, (long long) ops
+			);
+		} else {
+			printf("%s\t%.3f\t%lld\n", b->name, nsPerOp, (long long) ops);
+		}
+		fflush(stdout);
+		first = false;
+	}
+
+	if (options.json) {
+		printf("\n  ]\n}\n");
+	}
+	return 0;
+}
@@ -0,0 +1,91 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include "littlepolygon/graphics.h"
+
+//--------------------------------------------------------------------------------
+// MICROBENCHMARK HARNESS
+// Each benchmark is a function which performs state->ops operations of some
+// kind, bracketing the part it wants measured with start() and stop() so that
+// setup and teardown are excluded.  The runner grows ops until a run takes long
+// enough to time reliably, then reports the best of a few repetitions in ns/op.
+// A benchmark which can only work in whole batches (e.g. a full sweep of a
+// pool) calls roundUpOps() before starting, or otherwise sets ops to the count
+// it actually performed, since that is what the runner divides by.
+//
+// Benchmarks register themselves at static-init time:
+//
+//   static void benchPoolAlloc(BenchState* state) { ... }
+//   BENCHMARK("pool/alloc_release", benchPoolAlloc);
+//
+// BENCHMARK_ARG registers the same function more than once with a different
+// integer argument (e.g. a worker count), available as state->arg.
+
+class BenchState {
+private:
+	uint64_t startCounter;
+	uint64_t elapsedCounter;
+
+public:
+	int64_t ops;
+	int arg;
+
+	BenchState(int64_t aOps, int anArg) : startCounter(0), elapsedCounter(0), ops(aOps), arg(anArg) {}
+
+	void roundUpOps(int64_t batch) { ops = batch * ((ops + batch - 1) / batch); }
+
+	void start() { startCounter = SDL_GetPerformanceCounter(); }
+	void stop() { elapsedCounter += SDL_GetPerformanceCounter() - startCounter; }
+
+	double elapsedSeconds() const { return double(elapsedCounter) / double(SDL_GetPerformanceFrequency()); }
+};
+
+typedef void (*BenchFunc)(BenchState* state);
+
+struct Benchmark {
+	const char* name;
+	BenchFunc func;
+	int arg;
+	Benchmark* next;
+
+	Benchmark(const char* aName, BenchFunc aFunc, int anArg=0);
+};
+
+#define BENCHMARK(_name, _func)             static Benchmark _func##Registration(_name, _func)
+#define BENCHMARK_ARG(_name, _func, _arg)   static Benchmark _func##Registration##_arg(_name, _func, _arg)
+
+// Keeps the optimizer from discarding a result which is otherwise unused.
+template<typename T>
+inline void benchKeep(const T& value)
+{
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+//--------------------------------------------------------------------------------
+// HEADLESS RENDERING
+// main() installs a NullRenderBackend before any benchmark runs, so that the
+// plotters work with no window or GPU.  NullGL.cpp stands in for the GL driver
+// and GLEW at link time.
+
+NullRenderBackend& benchRenderBackend();
+
+//--------------------------------------------------------------------------------
+// SHARED FIXTURES
+
+// a single-frame 32x32 image on a preinitialized 1024x1024 atlas
+struct ImageAsset;
+ImageAsset* benchImage();
@@ -0,0 +1,301 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Bench.h"
+#include "littlepolygon/rig.h"
+#include "littlepolygon/particles.h"
+
+//--------------------------------------------------------------------------------
+// SYNTHETIC RIG
+// A 32-bone binary tree with one attachment per bone and a one-second "idle"
+// animation which keys translation, rotation and scale on every bone (eight
+// keyframes each), which is on the heavy side for a character.
+
+#define RIG_BONES     32
+#define RIG_KEYFRAMES 8
+
+struct BenchRigData {
+	RigAsset asset;
+	RigBoneAsset bones[RIG_BONES];
+	RigSlotAsset slots[RIG_BONES];
+	RigAttachmentAsset attachments[RIG_BONES];
+	RigAnimationAsset anim;
+	RigTimelineAsset timelines[3 * RIG_BONES];
+	RigHashIndex boneLookup[RIG_BONES];
+
+	// float timelines
+	lpFloat times[RIG_KEYFRAMES];
+	lpFloat radians[RIG_BONES][RIG_KEYFRAMES];
+	lpVec translations[RIG_BONES][RIG_KEYFRAMES];
+	lpVec scales[RIG_BONES][RIG_KEYFRAMES];
+
+	// quantized timelines
+	RigQuantization quantization[3 * RIG_BONES];
+	uint16_t packedKeys[3 * RIG_BONES][3 * RIG_KEYFRAMES];
+
+	void init(bool quantized);
+	void quantize(int i);
+};
+
+static int compareHashIndex(const void* a, const void* b)
+{
+	auto ha = ((const RigHashIndex*) a)->hash;
+	auto hb = ((const RigHashIndex*) b)->hash;
+	return ha < hb ? -1 : ha > hb ? 1 : 0;
+}
+
+void BenchRigData::init(bool quantized)
+{
+	for(int i=0; i<RIG_BONES; ++i) {
+		char name[16];
+		snprintf(name, sizeof(name), "bone%d", i);
+		auto& bone = bones[i];
+		bone.parentIndex = i > 0 ? (i-1) >> 1 : 0;
+		bone.hash = fnv1a(name);
+		bone.translation = vec(8.0f, 0.0f);
+		bone.scale = vec(1.0f, 1.0f);
+		bone.radians = 0.1f * i;
+		boneLookup[i].hash = bone.hash;
+		boneLookup[i].index = i;
+
+		slots[i].boneIndex = i;
+		slots[i].defaultAttachment = i;
+		slots[i].defaultColor = rgba(0);
+
+		attachments[i].slot = slots + i;
+		attachments[i].image = benchImage();
+		attachments[i].hash = bone.hash;
+		attachments[i].layerHash = 0;
+		attachments[i].xform = matIdentity();
+	}
+	qsort(boneLookup, RIG_BONES, sizeof(RigHashIndex), compareHashIndex);
+
+	for(int k=0; k<RIG_KEYFRAMES; ++k) {
+		times[k] = k / lpFloat(RIG_KEYFRAMES - 1);
+	}
+	for(int i=0; i<RIG_BONES; ++i) {
+		for(int k=0; k<RIG_KEYFRAMES; ++k) {
+			auto phase = kTAU * k / (RIG_KEYFRAMES - 1) + i;
+			radians[i][k] = 0.5f * lpSin(phase);
+			translations[i][k] = vec(8.0f + lpCos(phase), lpSin(phase));
+			scales[i][k] = vec(1.0f + 0.1f * lpSin(phase), 1.0f);
+		}
+	}
+
+	anim.hash = fnv1a("idle");
+	anim.duration = 1.0f;
+	anim.firstTimeline = 0;
+	anim.ntimelines = 3 * RIG_BONES;
+
+	for(int i=0; i<RIG_BONES; ++i) {
+		for(int kind=0; kind<3; ++kind) {
+			auto& tl = timelines[3*i + kind];
+			tl.times = times;
+			tl.nkeyframes = RIG_KEYFRAMES;
+			tl.animHash = anim.hash;
+			tl.boneIndex = i;
+			switch(kind) {
+				case 0:
+					tl.kind = kTimelineTranslation;
+					tl.translationValues = translations[i];
+					break;
+				case 1:
+					tl.kind = kTimelineRotation;
+					tl.rotationValues = radians[i];
+					break;
+				default:
+					tl.kind = kTimelineScale;
+					tl.scaleValues = scales[i];
+					break;
+			}
+			if (quantized) {
+				quantize(3*i + kind);
+			}
+		}
+	}
+
+	asset.defaultLayer = 0;
+	asset.nbones = RIG_BONES;
+	asset.nslots = RIG_BONES;
+	asset.nattachments = RIG_BONES;
+	asset.nanims = 1;
+	asset.ntimeslines = 3 * RIG_BONES;
+	asset.bones = bones;
+	asset.slots = slots;
+	asset.attachments = attachments;
+	asset.anims = &anim;
+	asset.timelines = timelines;
+	asset.boneLookup = boneLookup;
+}
+
+void BenchRigData::quantize(int i)
+{
+	// fit the value range of the float timeline into 16 bits
+	auto& tl = timelines[i];
+	auto rotation = tl.type() == kTimelineRotation;
+	unsigned stride = rotation ? 2 : 3;
+	lpVec lo = vec(1e9f, 1e9f);
+	lpVec hi = vec(-1e9f, -1e9f);
+	for(unsigned k=0; k<tl.nkeyframes; ++k) {
+		auto value = rotation ? vec(tl.rotationValues[k], 0.0f) : tl.translationValues[k];
+		lo = vec(MIN(lo.x, value.x), MIN(lo.y, value.y));
+		hi = vec(MAX(hi.x, value.x), MAX(hi.y, value.y));
+	}
+
+	auto& q = quantization[i];
+	q.timeScale = times[RIG_KEYFRAMES-1] / 65535.0f;
+	q.offset = lo;
+	q.scale = vec(MAX(hi.x - lo.x, 1e-6f), MAX(hi.y - lo.y, 1e-6f)) / 65535.0f;
+
+	auto keys = packedKeys[i];
+	for(unsigned k=0; k<tl.nkeyframes; ++k) {
+		auto value = rotation ? vec(tl.rotationValues[k], 0.0f) : tl.translationValues[k];
+		keys[stride*k] = (uint16_t) (times[k] / q.timeScale + 0.5f);
+		keys[stride*k + 1] = (uint16_t) ((value.x - lo.x) / q.scale.x + 0.5f);
+		if (!rotation) {
+			keys[stride*k + 2] = (uint16_t) ((value.y - lo.y) / q.scale.y + 0.5f);
+		}
+	}
+	tl.packedKeys = keys;
+	tl.quantization = &q;
+	tl.kind |= kTimelineQuantized;
+}
+
+static BenchRigData floatRig;
+static BenchRigData quantizedRig;
+
+static const RigAsset* benchRig(bool quantized)
+{
+	auto& data = quantized ? quantizedRig : floatRig;
+	if (data.asset.nbones == 0) {
+		data.init(quantized);
+	}
+	return &data.asset;
+}
+
+//--------------------------------------------------------------------------------
+// RIG
+// One op is one frame of a single rig: tick() plus the hierarchy walk.  Frame
+// times are irregular so keyframe searches don't settle into a pattern.
+
+static lpFloat frameTime(int64_t i)
+{
+	return (1.0f / 60.0f) * (1.0f + 0.25f * ((i * 7) & 3));
+}
+
+static void benchRigTick(BenchState* state)
+{
+	Rig rig(benchRig(state->arg != 0));
+	rig.setAnimation("idle");
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		rig.tick(frameTime(i));
+		rig.refreshTransforms();
+	}
+	state->stop();
+	benchKeep(rig.rootTransform());
+}
+BENCHMARK_ARG("rig/tick_32_bones", benchRigTick, 0);
+BENCHMARK_ARG("rig/tick_32_bones_quantized", benchRigTick, 1);
+
+static void benchRigTickBaked(BenchState* state)
+{
+	auto asset = benchRig(false);
+	RigBake bake(asset, "idle");
+	Rig rig(asset);
+	rig.setAnimation(&bake);
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		rig.tick(frameTime(i));
+		rig.refreshTransforms();
+	}
+	state->stop();
+	benchKeep(rig.rootTransform());
+}
+BENCHMARK("rig/tick_32_bones_baked", benchRigTickBaked);
+
+static void benchRigDraw(BenchState* state)
+{
+	// one op is one animated rig drawn into the plotter (32 quads)
+	Plotter plotter(4096);
+	SpritePlotter sprites(&plotter);
+	Rig rig(benchRig(false));
+	rig.setAnimation("idle");
+
+	state->start();
+	sprites.begin(Viewport(vec(1024, 768)));
+	for(int64_t i=0; i<state->ops; ++i) {
+		rig.tick(frameTime(i));
+		rig.draw(&sprites);
+	}
+	sprites.end();
+	state->stop();
+}
+BENCHMARK("rig/tick_draw_32_bones", benchRigDraw);
+
+//--------------------------------------------------------------------------------
+// PARTICLES
+// One op is one 60Hz frame of a system holding ~5000 live particles, after
+// warming up past the lifespan so that births and deaths are balanced.
+
+static void benchParticleTick(BenchState* state)
+{
+	ParticleSystem system(vec(0, 200));
+	for(int i=0; i<4; ++i) {
+		system.addEmitter(vec(100 + 200 * i, 300), 1250.0f)
+			->setLifespan(1.0f)
+			->setSpeed(50.0f, 150.0f)
+			->setRadius(16.0f);
+	}
+	for(int i=0; i<120; ++i) {
+		system.tick(1.0f / 60.0f);
+	}
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		system.tick(1.0f / 60.0f);
+	}
+	state->stop();
+	benchKeep(system.count());
+}
+BENCHMARK("particles/tick_5k", benchParticleTick);
+
+static void benchParticleDraw(BenchState* state)
+{
+	// one op is one frame's worth of particles drawn
+	ParticleSystem system(vec(0, 200));
+	for(int i=0; i<4; ++i) {
+		system.addEmitter(vec(100 + 200 * i, 300), 1250.0f)
+			->setLifespan(1.0f)
+			->setSpeed(50.0f, 150.0f);
+	}
+	for(int i=0; i<120; ++i) {
+		system.tick(1.0f / 60.0f);
+	}
+
+	Plotter plotter(4096);
+	SpritePlotter sprites(&plotter);
+	state->start();
+	sprites.begin(Viewport(vec(1024, 768), vec(512, 384)));
+	for(int64_t i=0; i<state->ops; ++i) {
+		system.draw(&sprites, benchImage());
+	}
+	sprites.end();
+	state->stop();
+}
+BENCHMARK("particles/draw_5k", benchParticleDraw);
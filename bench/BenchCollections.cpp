@@ -0,0 +1,664 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Bench.h"
+#include "littlepolygon/assets.h"
+#include "littlepolygon/pools.h"
+#include "littlepolygon/collections.h"
+#include <unordered_map>
+
+// Pools are measured half-full, releasing a pseudo-random live record and
+// allocating a replacement each op, which is the steady state of e.g. bullets
+// or particles.  Iteration is measured per record visited.
+
+#define POOL_CAPACITY 1024
+#define POOL_LIVE     512
+
+struct BenchRecord {
+	lpVec position;
+	lpVec velocity;
+	lpFloat life;
+	int id;
+
+	BenchRecord(int anId) : position(0,0), velocity(1,1), life(1.0f), id(anId) {}
+};
+
+static inline int scatter(int64_t i, int count)
+{
+	// count must be a power of two; the odd multiplier visits every slot
+	return (int) ((i * 2654435761u) & (count - 1));
+}
+
+//--------------------------------------------------------------------------------
+// POOL
+
+static void benchPoolAllocRelease(BenchState* state)
+{
+	Pool<BenchRecord> pool(POOL_CAPACITY);
+	BenchRecord* live[POOL_LIVE];
+	for(int i=0; i<POOL_LIVE; ++i) { live[i] = pool.alloc(i); }
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		auto slot = scatter(i, POOL_LIVE);
+		pool.release(live[slot]);
+		live[slot] = pool.alloc(slot);
+	}
+	state->stop();
+}
+BENCHMARK("pool/Pool_alloc_release", benchPoolAllocRelease);
+
+static void benchPoolIterate(BenchState* state)
+{
+	Pool<BenchRecord> pool(POOL_CAPACITY);
+	for(int i=0; i<POOL_CAPACITY; ++i) { pool.alloc(i); }
+
+	state->roundUpOps(POOL_CAPACITY);
+	state->start();
+	for(int64_t visited=0; visited<state->ops;) {
+		for(pool.iterBegin(); auto p=pool.iterNext();) {
+			p->position += p->velocity;
+			++visited;
+		}
+	}
+	state->stop();
+}
+BENCHMARK("pool/Pool_iterate", benchPoolIterate);
+
+static void benchCompactPoolAllocRelease(BenchState* state)
+{
+	// records move on release, so we pick victims by position instead
+	CompactPool<BenchRecord> pool(POOL_CAPACITY);
+	for(int i=0; i<POOL_LIVE; ++i) { pool.alloc(i); }
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		pool.release(pool.begin() + scatter(i, POOL_LIVE));
+		pool.alloc((int) i);
+	}
+	state->stop();
+}
+BENCHMARK("pool/CompactPool_alloc_release", benchCompactPoolAllocRelease);
+
+static void benchCompactPoolIterate(BenchState* state)
+{
+	CompactPool<BenchRecord> pool(POOL_CAPACITY);
+	for(int i=0; i<POOL_CAPACITY; ++i) { pool.alloc(i); }
+
+	state->roundUpOps(pool.size());
+	state->start();
+	for(int64_t visited=0; visited<state->ops; visited+=pool.size()) {
+		for(auto p=pool.begin(); p!=pool.end(); ++p) {
+			p->position += p->velocity;
+		}
+	}
+	state->stop();
+}
+BENCHMARK("pool/CompactPool_iterate", benchCompactPoolIterate);
+
+static void benchBatchPoolAllocRelease(BenchState* state)
+{
+	BatchPool<BenchRecord> pool(POOL_CAPACITY);
+	BatchHandle<BenchRecord> live[POOL_LIVE];
+	for(int i=0; i<POOL_LIVE; ++i) { live[i] = pool.alloc(i); }
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		auto slot = scatter(i, POOL_LIVE);
+		pool.release(live[slot]);
+		live[slot] = pool.alloc(slot);
+	}
+	state->stop();
+}
+BENCHMARK("pool/BatchPool_alloc_release", benchBatchPoolAllocRelease);
+
+static void benchBatchPoolIterate(BenchState* state)
+{
+	BatchPool<BenchRecord> pool(POOL_CAPACITY);
+	for(int i=0; i<POOL_CAPACITY; ++i) { pool.alloc(i); }
+
+	state->roundUpOps(POOL_CAPACITY);
+	state->start();
+	for(int64_t visited=0; visited<state->ops; visited+=POOL_CAPACITY) {
+		for(auto p=pool.begin(); p!=pool.end(); ++p) {
+			p->position += p->velocity;
+		}
+	}
+	state->stop();
+}
+BENCHMARK("pool/BatchPool_iterate", benchBatchPoolIterate);
+
+static void benchChunkedPoolAllocRelease(BenchState* state)
+{
+	ChunkedPool<BenchRecord> pool;
+	BenchRecord* live[POOL_LIVE];
+	for(int i=0; i<POOL_LIVE; ++i) { live[i] = pool.alloc(i); }
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		auto slot = scatter(i, POOL_LIVE);
+		pool.release(live[slot]);
+		live[slot] = pool.alloc(slot);
+	}
+	state->stop();
+}
+BENCHMARK("pool/ChunkedPool_alloc_release", benchChunkedPoolAllocRelease);
+
+static void benchSlotPoolAllocRelease(BenchState* state)
+{
+	SlotPool<BenchRecord> pool(POOL_CAPACITY);
+	SlotHandle live[POOL_LIVE];
+	for(int i=0; i<POOL_LIVE; ++i) { live[i] = pool.alloc(i); }
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		auto slot = scatter(i, POOL_LIVE);
+		pool.release(live[slot]);
+		live[slot] = pool.alloc(slot);
+	}
+	state->stop();
+}
+BENCHMARK("pool/SlotPool_alloc_release", benchSlotPoolAllocRelease);
+
+static void benchSlotPoolGet(BenchState* state)
+{
+	SlotPool<BenchRecord> pool(POOL_CAPACITY);
+	SlotHandle live[POOL_LIVE];
+	for(int i=0; i<POOL_LIVE; ++i) { live[i] = pool.alloc(i); }
+
+	uint32_t sum = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		sum += pool.get(live[scatter(i, POOL_LIVE)])->id;
+	}
+	state->stop();
+	benchKeep(sum);
+}
+BENCHMARK("pool/SlotPool_get", benchSlotPoolGet);
+
+//--------------------------------------------------------------------------------
+// COMPONENT STORES
+// Positions on every entity, velocities on half, sprites on a sixteenth; op is
+// one joined entity.
+
+#define ENTITY_COUNT 16384
+
+struct BenchSpriteRef { int image; lpVec position; };
+
+static void benchComponentJoin(BenchState* state)
+{
+	ComponentStore<lpVec> positions(ENTITY_COUNT, ENTITY_COUNT);
+	ComponentStore<lpVec> velocities(ENTITY_COUNT, ENTITY_COUNT);
+	ComponentStore<BenchSpriteRef> sprites(ENTITY_COUNT, ENTITY_COUNT);
+	for(EntityID e=0; e<ENTITY_COUNT; ++e) {
+		positions.add(e, lpFloat(e), 0.0f);
+		if ((e & 1) == 0) { velocities.add(e, 1.0f, 1.0f); }
+		if ((e & 15) == 0) { sprites.add(e); }
+	}
+
+	state->roundUpOps(ENTITY_COUNT/2);
+	state->start();
+	for(int64_t joined=0; joined<state->ops; joined+=ENTITY_COUNT/2) {
+		lpJoin([](EntityID, lpVec* p, lpVec* v) { *p += *v; }, positions, velocities);
+	}
+	state->stop();
+	benchKeep(positions.begin()->x);
+}
+BENCHMARK("ecs/join_position_velocity", benchComponentJoin);
+
+static void benchComponentJoinSparse(BenchState* state)
+{
+	ComponentStore<lpVec> positions(ENTITY_COUNT, ENTITY_COUNT);
+	ComponentStore<lpVec> velocities(ENTITY_COUNT, ENTITY_COUNT);
+	ComponentStore<BenchSpriteRef> sprites(ENTITY_COUNT, ENTITY_COUNT);
+	for(EntityID e=0; e<ENTITY_COUNT; ++e) {
+		positions.add(e, lpFloat(e), 0.0f);
+		if ((e & 1) == 0) { velocities.add(e, 1.0f, 1.0f); }
+		if ((e & 15) == 0) { sprites.add(e); }
+	}
+
+	state->roundUpOps(ENTITY_COUNT/16);
+	state->start();
+	for(int64_t joined=0; joined<state->ops; joined+=ENTITY_COUNT/16) {
+		lpJoin([](EntityID, lpVec* p, lpVec* v, BenchSpriteRef* s) {
+			*p += *v;
+			s->position = *p;
+		}, positions, velocities, sprites);
+	}
+	state->stop();
+	benchKeep(sprites.begin()->position.x);
+}
+BENCHMARK("ecs/join_position_velocity_sprite", benchComponentJoinSparse);
+
+//--------------------------------------------------------------------------------
+// HASHING
+// 4096 random keys, looked up in a scattered order.  std::unordered_map and a
+// linear List search are here as reference points.
+
+#define HASH_KEYS 4096
+
+static void makeKeys(uint32_t* keys, int count)
+{
+	srand(1);
+	for(int i=0; i<count; ++i) {
+		keys[i] = (uint32_t(rand()) << 16) ^ uint32_t(rand()) ^ (uint32_t(i) << 28);
+	}
+}
+
+static void benchHashMapFind(BenchState* state)
+{
+	static uint32_t keys[HASH_KEYS];
+	makeKeys(keys, HASH_KEYS);
+	HashMap<uint32_t, int> map;
+	for(int i=0; i<HASH_KEYS; ++i) { map.insert(keys[i], i); }
+
+	uint32_t sum = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		sum += *map.find(keys[scatter(i, HASH_KEYS)]);
+	}
+	state->stop();
+	benchKeep(sum);
+}
+BENCHMARK("hash/HashMap_find_hit", benchHashMapFind);
+
+static void benchHashMapFindMiss(BenchState* state)
+{
+	static uint32_t keys[HASH_KEYS];
+	makeKeys(keys, HASH_KEYS);
+	HashMap<uint32_t, int> map;
+	for(int i=0; i<HASH_KEYS; ++i) { map.insert(keys[i], i); }
+
+	int misses = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		misses += map.find(keys[scatter(i, HASH_KEYS)] + 1) == 0;
+	}
+	state->stop();
+	benchKeep(misses);
+}
+BENCHMARK("hash/HashMap_find_miss", benchHashMapFindMiss);
+
+static void benchHashMapInsertRemove(BenchState* state)
+{
+	static uint32_t keys[HASH_KEYS];
+	makeKeys(keys, HASH_KEYS);
+	HashMap<uint32_t, int> map;
+	for(int i=0; i<HASH_KEYS/2; ++i) { map.insert(keys[i], i); }
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		// swap a key between the live and dead halves
+		auto slot = scatter(i, HASH_KEYS/2);
+		map.remove(keys[slot]);
+		map.insert(keys[slot + HASH_KEYS/2], slot);
+		auto tmp = keys[slot];
+		keys[slot] = keys[slot + HASH_KEYS/2];
+		keys[slot + HASH_KEYS/2] = tmp;
+	}
+	state->stop();
+}
+BENCHMARK("hash/HashMap_insert_remove", benchHashMapInsertRemove);
+
+static void benchUnorderedMapFind(BenchState* state)
+{
+	static uint32_t keys[HASH_KEYS];
+	makeKeys(keys, HASH_KEYS);
+	std::unordered_map<uint32_t, int> map;
+	for(int i=0; i<HASH_KEYS; ++i) { map[keys[i]] = i; }
+
+	uint32_t sum = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		sum += map.find(keys[scatter(i, HASH_KEYS)])->second;
+	}
+	state->stop();
+	benchKeep(sum);
+}
+BENCHMARK("hash/unordered_map_find_hit", benchUnorderedMapFind);
+
+static void benchListFind(BenchState* state)
+{
+	// the kind of small linear lookup HashMap replaced
+	static uint32_t keys[64];
+	makeKeys(keys, 64);
+	List<uint32_t> list(64);
+	for(int i=0; i<64; ++i) { list.append(keys[i]); }
+
+	uint32_t sum = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		sum += list.findFirst(keys[scatter(i, 64)]);
+	}
+	state->stop();
+	benchKeep(sum);
+}
+BENCHMARK("hash/List_findFirst_64", benchListFind);
+
+//--------------------------------------------------------------------------------
+// QUEUES
+// Single-threaded enqueue+dequeue pairs measure the bookkeeping cost; the
+// threaded SPSC case is one item handed from a producer thread to the bench
+// thread, and the threaded MPMC cases are one item handed between pools of
+// producer and consumer threads.  In DEBUG builds (see "make check") the
+// threaded cases check that every item arrives exactly once, and the
+// single-threaded ones check that items left in a queue are destroyed with it.
+
+#if DEBUG
+struct QueueCanary {
+	static int live;
+
+	explicit QueueCanary(int) { ++live; }
+	QueueCanary(const QueueCanary&) { ++live; }
+	~QueueCanary() { --live; }
+};
+
+int QueueCanary::live = 0;
+
+template<typename Q>
+static void checkQueueTeardown()
+{
+	// (cycle part of the way round first, so the leftovers wrap the ring)
+	{
+		Q queue(8);
+		QueueCanary out(0);
+		for(int i=0; i<6; ++i) {
+			queue.tryEmplace(i);
+			queue.tryDequeue(&out);
+		}
+		for(int i=0; i<5; ++i) {
+			queue.tryEmplace(i);
+		}
+		ASSERT(QueueCanary::live == 1 + 5);
+	}
+	ASSERT(QueueCanary::live == 0);
+}
+#endif
+
+static void benchQueue(BenchState* state)
+{
+	Queue<int> queue(256);
+	uint32_t sum = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		queue.enqueue((int) i);
+		sum += queue.dequeue();
+	}
+	state->stop();
+	benchKeep(sum);
+}
+BENCHMARK("queue/Queue_enqueue_dequeue", benchQueue);
+
+static void benchSPSCQueue(BenchState* state)
+{
+	#if DEBUG
+	checkQueueTeardown<SPSCQueue<QueueCanary>>();
+	#endif
+
+	SPSCQueue<int> queue(256);
+	uint32_t sum = 0;
+	int value = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		queue.tryEnqueue((int) i);
+		queue.tryDequeue(&value);
+		sum += value;
+	}
+	state->stop();
+	benchKeep(sum);
+}
+BENCHMARK("queue/SPSCQueue_enqueue_dequeue", benchSPSCQueue);
+
+static void benchMPMCQueue(BenchState* state)
+{
+	#if DEBUG
+	checkQueueTeardown<MPMCQueue<QueueCanary>>();
+	#endif
+
+	MPMCQueue<int> queue(256);
+	uint32_t sum = 0;
+	int value = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		queue.tryEnqueue((int) i);
+		queue.tryDequeue(&value);
+		sum += value;
+	}
+	state->stop();
+	benchKeep(sum);
+}
+BENCHMARK("queue/MPMCQueue_enqueue_dequeue", benchMPMCQueue);
+
+struct SPSCProducer {
+	SPSCQueue<int64_t>* queue;
+	int64_t count;
+};
+
+static int produce(void* data)
+{
+	auto producer = (SPSCProducer*) data;
+	for(int64_t i=0; i<producer->count;) {
+		if (producer->queue->tryEnqueue(i)) { ++i; } else { SDL_Delay(0); }
+	}
+	return 0;
+}
+
+static void benchSPSCQueueThreaded(BenchState* state)
+{
+	SPSCQueue<int64_t> queue(1024);
+	SPSCProducer producer = { &queue, state->ops };
+	int64_t sum = 0, value;
+
+	state->start();
+	auto thread = SDL_CreateThread(produce, "producer", &producer);
+	for(int64_t i=0; i<state->ops;) {
+		if (queue.tryDequeue(&value)) {
+			// (in order, so exactly once)
+			ASSERT(value == i);
+			sum += value;
+			++i;
+		} else {
+			SDL_Delay(0);
+		}
+	}
+	SDL_WaitThread(thread, 0);
+	state->stop();
+	benchKeep(sum);
+}
+BENCHMARK("queue/SPSCQueue_threaded_handoff", benchSPSCQueueThreaded);
+
+// Producer p enqueues the values congruent to p modulo the number of
+// producers, and the consumers dequeue until the total has been consumed.
+
+#define MPMC_MAX_THREADS 4
+
+struct MPMCShared {
+	MPMCQueue<int64_t>* queue;
+	int64_t count;
+	int nproducers;
+	std::atomic<int64_t> consumed;
+	#if DEBUG
+	std::atomic<uint32_t>* seen; // one bit per value
+	#endif
+};
+
+struct MPMCWorker {
+	MPMCShared* shared;
+	int index;
+	int64_t sum;
+};
+
+static int produceMPMC(void* data)
+{
+	auto worker = (MPMCWorker*) data;
+	auto shared = worker->shared;
+	for(int64_t i=worker->index; i<shared->count;) {
+		if (shared->queue->tryEnqueue(i)) { i += shared->nproducers; } else { SDL_Delay(0); }
+	}
+	return 0;
+}
+
+static int consumeMPMC(void* data)
+{
+	auto worker = (MPMCWorker*) data;
+	auto shared = worker->shared;
+	int64_t value;
+	while(shared->consumed.load(std::memory_order_relaxed) < shared->count) {
+		if (shared->queue->tryDequeue(&value)) {
+			shared->consumed.fetch_add(1, std::memory_order_relaxed);
+			worker->sum += value;
+			#if DEBUG
+			auto bit = 1u << (value & 31);
+			auto prev = shared->seen[value >> 5].fetch_or(bit, std::memory_order_relaxed);
+			ASSERT((prev & bit) == 0);
+			#endif
+		} else {
+			SDL_Delay(0);
+		}
+	}
+	return 0;
+}
+
+static void benchMPMCQueueThreaded(BenchState* state)
+{
+	ASSERT(state->arg <= MPMC_MAX_THREADS);
+	MPMCQueue<int64_t> queue(1024);
+	MPMCShared shared;
+	shared.queue = &queue;
+	shared.count = state->ops;
+	shared.nproducers = state->arg;
+	shared.consumed = 0;
+	#if DEBUG
+	auto nwords = (state->ops + 31) >> 5;
+	shared.seen = (std::atomic<uint32_t>*) lpMalloc(nwords * sizeof(std::atomic<uint32_t>));
+	for(int64_t i=0; i<nwords; ++i) {
+		new(&shared.seen[i]) std::atomic<uint32_t>(0);
+	}
+	#endif
+
+	MPMCWorker producers[MPMC_MAX_THREADS];
+	MPMCWorker consumers[MPMC_MAX_THREADS];
+	SDL_Thread* threads[2 * MPMC_MAX_THREADS];
+	state->start();
+	for(int i=0; i<state->arg; ++i) {
+		producers[i].shared = consumers[i].shared = &shared;
+		producers[i].index = consumers[i].index = i;
+		producers[i].sum = consumers[i].sum = 0;
+		threads[2*i] = SDL_CreateThread(produceMPMC, "producer", &producers[i]);
+		threads[2*i+1] = SDL_CreateThread(consumeMPMC, "consumer", &consumers[i]);
+	}
+	for(int i=0; i<2*state->arg; ++i) {
+		SDL_WaitThread(threads[i], 0);
+	}
+	state->stop();
+
+	int64_t sum = 0;
+	for(int i=0; i<state->arg; ++i) {
+		sum += consumers[i].sum;
+	}
+	#if DEBUG
+	ASSERT(shared.consumed == state->ops);
+	for(int64_t i=0; i<state->ops; ++i) {
+		ASSERT(shared.seen[i >> 5].load(std::memory_order_relaxed) & (1u << (i & 31)));
+	}
+	lpFree(shared.seen);
+	#endif
+	benchKeep(sum);
+}
+BENCHMARK_ARG("queue/MPMCQueue_threaded_2x2", benchMPMCQueueThreaded, 2);
+BENCHMARK_ARG("queue/MPMCQueue_threaded_4x4", benchMPMCQueueThreaded, 4);
+
+//--------------------------------------------------------------------------------
+// ASSET LOOKUP
+// findHeader() over a synthetic bundle of 1024 palettes, written out in the
+// same format as the asset compiler's (headers, data, pointer fixups).
+
+#define BUNDLE_ASSETS 1024
+#define BUNDLE_PATH   "lpbench.assets"
+
+struct BundleHeader {
+	uint32_t hash, type;
+	void* data;
+};
+
+static void writeBundle(const char* path, uint32_t* outHashes)
+{
+	// palettes are a count followed by one color
+	const size_t kPaletteSize = sizeof(int32_t) + sizeof(Color);
+	const size_t headerBytes = BUNDLE_ASSETS * sizeof(BundleHeader);
+	const size_t length = headerBytes + BUNDLE_ASSETS * kPaletteSize;
+	auto blob = (uint8_t*) lpCalloc(1, length);
+	auto headers = (BundleHeader*) blob;
+
+	// headers must be sorted on their hash
+	srand(2);
+	uint32_t hash = 0;
+	for(int i=0; i<BUNDLE_ASSETS; ++i) {
+		hash += 2 + (rand() & 0xffff);
+		outHashes[i] = hash;
+		headers[i].hash = hash;
+		headers[i].type = ASSET_TYPE_PALETTE;
+		headers[i].data = (void*) (uintptr_t) (headerBytes + i * kPaletteSize);
+		*(int32_t*)(blob + headerBytes + i * kPaletteSize) = 1;
+	}
+
+	auto file = fopen(path, "wb");
+	ASSERT(file);
+	int32_t prefix[3] = { int32_t(8 * sizeof(void*)), int32_t(length), BUNDLE_ASSETS };
+	fwrite(prefix, sizeof(prefix), 1, file);
+	fwrite(blob, length, 1, file);
+	for(int i=0; i<BUNDLE_ASSETS; ++i) {
+		uint32_t fixup = uint32_t((uint8_t*)&headers[i].data - blob);
+		fwrite(&fixup, sizeof(fixup), 1, file);
+	}
+	fclose(file);
+	lpFree(blob);
+}
+
+static void benchFindHeader(BenchState* state)
+{
+	static uint32_t hashes[BUNDLE_ASSETS];
+	writeBundle(BUNDLE_PATH, hashes);
+	AssetBundle bundle(BUNDLE_PATH);
+	remove(BUNDLE_PATH);
+
+	uint32_t sum = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		sum += bundle.palette(hashes[scatter(i, BUNDLE_ASSETS)])->count;
+	}
+	state->stop();
+	ASSERT(sum == state->ops);
+	benchKeep(sum);
+}
+BENCHMARK("assets/findHeader_hit", benchFindHeader);
+
+static void benchFindHeaderMiss(BenchState* state)
+{
+	static uint32_t hashes[BUNDLE_ASSETS];
+	writeBundle(BUNDLE_PATH, hashes);
+	AssetBundle bundle(BUNDLE_PATH);
+	remove(BUNDLE_PATH);
+
+	int misses = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		misses += bundle.palette(hashes[scatter(i, BUNDLE_ASSETS)] + 1) == 0;
+	}
+	state->stop();
+	benchKeep(misses);
+}
+BENCHMARK("assets/findHeader_miss", benchFindHeaderMiss);
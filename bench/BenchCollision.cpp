@@ -0,0 +1,412 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Bench.h"
+#include "littlepolygon/collision.h"
+
+//--------------------------------------------------------------------------------
+// BROADPHASE
+// Bodies of 8-24 units drift around a square world which is scaled with the
+// body count, so that density (about one overlap per body) stays the same.  One
+// op is one frame: every body moves, its box is updated, and all overlapping
+// pairs are found.
+
+struct BenchBodies {
+	int count;
+	lpFloat worldSize;
+	lpVec* position;
+	lpVec* velocity;
+	lpVec* halfSize;
+	lpVec* lo;
+	lpVec* hi;
+	int* ids;
+	BroadphasePair* pairs;
+	int maxPairs;
+
+	BenchBodies(int n) : count(n), worldSize(48.0f * lpSqrt((lpFloat) n)), maxPairs(8 * n) {
+		position = (lpVec*) lpMalloc(5 * n * sizeof(lpVec));
+		velocity = position + n;
+		halfSize = velocity + n;
+		lo = halfSize + n;
+		hi = lo + n;
+		ids = (int*) lpMalloc(n * sizeof(int));
+		pairs = (BroadphasePair*) lpMalloc(maxPairs * sizeof(BroadphasePair));
+		for(int i=0; i<n; ++i) {
+			auto bits = (uint32_t) (i * 2654435761u);
+			position[i] = vec(worldSize * (bits & 0xffff) / 65536.0f, worldSize * (bits >> 16) / 65536.0f);
+			velocity[i] = 60.0f * unitVector(0.001f * (bits % 6283));
+			halfSize[i] = vec(4.0f + (bits & 7), 4.0f + ((bits >> 3) & 7));
+		}
+		refreshBounds();
+	}
+
+	~BenchBodies() {
+		lpFree(position);
+		lpFree(ids);
+		lpFree(pairs);
+	}
+
+	void step(lpFloat dt) {
+		for(int i=0; i<count; ++i) {
+			auto p = position[i] + dt * velocity[i];
+			if (p.x < 0 || p.x > worldSize) { velocity[i].x = -velocity[i].x; }
+			if (p.y < 0 || p.y > worldSize) { velocity[i].y = -velocity[i].y; }
+			position[i] = p;
+		}
+		refreshBounds();
+	}
+
+	void refreshBounds() {
+		for(int i=0; i<count; ++i) {
+			lo[i] = position[i] - halfSize[i];
+			hi[i] = position[i] + halfSize[i];
+		}
+	}
+
+	int findPairsPairwise() {
+		// what Entity::overlaps() costs when every pair is checked
+		int total = 0;
+		for(int i=0; i<count; ++i)
+		for(int j=i+1; j<count; ++j) {
+			if (lo[j].x < hi[i].x && lo[i].x < hi[j].x && lo[j].y < hi[i].y && lo[i].y < hi[j].y) {
+				if (total < maxPairs) {
+					pairs[total].a = i;
+					pairs[total].b = j;
+				}
+				++total;
+			}
+		}
+		return total;
+	}
+};
+
+static void benchBroadphaseFrame(BenchState* state)
+{
+	BenchBodies bodies(state->arg);
+	Broadphase broadphase(state->arg);
+	broadphase.create(bodies.count, bodies.lo, bodies.hi, 0, bodies.ids);
+	broadphase.findPairs(bodies.pairs, bodies.maxPairs);
+
+	#if DEBUG
+	if (bodies.count <= 10000) {
+		auto expected = bodies.findPairsPairwise();
+		ASSERT(broadphase.findPairs(bodies.pairs, bodies.maxPairs) == expected);
+	}
+	#endif
+
+	int total = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		bodies.step(1.0f / 60.0f);
+		broadphase.update(bodies.count, bodies.ids, bodies.lo, bodies.hi);
+		total += broadphase.findPairs(bodies.pairs, bodies.maxPairs);
+	}
+	state->stop();
+	ASSERT(total <= state->ops * bodies.maxPairs);
+	benchKeep(total);
+}
+BENCHMARK_ARG("broadphase/sweep_and_prune_1k", benchBroadphaseFrame, 1000);
+BENCHMARK_ARG("broadphase/sweep_and_prune_10k", benchBroadphaseFrame, 10000);
+BENCHMARK_ARG("broadphase/sweep_and_prune_100k", benchBroadphaseFrame, 100000);
+
+static void benchPairwiseFrame(BenchState* state)
+{
+	BenchBodies bodies(state->arg);
+
+	int total = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		bodies.step(1.0f / 60.0f);
+		total += bodies.findPairsPairwise();
+	}
+	state->stop();
+	benchKeep(total);
+}
+BENCHMARK_ARG("broadphase/pairwise_1k", benchPairwiseFrame, 1000);
+BENCHMARK_ARG("broadphase/pairwise_10k", benchPairwiseFrame, 10000);
+
+static void benchBroadphaseQuery(BenchState* state)
+{
+	// one op is one view-sized query against 100k resting bodies
+	BenchBodies bodies(100000);
+	Broadphase broadphase(bodies.count);
+	broadphase.create(bodies.count, bodies.lo, bodies.hi, 0, bodies.ids);
+	int results[1024];
+	broadphase.query(vec(0, 0), vec(0, 0), results, arraysize(results));
+
+	int total = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		auto p = bodies.position[(i * 7919) % bodies.count];
+		total += broadphase.query(p - vec(64, 48), p + vec(64, 48), results, arraysize(results));
+	}
+	state->stop();
+	benchKeep(total);
+}
+BENCHMARK("broadphase/query_100k", benchBroadphaseQuery);
+
+//--------------------------------------------------------------------------------
+// TILE MASK
+// DemoTileMask is the demo game's byte-packed mask, which tested one cell at a
+// time, kept as the baseline.  The level is 512x256 cells of open space, with
+// broken platforms every 16 rows and a scattering of loose blocks.  One op is 1024 queries, by boxes the size of the demo's hero
+// (about one cell), or by wide boxes like a fast body's swept bounds.
+
+struct DemoTileMask {
+	int mWidth, mHeight;
+	uint8_t* bytes;
+
+	DemoTileMask(int w, int h, const uint8_t* bits) : mWidth(w), mHeight(h) {
+		int nbytes = (w * h + 7) >> 3;
+		bytes = (uint8_t*) lpMalloc(nbytes);
+		memcpy(bytes, bits, nbytes);
+	}
+
+	~DemoTileMask() {
+		lpFree(bytes);
+	}
+
+	bool get(int x, int y) const {
+		return x < 0 || x >= mWidth || (y >= 0 && y < mHeight && rawGet(x,y));
+	}
+
+	bool rawGet(int x, int y) const {
+		int index = x + mWidth * y;
+		int byteIdx = index >> 3;
+		int localIdx = index - (byteIdx << 3);
+		return bytes[byteIdx] & (1<<localIdx);
+	}
+
+	bool check(lpVec topLeft, lpVec bottomRight) const {
+		int left = floorToInt(topLeft.x);
+		int right = floorToInt(bottomRight.x);
+		int bottom = floorToInt(bottomRight.y);
+		int top = floorToInt(topLeft.y);
+		for(int y=top; y<=bottom; ++y)
+		for(int x=left; x<=right; ++x) {
+			if (get(x,y)) { return true; }
+		}
+		return false;
+	}
+
+	bool checkRight(lpVec topLeft, lpVec bottomRight, float *outResult) const {
+		int left = floorToInt(topLeft.x);
+		int right = floorToInt(bottomRight.x);
+		int bottom = floorToInt(bottomRight.y);
+		int top = floorToInt(topLeft.y);
+		for(int x=right; x>=left; --x)
+		for(int y=top; y<=bottom; ++y) {
+			if (get(x,y)) {
+				*outResult = x - bottomRight.x - 0.0001f;
+				return true;
+			}
+		}
+		*outResult = 0.0f;
+		return false;
+	}
+
+	bool checkBottom(lpVec topLeft, lpVec bottomRight, float *outResult) const {
+		int left = floorToInt(topLeft.x);
+		int right = floorToInt(bottomRight.x);
+		int bottom = floorToInt(bottomRight.y);
+		int top = floorToInt(topLeft.y);
+		for(int y=top; y<=bottom; ++y)
+		for(int x=left; x<=right; ++x) {
+			if (get(x,y)) {
+				*outResult = y - bottomRight.y - 0.0001f;
+				return true;
+			}
+		}
+		*outResult = 0.0f;
+		return false;
+	}
+};
+
+struct BenchLevel {
+	enum { WIDTH = 512, HEIGHT = 256, QUERIES = 1024 };
+
+	uint8_t bits[WIDTH * HEIGHT / 8];
+	lpVec lo[QUERIES];
+	lpVec hi[QUERIES];
+	lpVec displacement[QUERIES];
+
+	BenchLevel(lpVec boxSize) {
+		memset(bits, 0, sizeof(bits));
+		for(int i=0; i<WIDTH * HEIGHT; ++i) {
+			int x = i % WIDTH;
+			int y = i / WIDTH;
+			if ((y % 16 == 15 && (x / 8) % 3 != 0) || (uint32_t)(i * 2654435761u) % 100 == 0) {
+				bits[i >> 3] |= 1 << (i & 7);
+			}
+		}
+		for(int i=0; i<QUERIES; ++i) {
+			auto hash = (uint32_t)(i * 2246822519u);
+			auto p = vec(-4.0f + (WIDTH + 8) * (hash & 0xffff) / 65536.0f, -4.0f + (HEIGHT + 8) * (hash >> 16) / 65536.0f);
+			lo[i] = p;
+			hi[i] = p + boxSize;
+			displacement[i] = 12.0f * unitVector(0.001f * (hash % 6283));
+		}
+	}
+};
+
+static void benchTileMaskCheck(BenchState* state)
+{
+	BenchLevel level(state->arg ? vec(24, 3) : vec(0.5f, 0.8f));
+	TileMask mask(BenchLevel::WIDTH, BenchLevel::HEIGHT, level.bits);
+
+	#if DEBUG
+	DemoTileMask demo(BenchLevel::WIDTH, BenchLevel::HEIGHT, level.bits);
+	for(int i=0; i<BenchLevel::QUERIES; ++i) {
+		auto lo = level.lo[i];
+		auto hi = level.hi[i] + level.displacement[i];
+		ASSERT(mask.check(lo, hi) == demo.check(lo, hi));
+		float expected, result;
+		ASSERT(mask.checkRight(lo, hi, &result, 0.0001f) == demo.checkRight(lo, hi, &expected) && result == expected);
+		ASSERT(mask.checkBottom(lo, hi, &result, 0.0001f) == demo.checkBottom(lo, hi, &expected) && result == expected);
+	}
+	#endif
+
+	int total = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i)
+	for(int j=0; j<BenchLevel::QUERIES; ++j) {
+		total += mask.check(level.lo[j], level.hi[j]);
+	}
+	state->stop();
+	benchKeep(total);
+}
+BENCHMARK_ARG("tilemask/check", benchTileMaskCheck, 0);
+BENCHMARK_ARG("tilemask/check_wide", benchTileMaskCheck, 1);
+
+static void benchDemoTileMaskCheck(BenchState* state)
+{
+	BenchLevel level(state->arg ? vec(24, 3) : vec(0.5f, 0.8f));
+	DemoTileMask demo(BenchLevel::WIDTH, BenchLevel::HEIGHT, level.bits);
+
+	int total = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i)
+	for(int j=0; j<BenchLevel::QUERIES; ++j) {
+		total += demo.check(level.lo[j], level.hi[j]);
+	}
+	state->stop();
+	benchKeep(total);
+}
+BENCHMARK_ARG("tilemask/check_demo", benchDemoTileMaskCheck, 0);
+BENCHMARK_ARG("tilemask/check_wide_demo", benchDemoTileMaskCheck, 1);
+
+static void benchTileMaskCheckRight(BenchState* state)
+{
+	// a hero-sized box stretched over a fast step to the right
+	BenchLevel level(vec(0.5f, 0.8f));
+	TileMask mask(BenchLevel::WIDTH, BenchLevel::HEIGHT, level.bits);
+
+	float total = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i)
+	for(int j=0; j<BenchLevel::QUERIES; ++j) {
+		float dx;
+		mask.checkRight(level.lo[j], level.hi[j] + vec(12, 0), &dx, 0.0001f);
+		total += dx;
+	}
+	state->stop();
+	benchKeep(total);
+}
+BENCHMARK("tilemask/checkRight", benchTileMaskCheckRight);
+
+static void benchDemoTileMaskCheckRight(BenchState* state)
+{
+	BenchLevel level(vec(0.5f, 0.8f));
+	DemoTileMask demo(BenchLevel::WIDTH, BenchLevel::HEIGHT, level.bits);
+
+	float total = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i)
+	for(int j=0; j<BenchLevel::QUERIES; ++j) {
+		float dx;
+		demo.checkRight(level.lo[j], level.hi[j] + vec(12, 0), &dx);
+		total += dx;
+	}
+	state->stop();
+	benchKeep(total);
+}
+BENCHMARK("tilemask/checkRight_demo", benchDemoTileMaskCheckRight);
+
+#if DEBUG
+static lpFloat sweepExhaustive(const TileMask& mask, lpVec lo, lpVec hi, lpVec d)
+{
+	// slab test against every cell in the swept bounds
+	auto slo = vec(MIN(lo.x, lo.x + d.x), MIN(lo.y, lo.y + d.y));
+	auto shi = vec(MAX(hi.x, hi.x + d.x), MAX(hi.y, hi.y + d.y));
+	lpFloat best = 1;
+	for(int y=floorToInt(slo.y); y<=floorToInt(shi.y); ++y)
+	for(int x=floorToInt(slo.x); x<=floorToInt(shi.x); ++x) {
+		if (!mask.get(x, y)) {
+			continue;
+		}
+		lpFloat t0 = 0;
+		lpFloat t1 = 1;
+		lpFloat cellLo[2] = { (lpFloat) x, (lpFloat) y };
+		lpFloat boxLo[2] = { lo.x, lo.y };
+		lpFloat boxHi[2] = { hi.x, hi.y };
+		lpFloat dir[2] = { d.x, d.y };
+		for(int axis=0; axis<2; ++axis) {
+			if (dir[axis] == 0) {
+				if (!(boxLo[axis] < cellLo[axis] + 1 && cellLo[axis] < boxHi[axis])) {
+					t1 = -1;
+				}
+			} else {
+				auto enter = (dir[axis] > 0 ? cellLo[axis] - boxHi[axis] : cellLo[axis] + 1 - boxLo[axis]) / dir[axis];
+				auto exit = (dir[axis] > 0 ? cellLo[axis] + 1 - boxLo[axis] : cellLo[axis] - boxHi[axis]) / dir[axis];
+				t0 = MAX(t0, enter);
+				t1 = MIN(t1, exit);
+			}
+		}
+		if (t0 < t1) {
+			best = MIN(best, t0);
+		}
+	}
+	return best;
+}
+#endif
+
+static void benchTileMaskSweep(BenchState* state)
+{
+	BenchLevel level(vec(0.5f, 0.8f));
+	TileMask mask(BenchLevel::WIDTH, BenchLevel::HEIGHT, level.bits);
+
+	#if DEBUG
+	for(int i=0; i<BenchLevel::QUERIES; ++i) {
+		lpFloat t;
+		auto hit = mask.sweep(level.lo[i], level.hi[i], level.displacement[i], &t);
+		auto expected = sweepExhaustive(mask, level.lo[i], level.hi[i], level.displacement[i]);
+		ASSERT(hit == (expected < 1));
+		ASSERT(lpAbs(t - expected) < 0.0001f);
+	}
+	#endif
+
+	lpFloat total = 0;
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i)
+	for(int j=0; j<BenchLevel::QUERIES; ++j) {
+		lpFloat t;
+		mask.sweep(level.lo[j], level.hi[j], level.displacement[j], &t);
+		total += t;
+	}
+	state->stop();
+	benchKeep(total);
+}
+BENCHMARK("tilemask/sweep", benchTileMaskSweep);
@@ -0,0 +1,336 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Bench.h"
+#include "littlepolygon/events.h"
+#include "littlepolygon/pools.h"
+#include "littlepolygon/jobs.h"
+#include "littlepolygon/particles.h"
+#include "littlepolygon/profiler.h"
+#include "SimplexNoise.h"
+
+//--------------------------------------------------------------------------------
+// TIMERS
+// Timers are measured with 100k pending at scattered deadlines over ~16
+// seconds, so that every level of the wheel is populated.
+
+#define TIMER_COUNT 100000
+
+static int64_t timersFired;
+
+struct BenchTimer {
+	TimerCallback callback;
+	TimerQueue* queue;
+
+	BenchTimer(TimerQueue* aQueue) :
+		callback(Action<>::callMethod<BenchTimer, &BenchTimer::onFire>(this)),
+		queue(aQueue) {}
+
+	void onFire() {
+		// re-arm, so the population stays constant
+		++timersFired;
+		queue->enqueue(&callback, deadline(timersFired));
+	}
+
+	lpFloat deadline(int64_t salt) const {
+		auto bits = (uint32_t) ((uintptr_t(this) >> 4) * 2654435761u + salt * 40503u);
+		return 16.0f * (bits >> 8) * (1.0f / float(1<<24));
+	}
+};
+
+static void benchTimerEnqueueCancel(BenchState* state)
+{
+	TimerQueue queue;
+	Pool<BenchTimer> timers(TIMER_COUNT);
+	BenchTimer* live[1024];
+	for(int i=0; i<TIMER_COUNT; ++i) {
+		auto t = timers.alloc(&queue);
+		queue.enqueue(&t->callback, t->deadline(i));
+		if (i < 1024) { live[i] = t; }
+	}
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		auto t = live[i & 1023];
+		t->callback.unbind();
+		queue.enqueue(&t->callback, t->deadline(i));
+	}
+	state->stop();
+}
+BENCHMARK("timers/enqueue_cancel_100k", benchTimerEnqueueCancel);
+
+static void benchTimerTickFire(BenchState* state)
+{
+	// one op is one timer fired (and re-armed); the frame loop runs until
+	// enough have gone off
+	TimerQueue queue;
+	Pool<BenchTimer> timers(TIMER_COUNT);
+	for(int i=0; i<TIMER_COUNT; ++i) {
+		auto t = timers.alloc(&queue);
+		queue.enqueue(&t->callback, t->deadline(i));
+	}
+
+	timersFired = 0;
+	state->start();
+	while(timersFired < state->ops) {
+		queue.tick(1.0f / 60.0f);
+	}
+	state->stop();
+	// (the last frame usually fires a few more than we asked for)
+	state->ops = timersFired;
+}
+BENCHMARK("timers/tick_fire_100k", benchTimerTickFire);
+
+static void benchTimerTickIdle(BenchState* state)
+{
+	// the per-frame cost when nothing is due
+	TimerQueue queue;
+	Pool<BenchTimer> timers(1024);
+	for(int i=0; i<1024; ++i) {
+		auto t = timers.alloc(&queue);
+		queue.enqueue(&t->callback, 1e6f + i);
+	}
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		queue.tick(1.0f / 60.0f);
+	}
+	state->stop();
+}
+BENCHMARK("timers/tick_idle", benchTimerTickIdle);
+
+//--------------------------------------------------------------------------------
+// DISPATCHERS
+// One op is a single emit() to 64 listeners.
+
+#define LISTENER_COUNT 64
+
+struct BenchListener {
+	EventCallback<int> callback;
+	int64_t sum;
+
+	BenchListener() :
+		callback(EventCallback<int>::Delegate::callMethod<BenchListener, &BenchListener::onEvent>(this)),
+		sum(0) {}
+
+	void onEvent(int value) { sum += value; }
+};
+
+static void benchEventDispatcherEmit(BenchState* state)
+{
+	EventDispatcher<int> dispatcher;
+	BenchListener listeners[LISTENER_COUNT];
+	for(int i=0; i<LISTENER_COUNT; ++i) { dispatcher.bind(&listeners[i].callback); }
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		dispatcher.emit((int) i);
+	}
+	state->stop();
+	benchKeep(listeners[0].sum);
+}
+BENCHMARK("events/EventDispatcher_emit_64", benchEventDispatcherEmit);
+
+static void benchArrayDispatcherEmit(BenchState* state)
+{
+	ArrayDispatcher<int> dispatcher(LISTENER_COUNT);
+	BenchListener listeners[LISTENER_COUNT];
+	for(int i=0; i<LISTENER_COUNT; ++i) { dispatcher.bind(listeners[i].callback.callback); }
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		dispatcher.emit((int) i);
+	}
+	state->stop();
+	benchKeep(listeners[0].sum);
+}
+BENCHMARK("events/ArrayDispatcher_emit_64", benchArrayDispatcherEmit);
+
+struct BenchEventSink {
+	int64_t sum;
+
+	void onEvents(const int* events, int count) {
+		for(int i=0; i<count; ++i) { sum += events[i]; }
+	}
+};
+
+static void benchEventQueuePostFlush(BenchState* state)
+{
+	// one op is one event posted, flushing every 256 (i.e. a busy frame)
+	EventQueue<int> queue(256);
+	BenchEventSink sinks[4] = {};
+	for(int i=0; i<4; ++i) {
+		queue.bind(EventQueue<int>::Handler::callMethod<BenchEventSink, &BenchEventSink::onEvents>(&sinks[i]));
+	}
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		queue.post((int) i);
+		if ((i & 255) == 255) {
+			queue.flush();
+		}
+	}
+	queue.flush();
+	state->stop();
+	benchKeep(sinks[0].sum);
+}
+BENCHMARK("events/EventQueue_post_flush", benchEventQueuePostFlush);
+
+//--------------------------------------------------------------------------------
+// JOBS
+// One op is one element of a parallelFor over 64k elements, registered once
+// per worker count to show scaling.  Besides a synthetic kernel, the elements
+// are particles being integrated (the per-particle half of ParticleSystem::tick
+// -- compacting out the dead ones stays serial) and samples of a four-octave
+// simplex noise field, 256 to a row.
+
+#define JOB_ELEMENTS 65536
+
+static float jobInput[JOB_ELEMENTS];
+static float jobOutput[JOB_ELEMENTS];
+
+static void jobKernel(void*, int begin, int end)
+{
+	for(int i=begin; i<end; ++i) {
+		auto x = jobInput[i];
+		jobOutput[i] = x * (x * (x * 0.25f + 0.5f) + 1.0f);
+	}
+}
+
+static void benchJobParallelFor(BenchState* state)
+{
+	JobSystem jobs(state->arg);
+	for(int i=0; i<JOB_ELEMENTS; ++i) { jobInput[i] = float(i) / JOB_ELEMENTS; }
+
+	state->roundUpOps(JOB_ELEMENTS);
+	state->start();
+	for(int64_t done=0; done<state->ops; done+=JOB_ELEMENTS) {
+		JobCounter counter;
+		jobs.parallelFor(JOB_ELEMENTS, 0, jobKernel, 0, &counter);
+		jobs.wait(&counter);
+	}
+	state->stop();
+	benchKeep(jobOutput[JOB_ELEMENTS-1]);
+}
+BENCHMARK_ARG("jobs/parallelFor_64k/1", benchJobParallelFor, 1);
+BENCHMARK_ARG("jobs/parallelFor_64k/2", benchJobParallelFor, 2);
+BENCHMARK_ARG("jobs/parallelFor_64k/4", benchJobParallelFor, 4);
+
+struct JobParticles {
+	ParticleSystem* system;
+	Particle* particles;
+};
+
+static void jobParticleKernel(void* context, int begin, int end)
+{
+	auto job = (JobParticles*) context;
+	for(int i=begin; i<end; ++i) {
+		job->particles[i].tick(job->system, 1.0f / 60.0f);
+	}
+}
+
+static void benchJobParticles(BenchState* state)
+{
+	// (the particles never expire, so every step does the same work)
+	JobSystem jobs(state->arg);
+	ParticleSystem system(vec(0, 200));
+	JobParticles job = { &system, (Particle*) lpMalloc(JOB_ELEMENTS * sizeof(Particle)) };
+	for(int i=0; i<JOB_ELEMENTS; ++i) {
+		new(&job.particles[i]) Particle(0.0f, 1e9f, vec(i & 255, i >> 8), vec(i & 15, 0), rgba(0xffffffff), rgba(0xffffff00));
+	}
+
+	state->roundUpOps(JOB_ELEMENTS);
+	state->start();
+	for(int64_t done=0; done<state->ops; done+=JOB_ELEMENTS) {
+		JobCounter counter;
+		jobs.parallelFor(JOB_ELEMENTS, 1024, jobParticleKernel, &job, &counter);
+		jobs.wait(&counter);
+	}
+	state->stop();
+	benchKeep(job.particles[JOB_ELEMENTS-1].position());
+	lpFree(job.particles);
+}
+BENCHMARK_ARG("jobs/particles_64k/1", benchJobParticles, 1);
+BENCHMARK_ARG("jobs/particles_64k/2", benchJobParticles, 2);
+BENCHMARK_ARG("jobs/particles_64k/4", benchJobParticles, 4);
+
+#define NOISE_ROW 256
+
+static void jobNoiseKernel(void*, int begin, int end)
+{
+	// one job per row
+	for(int row=begin; row<end; ++row) {
+		auto out = jobOutput + row * NOISE_ROW;
+		for(int i=0; i<NOISE_ROW; ++i) {
+			out[i] = SimplexNoise::octave(4, float(i), float(row), 0.5f, 0.01f, 0.0f, 1.0f);
+		}
+	}
+}
+
+static void benchJobNoise(BenchState* state)
+{
+	JobSystem jobs(state->arg);
+
+	state->roundUpOps(JOB_ELEMENTS);
+	state->start();
+	for(int64_t done=0; done<state->ops; done+=JOB_ELEMENTS) {
+		JobCounter counter;
+		jobs.parallelFor(JOB_ELEMENTS / NOISE_ROW, 1, jobNoiseKernel, 0, &counter);
+		jobs.wait(&counter);
+	}
+	state->stop();
+	benchKeep(jobOutput[JOB_ELEMENTS-1]);
+}
+BENCHMARK_ARG("jobs/noise_64k/1", benchJobNoise, 1);
+BENCHMARK_ARG("jobs/noise_64k/2", benchJobNoise, 2);
+BENCHMARK_ARG("jobs/noise_64k/4", benchJobNoise, 4);
+
+static void benchJobRunWait(BenchState* state)
+{
+	// the overhead of a single tiny job round-trip
+	JobSystem jobs(state->arg);
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		JobCounter counter;
+		jobs.run(jobKernel, 0, &counter, 0, 0, 1);
+		jobs.wait(&counter);
+	}
+	state->stop();
+}
+BENCHMARK_ARG("jobs/run_wait/1", benchJobRunWait, 1);
+BENCHMARK_ARG("jobs/run_wait/4", benchJobRunWait, 4);
+
+//--------------------------------------------------------------------------------
+// PROFILER
+// One op is one CPU zone opened and closed, i.e. the cost LP_PROFILER adds to
+// every instrumented scope (arg 0 is with recording paused).
+
+static void benchProfileZone(BenchState* state)
+{
+	lpSetProfilerEnabled(state->arg != 0);
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		ProfileZone zone("bench");
+	}
+	state->stop();
+
+	lpSetProfilerEnabled(true);
+	lpClearProfiler();
+}
+BENCHMARK_ARG("profiler/zone", benchProfileZone, 1);
+BENCHMARK_ARG("profiler/zone_paused", benchProfileZone, 0);
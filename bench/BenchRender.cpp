@@ -0,0 +1,546 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Bench.h"
+#include "littlepolygon/sprites.h"
+#include "littlepolygon/simd.h"
+#include "littlepolygon/fastmath.h"
+
+//--------------------------------------------------------------------------------
+// SYNTHETIC ASSETS
+// Textures are given a nonzero handle up front, so they never try to
+// decompress any pixels, and the tilemap is handed its decompressed tiles.
+
+#define VIEW_W 1024
+#define VIEW_H 768
+
+static TextureAsset atlas = { 0, 1024, 1024, 0, 1, 0 };
+
+static FrameAsset frame = {
+	vec(0.0f, 0.0f), vec(0.0f, 0.03125f), vec(0.03125f, 0.0f), vec(0.03125f, 0.03125f),
+	vec(16.0f, 16.0f), vec(32.0f, 32.0f)
+};
+
+static ImageAsset image = { &atlas, &frame, vec(32.0f, 32.0f), vec(16.0f, 16.0f), 1 };
+
+ImageAsset* benchImage()
+{
+	return &image;
+}
+
+static TilemapAsset* benchTilemap()
+{
+	// 256x256 16px tiles, with every fourth tile left empty
+	static TileAsset tiles[256 * 256];
+	static TilemapAsset map;
+	if (!map.data) {
+		for(int i=0; i<256*256; ++i) {
+			tiles[i].x = (i & 3) == 3 ? 0xff : i & 63;
+			tiles[i].y = (i >> 6) & 63;
+		}
+		map.data = tiles;
+		map.tw = map.th = 16;
+		map.mw = map.mh = 256;
+		map.tileAtlas = atlas;
+	}
+	return &map;
+}
+
+static FontAsset* benchFont()
+{
+	static FontAsset font;
+	if (font.height == 0) {
+		font.height = 16;
+		for(int i=0; i<ASCII_END-ASCII_BEGIN; ++i) {
+			font.glyphs[i].x = 8 * (i & 15);
+			font.glyphs[i].y = 16 * (i >> 4);
+			font.glyphs[i].advance = 8;
+		}
+		font.texture = atlas;
+		font.texture.w = font.texture.h = 128;
+	}
+	return &font;
+}
+
+//--------------------------------------------------------------------------------
+// SPRITE PLOTTER
+// One op is one sprite (or tile, or glyph) plotted.  Draw calls and uploads go
+// to the null GL, so these measure vertex generation and batching only.
+
+static lpVec spritePosition(int64_t i)
+{
+	auto bits = (uint32_t) (i * 2654435761u);
+	return vec((lpFloat) (bits % VIEW_W), (lpFloat) ((bits >> 16) % VIEW_H));
+}
+
+static void benchSpriteDrawImage(BenchState* state)
+{
+	Plotter plotter(4096);
+	SpritePlotter sprites(&plotter);
+	benchRenderBackend().resetStats();
+
+	state->start();
+	sprites.begin(Viewport(VIEW_W, VIEW_H));
+	for(int64_t i=0; i<state->ops; ++i) {
+		sprites.drawImage(&image, spritePosition(i));
+	}
+	sprites.end();
+	state->stop();
+	ASSERT(benchRenderBackend().stats().drawCalls == sprites.stats().batches);
+	ASSERT(sprites.stats().draws + sprites.stats().culled == state->ops);
+}
+BENCHMARK("sprites/drawImage", benchSpriteDrawImage);
+
+static void benchSpriteDrawImageMatrix(BenchState* state)
+{
+	Plotter plotter(4096);
+	SpritePlotter sprites(&plotter);
+	auto xform = matAttitude(unitVector(0.3f));
+
+	state->start();
+	sprites.begin(Viewport(VIEW_W, VIEW_H));
+	for(int64_t i=0; i<state->ops; ++i) {
+		xform.t = spritePosition(i);
+		sprites.drawImage(&image, xform);
+	}
+	sprites.end();
+	state->stop();
+}
+BENCHMARK("sprites/drawImage_matrix", benchSpriteDrawImageMatrix);
+
+static void benchSpriteDrawImages(BenchState* state)
+{
+	// the bulk path, in batches of 64 (a large rig)
+	Plotter plotter(4096);
+	SpritePlotter sprites(&plotter);
+	ImageAsset* images[64];
+	lpMatrix xforms[64];
+	for(int i=0; i<64; ++i) {
+		images[i] = &image;
+		xforms[i] = matAttitude(unitVector(0.1f * i));
+		xforms[i].t = spritePosition(i);
+	}
+
+	state->roundUpOps(64);
+	state->start();
+	sprites.begin(Viewport(VIEW_W, VIEW_H));
+	for(int64_t i=0; i<state->ops; i+=64) {
+		sprites.drawImages(64, images, xforms);
+	}
+	sprites.end();
+	state->stop();
+}
+BENCHMARK("sprites/drawImages", benchSpriteDrawImages);
+
+static void benchSpriteDrawCulled(BenchState* state)
+{
+	// every sprite lands offscreen, so this is the cost of the OBB test
+	Plotter plotter(4096);
+	SpritePlotter sprites(&plotter);
+
+	state->start();
+	sprites.begin(Viewport(VIEW_W, VIEW_H));
+	for(int64_t i=0; i<state->ops; ++i) {
+		sprites.drawImage(&image, spritePosition(i) + vec(2 * VIEW_W, 0));
+	}
+	sprites.end();
+	state->stop();
+	ASSERT(sprites.stats().culled == state->ops && sprites.stats().batches == 0);
+}
+BENCHMARK("sprites/drawImage_culled", benchSpriteDrawCulled);
+
+static void benchSpriteDrawTilemap(BenchState* state)
+{
+	// one op is one visible tile; the whole screen is redrawn while scrolling
+	Plotter plotter(4096);
+	SpritePlotter sprites(&plotter);
+	auto map = benchTilemap();
+	const int64_t tilesPerScreen = (VIEW_W/16 + 1) * (VIEW_H/16 + 1) * 3 / 4;
+
+	state->roundUpOps(tilesPerScreen);
+	state->start();
+	sprites.begin(Viewport(VIEW_W, VIEW_H));
+	for(int64_t i=0; i<state->ops; i+=tilesPerScreen) {
+		sprites.drawTilemap(map, vec(-(lpFloat) (i & 1023), 0));
+	}
+	sprites.end();
+	state->stop();
+}
+BENCHMARK("sprites/drawTilemap", benchSpriteDrawTilemap);
+
+static void benchSpriteDrawLabel(BenchState* state)
+{
+	// one op is one glyph
+	static const char kMessage[] = "The quick brown fox jumps over the lazy dog 0123456789";
+	const int kLength = sizeof(kMessage) - 1;
+	Plotter plotter(4096);
+	SpritePlotter sprites(&plotter);
+	auto font = benchFont();
+
+	state->roundUpOps(kLength);
+	state->start();
+	sprites.begin(Viewport(VIEW_W, VIEW_H));
+	for(int64_t i=0; i<state->ops; i+=kLength) {
+		sprites.drawLabel(font, vec(8, 8), rgba(0), kMessage);
+	}
+	sprites.end();
+	state->stop();
+}
+BENCHMARK("sprites/drawLabel", benchSpriteDrawLabel);
+
+static void benchSpriteDrawStats(BenchState* state)
+{
+	// one op is one stats overlay (formatting plus ~100 glyphs)
+	Plotter plotter(4096);
+	SpritePlotter sprites(&plotter);
+	auto font = benchFont();
+
+	state->start();
+	sprites.begin(Viewport(VIEW_W, VIEW_H));
+	for(int64_t i=0; i<state->ops; ++i) {
+		auto frameStats = sprites.stats();
+		sprites.drawStats(font, vec(8, 8), rgba(0), frameStats);
+	}
+	sprites.end();
+	state->stop();
+}
+BENCHMARK("sprites/drawStats", benchSpriteDrawStats);
+
+static void benchLinePlot(BenchState* state)
+{
+	LinePlotter lines(4096);
+
+	state->start();
+	lines.begin(Viewport(VIEW_W, VIEW_H));
+	for(int64_t i=0; i<state->ops; ++i) {
+		auto p = spritePosition(i);
+		lines.plot(p, p + vec(16, 8), rgba(0xff0000ff));
+	}
+	lines.end();
+	state->stop();
+	ASSERT(lines.stats().draws == state->ops);
+}
+BENCHMARK("lines/plot", benchLinePlot);
+
+//--------------------------------------------------------------------------------
+// SPRITE GRID
+// 200k sprites scattered over a world 32x the size of the view in each
+// direction.  One op is one frame drawn (while the view scrolls), either by
+// clipping every sprite in the batch or by visiting the grid cells in view.
+
+#define WORLD_SPRITES 200000
+#define WORLD_SIZE    32768
+#define WORLD_CELL    256
+
+struct BenchWorld {
+	SpriteBatch batch;
+	SpriteGrid grid;
+	SpriteHandle handles[WORLD_SPRITES];
+
+	BenchWorld() :
+		batch(WORLD_SPRITES),
+		grid(&batch, vec(0, 0), vec(WORLD_CELL, WORLD_CELL), WORLD_SIZE / WORLD_CELL, WORLD_SIZE / WORLD_CELL) {
+		for(int i=0; i<WORLD_SPRITES; ++i) {
+			handles[i] = batch.alloc(&image, worldPosition(i));
+			grid.insert(handles[i]);
+		}
+	}
+
+	static lpVec worldPosition(int64_t i) {
+		auto bits = (uint32_t) (i * 2654435761u);
+		return vec((lpFloat) (bits % WORLD_SIZE), (lpFloat) ((bits >> 15) % WORLD_SIZE));
+	}
+};
+
+static BenchWorld* benchWorld()
+{
+	static BenchWorld* world = new(lpMalloc(sizeof(BenchWorld))) BenchWorld();
+	return world;
+}
+
+static Viewport worldView(int64_t frame)
+{
+	auto scroll = (lpFloat) ((frame * 8) % (WORLD_SIZE - 2 * VIEW_W));
+	return Viewport(vec(VIEW_W, VIEW_H), vec(VIEW_W + scroll, 0.5f * WORLD_SIZE));
+}
+
+static void benchWorldDrawClipped(BenchState* state)
+{
+	auto world = benchWorld();
+	Plotter plotter(4096);
+	SpritePlotter sprites(&plotter);
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		sprites.begin(worldView(i));
+		for(auto& sprite : world->batch) {
+			sprite.drawClipped(&sprites);
+		}
+		sprites.end();
+	}
+	state->stop();
+}
+BENCHMARK("sprites/world_200k_drawClipped", benchWorldDrawClipped);
+
+static void benchWorldDrawGrid(BenchState* state)
+{
+	auto world = benchWorld();
+	Plotter plotter(4096);
+	SpritePlotter sprites(&plotter);
+
+	#if DEBUG
+	// the grid has to find every sprite that clipping the whole batch does
+	for(int64_t i=0; i<64; ++i) {
+		sprites.begin(worldView(i * 97));
+		for(auto& sprite : world->batch) {
+			sprite.drawClipped(&sprites);
+		}
+		sprites.end();
+		auto clipped = sprites.stats().draws;
+		sprites.resetStats();
+		sprites.begin(worldView(i * 97));
+		world->grid.draw(&sprites);
+		sprites.end();
+		ASSERT(sprites.stats().draws == clipped);
+		sprites.resetStats();
+	}
+	#endif
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		sprites.begin(worldView(i));
+		world->grid.draw(&sprites);
+		sprites.end();
+	}
+	state->stop();
+}
+BENCHMARK("sprites/world_200k_SpriteGrid_draw", benchWorldDrawGrid);
+
+static void benchWorldGridUpdate(BenchState* state)
+{
+	// one op is one sprite moved and re-filed, mostly within its cell
+	auto world = benchWorld();
+
+	state->start();
+	for(int64_t i=0; i<state->ops; ++i) {
+		auto h = world->handles[(i * 7919) % WORLD_SPRITES];
+		auto p = h->position() + vec(4, 0);
+		h->setPosition(p.x < WORLD_SIZE ? p : vec(0, p.y));
+		world->grid.update(h);
+	}
+	state->stop();
+}
+BENCHMARK("sprites/world_200k_SpriteGrid_update", benchWorldGridUpdate);
+
+//--------------------------------------------------------------------------------
+// SIMD
+// One op is one element, comparing each bulk kernel against the equivalent
+// scalar loop over lpMatrix.
+
+#define SIMD_COUNT 1024
+
+static lpVec simdPoints[SIMD_COUNT];
+static lpVec simdResults[SIMD_COUNT];
+static lpMatrix simdMatrices[SIMD_COUNT];
+static lpMatrix simdMatrixResults[SIMD_COUNT];
+
+static void initSimdData()
+{
+	for(int i=0; i<SIMD_COUNT; ++i) {
+		simdPoints[i] = spritePosition(i);
+		simdMatrices[i] = matAttitude(unitVector(0.01f * i));
+		simdMatrices[i].t = simdPoints[i];
+	}
+}
+
+static void benchTransformPointsScalar(BenchState* state)
+{
+	initSimdData();
+	auto m = simdMatrices[7];
+	state->roundUpOps(SIMD_COUNT);
+	state->start();
+	for(int64_t i=0; i<state->ops; i+=SIMD_COUNT) {
+		for(int j=0; j<SIMD_COUNT; ++j) {
+			simdResults[j] = m.transformPoint(simdPoints[j]);
+		}
+		benchKeep(simdResults[0]);
+	}
+	state->stop();
+}
+BENCHMARK("simd/transformPoints_scalar", benchTransformPointsScalar);
+
+static void benchTransformPoints(BenchState* state)
+{
+	initSimdData();
+	auto m = simdMatrices[7];
+	state->roundUpOps(SIMD_COUNT);
+	state->start();
+	for(int64_t i=0; i<state->ops; i+=SIMD_COUNT) {
+		lpTransformPoints(m, simdPoints, simdResults, SIMD_COUNT);
+		benchKeep(simdResults[0]);
+	}
+	state->stop();
+}
+BENCHMARK("simd/transformPoints", benchTransformPoints);
+
+static void benchConcatMatricesScalar(BenchState* state)
+{
+	initSimdData();
+	state->roundUpOps(SIMD_COUNT);
+	state->start();
+	for(int64_t i=0; i<state->ops; i+=SIMD_COUNT) {
+		for(int j=0; j<SIMD_COUNT; ++j) {
+			simdMatrixResults[j] = simdMatrices[j] * simdMatrices[SIMD_COUNT-1-j];
+		}
+		benchKeep(simdMatrixResults[0]);
+	}
+	state->stop();
+}
+BENCHMARK("simd/concatMatrices_scalar", benchConcatMatricesScalar);
+
+static void benchConcatMatrices(BenchState* state)
+{
+	// (the rhs is a different permutation to the scalar version, which
+	// doesn't matter for timing)
+	initSimdData();
+	state->roundUpOps(SIMD_COUNT);
+	state->start();
+	for(int64_t i=0; i<state->ops; i+=SIMD_COUNT) {
+		lpConcatMatrices(simdMatrices, simdMatrices, simdMatrixResults, SIMD_COUNT);
+		benchKeep(simdMatrixResults[0]);
+	}
+	state->stop();
+}
+BENCHMARK("simd/concatMatrices", benchConcatMatrices);
+
+static void benchComputeAABB(BenchState* state)
+{
+	initSimdData();
+	lpVec lo, hi;
+	state->roundUpOps(SIMD_COUNT);
+	state->start();
+	for(int64_t i=0; i<state->ops; i+=SIMD_COUNT) {
+		lpComputeAABB(simdPoints, SIMD_COUNT, &lo, &hi);
+		benchKeep(lo);
+	}
+	state->stop();
+}
+BENCHMARK("simd/computeAABB", benchComputeAABB);
+
+//--------------------------------------------------------------------------------
+// FAST MATH
+// One op is one evaluation, through the batch entry points (at the default
+// precision) and through libm for reference.
+
+#define MATH_COUNT 1024
+
+static lpFloat mathInput[MATH_COUNT];
+static lpFloat mathInput2[MATH_COUNT];
+static lpFloat mathOutput[MATH_COUNT];
+static lpFloat mathOutput2[MATH_COUNT];
+
+static void initMathData()
+{
+	for(int i=0; i<MATH_COUNT; ++i) {
+		mathInput[i] = 0.01f + 10.0f * i / MATH_COUNT;
+		mathInput2[i] = lpFloat(i - MATH_COUNT/2) / MATH_COUNT;
+	}
+}
+
+static void benchSinCosLibm(BenchState* state)
+{
+	initMathData();
+	state->roundUpOps(MATH_COUNT);
+	state->start();
+	for(int64_t i=0; i<state->ops; i+=MATH_COUNT) {
+		for(int j=0; j<MATH_COUNT; ++j) {
+			mathOutput[j] = lpSin(mathInput[j]);
+			mathOutput2[j] = lpCos(mathInput[j]);
+		}
+		benchKeep(mathOutput[0]);
+	}
+	state->stop();
+}
+BENCHMARK("fastmath/sincos_libm", benchSinCosLibm);
+
+static void benchSinCos(BenchState* state)
+{
+	initMathData();
+	state->roundUpOps(MATH_COUNT);
+	state->start();
+	for(int64_t i=0; i<state->ops; i+=MATH_COUNT) {
+		fastSinCos(mathInput, mathOutput, mathOutput2, MATH_COUNT);
+		benchKeep(mathOutput[0]);
+	}
+	state->stop();
+}
+BENCHMARK("fastmath/sincos", benchSinCos);
+
+static void benchAtan2Libm(BenchState* state)
+{
+	initMathData();
+	state->roundUpOps(MATH_COUNT);
+	state->start();
+	for(int64_t i=0; i<state->ops; i+=MATH_COUNT) {
+		for(int j=0; j<MATH_COUNT; ++j) {
+			mathOutput[j] = lpAtan2(mathInput2[j], mathInput[j]);
+		}
+		benchKeep(mathOutput[0]);
+	}
+	state->stop();
+}
+BENCHMARK("fastmath/atan2_libm", benchAtan2Libm);
+
+static void benchAtan2(BenchState* state)
+{
+	initMathData();
+	state->roundUpOps(MATH_COUNT);
+	state->start();
+	for(int64_t i=0; i<state->ops; i+=MATH_COUNT) {
+		fastAtan2(mathInput2, mathInput, mathOutput, MATH_COUNT);
+		benchKeep(mathOutput[0]);
+	}
+	state->stop();
+}
+BENCHMARK("fastmath/atan2", benchAtan2);
+
+static void benchPowLibm(BenchState* state)
+{
+	initMathData();
+	state->roundUpOps(MATH_COUNT);
+	state->start();
+	for(int64_t i=0; i<state->ops; i+=MATH_COUNT) {
+		for(int j=0; j<MATH_COUNT; ++j) {
+			mathOutput[j] = (lpFloat) pow(mathInput[j], (lpFloat) 2.2f);
+		}
+		benchKeep(mathOutput[0]);
+	}
+	state->stop();
+}
+BENCHMARK("fastmath/pow_libm", benchPowLibm);
+
+static void benchPow(BenchState* state)
+{
+	initMathData();
+	state->roundUpOps(MATH_COUNT);
+	state->start();
+	for(int64_t i=0; i<state->ops; i+=MATH_COUNT) {
+		fastPow(mathInput, 2.2f, mathOutput, MATH_COUNT);
+		benchKeep(mathOutput[0]);
+	}
+	state->stop();
+}
+BENCHMARK("fastmath/pow", benchPow);
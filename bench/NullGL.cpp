@@ -0,0 +1,92 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Bench.h"
+
+// The bench installs a NullRenderBackend before anything is created, so the
+// library never actually calls into GL.  These definitions only satisfy the
+// linker in place of a GL driver and glew.o (for GLRenderBackend, which is
+// still the default): GL 1.1 entry points are exported directly by the driver,
+// and everything newer is called through GLEW's function pointers.
+
+//--------------------------------------------------------------------------------
+// GL 1.1
+
+void GLAPIENTRY glTexParameteri(GLenum, GLenum, GLint) {}
+void GLAPIENTRY glBindTexture(GLenum, GLuint) {}
+void GLAPIENTRY glTexImage2D(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, const GLvoid*) {}
+void GLAPIENTRY glGenTextures(GLsizei, GLuint*) {}
+void GLAPIENTRY glDeleteTextures(GLsizei, const GLuint*) {}
+void GLAPIENTRY glDrawElements(GLenum, GLsizei, GLenum, const GLvoid*) {}
+void GLAPIENTRY glDrawArrays(GLenum, GLint, GLsizei) {}
+
+//--------------------------------------------------------------------------------
+// GLEW
+
+static void GLAPIENTRY nullNames(GLsizei, GLuint*) {}
+static void GLAPIENTRY nullConstNames(GLsizei, const GLuint*) {}
+static void GLAPIENTRY nullBindName(GLenum, GLuint) {}
+static void GLAPIENTRY nullObject(GLuint) {}
+static void GLAPIENTRY nullVertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const GLvoid*) {}
+static void GLAPIENTRY nullBufferData(GLenum, GLsizeiptr, const GLvoid*, GLenum) {}
+static void GLAPIENTRY nullBufferSubData(GLenum, GLintptr, GLsizeiptr, const GLvoid*) {}
+static GLuint GLAPIENTRY nullCreateProgram() { return 0; }
+static GLuint GLAPIENTRY nullCreateShader(GLenum) { return 0; }
+static void GLAPIENTRY nullAttachShader(GLuint, GLuint) {}
+static void GLAPIENTRY nullShaderSource(GLuint, GLsizei, const GLchar**, const GLint*) {}
+static void GLAPIENTRY nullBindFragDataLocation(GLuint, GLuint, const GLchar*) {}
+static void GLAPIENTRY nullGetiv(GLuint, GLenum, GLint*) {}
+static void GLAPIENTRY nullGetInfoLog(GLuint, GLsizei, GLsizei*, GLchar*) {}
+static GLint GLAPIENTRY nullGetLocation(GLuint, const GLchar*) { return 0; }
+static void GLAPIENTRY nullUniformMatrix4fv(GLint, GLsizei, GLboolean, const GLfloat*) {}
+static void GLAPIENTRY nullQuery(GLenum, GLuint) {}
+static void GLAPIENTRY nullEndQuery(GLenum) {}
+static void GLAPIENTRY nullGetQueryObjectiv(GLuint, GLenum, GLint*) {}
+static void GLAPIENTRY nullGetQueryObjectui64v(GLuint, GLenum, GLuint64*) {}
+
+PFNGLGENBUFFERSPROC __glewGenBuffers = nullNames;
+PFNGLDELETEBUFFERSPROC __glewDeleteBuffers = nullConstNames;
+PFNGLBINDBUFFERPROC __glewBindBuffer = nullBindName;
+PFNGLBUFFERDATAPROC __glewBufferData = nullBufferData;
+PFNGLBUFFERSUBDATAPROC __glewBufferSubData = nullBufferSubData;
+PFNGLGENVERTEXARRAYSPROC __glewGenVertexArrays = nullNames;
+PFNGLDELETEVERTEXARRAYSPROC __glewDeleteVertexArrays = nullConstNames;
+PFNGLBINDVERTEXARRAYPROC __glewBindVertexArray = nullObject;
+PFNGLENABLEVERTEXATTRIBARRAYPROC __glewEnableVertexAttribArray = nullObject;
+PFNGLVERTEXATTRIBPOINTERPROC __glewVertexAttribPointer = nullVertexAttribPointer;
+PFNGLCREATEPROGRAMPROC __glewCreateProgram = nullCreateProgram;
+PFNGLCREATESHADERPROC __glewCreateShader = nullCreateShader;
+PFNGLDELETEPROGRAMPROC __glewDeleteProgram = nullObject;
+PFNGLDELETESHADERPROC __glewDeleteShader = nullObject;
+PFNGLSHADERSOURCEPROC __glewShaderSource = nullShaderSource;
+PFNGLCOMPILESHADERPROC __glewCompileShader = nullObject;
+PFNGLATTACHSHADERPROC __glewAttachShader = nullAttachShader;
+PFNGLBINDFRAGDATALOCATIONPROC __glewBindFragDataLocation = nullBindFragDataLocation;
+PFNGLLINKPROGRAMPROC __glewLinkProgram = nullObject;
+PFNGLUSEPROGRAMPROC __glewUseProgram = nullObject;
+PFNGLGETSHADERIVPROC __glewGetShaderiv = nullGetiv;
+PFNGLGETSHADERINFOLOGPROC __glewGetShaderInfoLog = nullGetInfoLog;
+PFNGLGETPROGRAMIVPROC __glewGetProgramiv = nullGetiv;
+PFNGLGETPROGRAMINFOLOGPROC __glewGetProgramInfoLog = nullGetInfoLog;
+PFNGLGETUNIFORMLOCATIONPROC __glewGetUniformLocation = nullGetLocation;
+PFNGLGETATTRIBLOCATIONPROC __glewGetAttribLocation = nullGetLocation;
+PFNGLUNIFORMMATRIX4FVPROC __glewUniformMatrix4fv = nullUniformMatrix4fv;
+PFNGLGENQUERIESPROC __glewGenQueries = nullNames;
+PFNGLDELETEQUERIESPROC __glewDeleteQueries = nullConstNames;
+PFNGLBEGINQUERYPROC __glewBeginQuery = nullQuery;
+PFNGLENDQUERYPROC __glewEndQuery = nullEndQuery;
+PFNGLGETQUERYOBJECTIVPROC __glewGetQueryObjectiv = nullGetQueryObjectiv;
+PFNGLGETQUERYOBJECTUI64VPROC __glewGetQueryObjectui64v = nullGetQueryObjectui64v;
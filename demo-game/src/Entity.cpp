@@ -28,7 +28,7 @@ void Entity::move(int* hitX, int* hitY)
 		if (displacement.y > kDeadZone) {
 			// MOVE DOWN
 			float dy;
-			if (gWorld.mask.checkBottom(vec(left(), position.y), vec(right(), bottom()+displacement.y), &dy)) {
+			if (gWorld.mask.checkBottom(vec(left(), position.y), vec(right(), bottom()+displacement.y), &dy, kSlop)) {
 				position.y += fmaxf(displacement.y + dy, 0.0f);
 				*hitY = 1;
 				speed.y = 0.0f;
@@ -38,7 +38,7 @@ void Entity::move(int* hitX, int* hitY)
 		} else if (displacement.y < -kDeadZone) {
 			// MOVE UP
 			float dy;
-			if (gWorld.mask.checkTop(vec(left(), top() + displacement.y), vec(right(), position.y), &dy)) {
+			if (gWorld.mask.checkTop(vec(left(), top() + displacement.y), vec(right(), position.y), &dy, kSlop)) {
 				position.y += fminf(displacement.y + dy, 0.0f);
 				*hitY = -1;
 				speed.y = 0.0f;
@@ -49,7 +49,7 @@ void Entity::move(int* hitX, int* hitY)
 		if (displacement.x > kDeadZone) {
 			// MOVE RIGHT
 			float dx;
-			if (gWorld.mask.checkRight(vec(position.x, top()), vec(right() + displacement.x, bottom()), &dx)) {
+			if (gWorld.mask.checkRight(vec(position.x, top()), vec(right() + displacement.x, bottom()), &dx, kSlop)) {
 				position.x += fmaxf(displacement.x + dx, 0.0f);
 				*hitX = 1;
 				speed.x = 0.0f;
@@ -59,7 +59,7 @@ void Entity::move(int* hitX, int* hitY)
 		} else if (displacement.x < -kDeadZone) {
 			// MOVE LEFT
 			float dx;
-			if (gWorld.mask.checkLeft(vec(left() + displacement.x, top()), vec(position.x, bottom()), &dx)) {
+			if (gWorld.mask.checkLeft(vec(left() + displacement.x, top()), vec(position.x, bottom()), &dx, kSlop)) {
 				position.x += fminf(displacement.x + dx, 0.0f);
 				*hitX = -1;
 				speed.x = 0.0f;
@@ -2,7 +2,7 @@
 
 World::World(const WorldData& data) :
 Singleton<World>(this),
-mask(data),
+mask(data.maskWidth, data.maskHeight, data.maskBytes),
 tilemap(lpAssets.tilemap("test")),
 hero(data),
 kitten(data),
@@ -51,6 +51,7 @@ void World::run()
 	while(!done) {
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		lpTimer.tick();
+		lpFrame.reset();
 		input.enterFrame();
 		handleEvents();
 		tick();
@@ -94,7 +95,12 @@ void World::draw()
 		lpLines.begin(simView);
 		kitten.debugDraw();
 		hero.debugDraw();
-		mask.debugDraw();
+		for(int y=0; y<mask.height(); ++y)
+		for(int x=0; x<mask.width(); ++x) {
+			if (mask.get(x,y)) {
+				lpLines.plotBox(vec(x,y), vec(x+1, y+1), rgb(333333));
+			}
+		}
 		lpLines.end();
 	}
 	
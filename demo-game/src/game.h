@@ -1,6 +1,7 @@
 #pragma once
 #include <littlepolygon/context.h>
 #include <littlepolygon/pools.h>
+#include <littlepolygon/collision.h>
 
 //--------------------------------------------------------------------------------
 // CONSTANTS
@@ -48,43 +49,6 @@ struct WorldData
 };
 
 
-//--------------------------------------------------------------------------------
-// TILE MASK (for collisions)
-
-class TileMask
-{
-private:
-	int mWidth, mHeight;
-	uint8_t *bytes;
-	
-public:
-	TileMask(const WorldData& data);
-	~TileMask();
-	
-	int width() const { return mWidth; }
-	int height() const { return mHeight; }
-	bool get(int x, int y) const;
-
-	void mark(int x, int y);
-	void clear(int x, int y);
-
-	bool check(lpVec topLeft, lpVec bottomRight) const;
-	
-	// TODO: Change args to match check() :P
-	bool checkLeft(lpVec bottomLeft, lpVec topRight, float *outResult) const;
-	bool checkRight(lpVec bottomLeft, lpVec topRight, float *outResult) const;
-	bool checkTop(lpVec bottomLeft, lpVec topRight, float *outResult) const;
-	bool checkBottom(lpVec bottomLeft, lpVec topRight, float *outResult) const;
-
-	void debugDraw();
-	
-	bool isFloor(int x, int y) const;
-	
-private:
-	bool rawGet(int x, int y) const;
-	void getIndices(int x, int y, int *byteIdx, int *localIdx) const;
-};
-
 //--------------------------------------------------------------------------------
 // BASE MOVEABLE ENTITY
 
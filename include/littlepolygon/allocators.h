@@ -0,0 +1,254 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include "base.h"
+
+//--------------------------------------------------------------------------------
+// ALLOCATOR INTERFACE
+// lpMalloc() and friends route through a process-wide default allocator, which
+// wraps the system heap unless it's replaced with lpSetDefaultAllocator() at
+// startup (before anything has been allocated).  Specialized allocators can also
+// be passed to collections explicitly, or used directly for transient data.
+//
+// Every allocator registers itself on construction so that stats can be reported
+// per-allocator with lpLogAllocatorStats().
+
+#define LP_ALLOC_ALIGNMENT 16
+
+struct AllocatorStats {
+	size_t bytesInUse;     // live bytes requested by callers
+	size_t peakBytes;      // high-water mark of bytesInUse
+	size_t reservedBytes;  // backing memory held by the allocator itself
+	uint32_t allocCount;   // total number of allocations (including reallocs)
+	uint32_t releaseCount; // total number of releases
+	uint32_t overflowCount;// requests that spilled over to the system heap
+};
+
+class Allocator {
+public:
+	Allocator(const char* name);
+	virtual ~Allocator();
+
+	virtual void* alloc(size_t size) = 0;
+	virtual void* realloc(void* ptr, size_t size) = 0;
+	virtual void release(void* ptr) = 0;
+
+	void* calloc(size_t count, size_t size);
+
+	template<typename T>
+	T* allocArray(int count) { return (T*) alloc(count * sizeof(T)); }
+
+	const char* name() const { return mName; }
+	const AllocatorStats& stats() const { return mStats; }
+	Allocator* next() const { return mNext; }
+
+protected:
+	AllocatorStats mStats;
+
+	void recordAlloc(size_t size) {
+		mStats.bytesInUse += size;
+		mStats.allocCount++;
+		if (mStats.bytesInUse > mStats.peakBytes) { mStats.peakBytes = mStats.bytesInUse; }
+	}
+
+	void recordRelease(size_t size) {
+		ASSERT(mStats.bytesInUse >= size);
+		mStats.bytesInUse -= size;
+		mStats.releaseCount++;
+	}
+
+private:
+	const char* mName;
+	Allocator* mPrev;
+	Allocator* mNext;
+
+	Allocator(const Allocator&);
+	Allocator& operator=(const Allocator&);
+};
+
+Allocator* lpDefaultAllocator();
+void lpSetDefaultAllocator(Allocator* allocator);
+
+typedef void (*AllocatorVisitor)(Allocator* allocator, void* context);
+void lpVisitAllocators(AllocatorVisitor visitor, void* context=0);
+void lpLogAllocatorStats();
+
+//--------------------------------------------------------------------------------
+// SYSTEM HEAP
+// Thin wrapper around malloc() which prefixes each block with its size so that
+// it can keep accurate stats.  This is the default allocator.
+
+class HeapAllocator : public Allocator {
+private:
+	SDL_SpinLock mLock;
+
+public:
+	HeapAllocator(const char* name="heap");
+
+	void* alloc(size_t size);
+	void* realloc(void* ptr, size_t size);
+	void release(void* ptr);
+};
+
+//--------------------------------------------------------------------------------
+// LINEAR ALLOCATOR
+// Bump-pointer allocation out of a fixed buffer.  Individual releases are only
+// reclaimed if they're in LIFO order -- otherwise memory is reclaimed all at once
+// with reset() or rewind().  Requests which don't fit in the buffer spill over to
+// the system heap, and are chained so that they're still cleaned up by reset()
+// (though they're freed as soon as they're released, in any order).
+//
+// Typical uses are a per-frame arena (reset once per frame), and the thread-local
+// scratch stack returned by lpScratch() for temporary buffers inside a function:
+//
+//   auto& scratch = lpScratch();
+//   auto pixels = scratch.allocArray<Color>(w * h);
+//   ...
+//   scratch.release(pixels);
+
+class LinearAllocator : public Allocator {
+public:
+	struct Mark {
+		size_t offset;
+		size_t top;
+		size_t spills;
+	};
+
+	LinearAllocator(const char* name, size_t capacity);
+	~LinearAllocator();
+
+	size_t capacity() const { return mCapacity; }
+	size_t used() const { return mOffset; }
+
+	void* alloc(size_t size);
+	void* realloc(void* ptr, size_t size);
+	void release(void* ptr);
+
+	void reset();
+	Mark mark() const;
+	void rewind(Mark m);
+
+private:
+	uint8_t* mBuffer;
+	size_t mCapacity;
+	size_t mOffset;
+	size_t mTop;         // offset of the most recent block's header
+	void* mOverflow;     // most recent spilled block
+	size_t mOverflowBytes;
+	size_t mSpills;      // blocks ever spilled, numbering them for rewind()
+
+	bool owns(void* ptr) const { return ptr >= mBuffer && ptr < mBuffer + mCapacity; }
+	size_t blockSize(void* ptr) const;
+	void updateUsage();
+};
+
+// Per-thread scratch stack, created on first use.
+LinearAllocator& lpScratch();
+
+//--------------------------------------------------------------------------------
+// SIZE-CLASS POOLS
+// Small requests are served from power-of-two freelists carved out of large
+// pages, which are never returned to the system until the allocator is destroyed.
+// Requests larger than the biggest size class go directly to the system heap.
+// Thread-safe, so it's suitable as a replacement default allocator.
+
+class PoolAllocator : public Allocator {
+public:
+	enum { kSizeClassCount = 6, kMinBlockSize = 32, kPageSize = 64 * 1024 };
+
+	PoolAllocator(const char* name="pools");
+	~PoolAllocator();
+
+	void* alloc(size_t size);
+	void* realloc(void* ptr, size_t size);
+	void release(void* ptr);
+
+private:
+	SDL_SpinLock mLock;
+	void* mFreelists[kSizeClassCount];
+	void* mPages;
+
+	void* allocBlock(int sizeClass);
+};
+
+//--------------------------------------------------------------------------------
+// ALLOCATION TRACKING
+// When built with LP_MEMORY_TRACKING, every lpMalloc() block is tagged with the
+// subsystem that requested it, and current/peak usage is tracked per-tag.  Tags
+// are set with scopes on the calling thread; collections and pools use the
+// "collections" tag unless an enclosing subsystem scope is already active.
+//
+// Each tag can carry a budget.  Exceeding it asserts in debug builds, and is
+// always recorded so that automated tests can check lpMemoryWithinBudgets().
+
+#ifndef LP_MEMORY_TRACKING
+#define LP_MEMORY_TRACKING 0
+#endif
+
+enum MemoryTag {
+	MEMORY_TAG_GENERAL,
+	MEMORY_TAG_ASSETS,
+	MEMORY_TAG_SPRITES,
+	MEMORY_TAG_RIG,
+	MEMORY_TAG_PARTICLES,
+	MEMORY_TAG_COLLECTIONS,
+	MEMORY_TAG_COUNT
+};
+
+struct MemoryTagStats {
+	size_t bytes;         // bytes currently allocated
+	size_t peakBytes;     // high-water mark of bytes
+	size_t budget;        // zero if unbudgeted
+	uint32_t count;       // blocks currently allocated
+	uint32_t peakCount;   // high-water mark of count
+	uint32_t overBudget;  // number of allocations which exceeded the budget
+};
+
+class MemoryTagScope {
+private:
+	MemoryTag prevTag;
+
+public:
+	MemoryTagScope(MemoryTag tag, bool overrideEnclosing=true);
+	~MemoryTagScope();
+};
+
+#if LP_MEMORY_TRACKING
+#	define LP_MEMORY_TAG(_tag)          MemoryTagScope lpMemoryTagScope__(_tag)
+#	define LP_MEMORY_DEFAULT_TAG(_tag)  MemoryTagScope lpMemoryTagScope__(_tag, false)
+#else
+#	define LP_MEMORY_TAG(_tag)
+#	define LP_MEMORY_DEFAULT_TAG(_tag)
+#endif
+
+// Constructs a movable collection under a tag, for member initializer lists, e.g.
+//   vertices(lpTagged<Array<Vertex>>(MEMORY_TAG_SPRITES, capacity))
+
+template<typename T, typename... Args>
+T lpTagged(MemoryTag tag, Args&&... args)
+{
+	LP_MEMORY_TAG(tag);
+	return T(std::forward<Args>(args)...);
+}
+
+const char* lpMemoryTagName(MemoryTag tag);
+MemoryTag lpCurrentMemoryTag();
+MemoryTagStats lpMemoryTagStats(MemoryTag tag);
+void lpSetMemoryBudget(MemoryTag tag, size_t bytes);
+bool lpMemoryWithinBudgets();
+void lpResetMemoryPeaks();
+void lpLogMemoryTags();
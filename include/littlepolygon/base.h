@@ -42,12 +42,24 @@
 #	define LITTLE_POLYGON_OPENGL_ES 0
 #	define LITTLE_POLYGON_OPENGL_CORE 1
 #endif
-#include <SDL2_mixer/SDL_mixer.h>
+#if __LINUX__
+#	include <SDL2/SDL_mixer.h>
+#else
+#	include <SDL2_mixer/SDL_mixer.h>
+#endif
 
 #if __WINDOWS__
 #define snprintf _snprintf_s
 #endif
 
+// VS2013 predates C++11 thread_local; its __declspec(thread) only takes plain
+// data without constructors, so that's all this should be used for
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define LP_THREAD_LOCAL __declspec(thread)
+#else
+#define LP_THREAD_LOCAL thread_local
+#endif
+
 #if LITTLE_POLYGON_DOUBLES
 
 typedef double lpFloat;
@@ -84,10 +96,11 @@ typedef float lpFloat;
 
 #endif
 
-#define lpMalloc malloc
-#define lpRealloc realloc
-#define lpCalloc calloc
-#define lpFree free
+// general-purpose allocation goes through the default allocator (see allocators.h)
+void* lpMalloc(size_t size);
+void* lpRealloc(void* ptr, size_t size);
+void* lpCalloc(size_t count, size_t size);
+void lpFree(void* ptr);
 
 // handy macros
 #ifndef STATIC_ASSERT
@@ -113,8 +126,44 @@ inline uint32_t CLZ(uint32_t value)
 	DWORD leading_zero = 0;
 	return _BitScanReverse(&leading_zero, value) ? 31 - leading_zero : 32;
 }
+// (the 64-bit intrinsics only exist on x64, so Win32 works on the halves)
+inline uint32_t CLZ64(uint64_t value)
+{
+	DWORD leading_zero = 0;
+#if defined(_M_X64)
+	return _BitScanReverse64(&leading_zero, value) ? 63 - leading_zero : 64;
+#else
+	if (_BitScanReverse(&leading_zero, (uint32_t) (value >> 32))) {
+		return 31 - leading_zero;
+	}
+	return _BitScanReverse(&leading_zero, (uint32_t) value) ? 63 - leading_zero : 64;
+#endif
+}
+inline uint32_t CTZ64(uint64_t value)
+{
+	DWORD trailing_zero = 0;
+#if defined(_M_X64)
+	return _BitScanForward64(&trailing_zero, value) ? trailing_zero : 64;
+#else
+	if (_BitScanForward(&trailing_zero, (uint32_t) value)) {
+		return trailing_zero;
+	}
+	return _BitScanForward(&trailing_zero, (uint32_t) (value >> 32)) ? 32 + trailing_zero : 64;
+#endif
+}
+inline uint32_t POPCOUNT64(uint64_t value)
+{
+#if defined(_M_X64)
+	return (uint32_t) __popcnt64(value);
+#else
+	return __popcnt((uint32_t) value) + __popcnt((uint32_t) (value >> 32));
+#endif
+}
 #else
 #define CLZ(x) __builtin_clz(x)
+#define CLZ64(x) __builtin_clzll(x)
+#define CTZ64(x) __builtin_ctzll(x)
+#define POPCOUNT64(x) __builtin_popcountll(x)
 #endif
 
 #ifdef DEBUG
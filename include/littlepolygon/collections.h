@@ -15,7 +15,12 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
-#include "base.h"
+#include "allocators.h"
+#include <atomic>
+#include <type_traits>
+
+// Collections allocate from the default allocator unless they're constructed
+// with an explicit one, e.g. lpScratch() for temporary buffers.
 
 //--------------------------------------------------------------------------------
 // ARRAY THAT CHECKS BOUNDS IN DEBUG
@@ -27,14 +32,16 @@ private:
 	int n;
 	#endif
 	T* buf;
+	Allocator* allocator;
 	
 public:
-	Array(int length)
+	Array(int length, Allocator* anAllocator=0) : allocator(anAllocator)
 	{
 		#if DEBUG
 		n = length;
 		#endif
-		buf = (T*) lpCalloc(length, sizeof(T));
+		LP_MEMORY_DEFAULT_TAG(MEMORY_TAG_COLLECTIONS);
+		buf = (T*) (allocator ? allocator->calloc(length, sizeof(T)) : lpCalloc(length, sizeof(T)));
 		ASSERT(length == 0 || buf != 0);
 	}
 	
@@ -47,12 +54,13 @@ public:
 		o.n = 0;
 		#endif
 		buf = o.buf;
+		allocator = o.allocator;
 		o.buf = 0;
 	}
 	
 	~Array()
 	{
-		lpFree(buf);
+		if (allocator) { allocator->release(buf); } else { lpFree(buf); }
 	}
 	
 	T& operator[](int i)
@@ -103,16 +111,18 @@ class Queue {
 private:
 	int cap, n, i;
 	T* slots;
+	Allocator* allocator;
 
 	void makeRoom()
 	{
+		LP_MEMORY_DEFAULT_TAG(MEMORY_TAG_COLLECTIONS);
 		if (slots == 0) {
-			slots = (T*) lpMalloc(cap * sizeof(T));
+			slots = (T*) (allocator ? allocator->alloc(cap * sizeof(T)) : lpMalloc(cap * sizeof(T)));
 		}
 	}
 
 public:
-	Queue(int aCapacity) : cap(aCapacity), n(0), i(0), slots(0) {
+	Queue(int aCapacity, Allocator* anAllocator=0) : cap(aCapacity), n(0), i(0), slots(0), allocator(anAllocator) {
 	}
 	
 	~Queue() {
@@ -121,7 +131,7 @@ public:
 			n--;
 			i = (i+1) % cap;
 		}
-		lpFree(slots);
+		if (allocator) { allocator->release(slots); } else { lpFree(slots); }
 	}
 	
 	int capacity() const { return cap; }
@@ -189,6 +199,190 @@ public:
 	};
 };
 
+//--------------------------------------------------------------------------------
+// LOCK-FREE QUEUES
+// Bounded ring buffers which are safe to share between threads, e.g. for handing
+// off asset loads, audio commands or job results.  Capacity is rounded up to a
+// power of two so that indices can be masked rather than wrapped with %, and the
+// producer/consumer indices sit on separate cache lines to avoid false sharing.
+
+#define LP_CACHE_LINE 64
+
+inline unsigned lpNextPowerOfTwo(unsigned x)
+{
+	ASSERT(x > 0 && x <= 0x80000000u);
+	return x <= 1 ? 1 : 1u << (32 - CLZ(x - 1));
+}
+
+// Single-producer, single-consumer.  Exactly one thread may enqueue, and exactly
+// one (possibly different) thread may dequeue.
+
+template<typename T>
+class SPSCQueue {
+private:
+	T* slots;
+	unsigned mask;
+
+	// consumer-owned
+	alignas(LP_CACHE_LINE) std::atomic<unsigned> head;
+	unsigned cachedTail;
+
+	// producer-owned
+	alignas(LP_CACHE_LINE) std::atomic<unsigned> tail;
+	unsigned cachedHead;
+
+	SPSCQueue(const SPSCQueue<T>&);
+	SPSCQueue<T>& operator=(const SPSCQueue<T>&);
+
+public:
+	SPSCQueue(unsigned aCapacity) : mask(lpNextPowerOfTwo(aCapacity) - 1), head(0), cachedTail(0), tail(0), cachedHead(0) {
+		LP_MEMORY_DEFAULT_TAG(MEMORY_TAG_COLLECTIONS);
+		slots = (T*) lpMalloc((mask + 1) * sizeof(T));
+		ASSERT(slots);
+	}
+
+	~SPSCQueue() {
+		// (no other thread may be using the queue by now)
+		auto t = tail.load(std::memory_order_acquire);
+		for(auto h=head.load(std::memory_order_acquire); h!=t; ++h) {
+			slots[h & mask].~T();
+		}
+		lpFree(slots);
+	}
+
+	unsigned capacity() const { return mask + 1; }
+
+	// only a snapshot if the queue is in use on other threads
+	unsigned countApprox() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); }
+
+	template<typename... Args>
+	bool tryEmplace(Args&&... args) {
+		auto t = tail.load(std::memory_order_relaxed);
+		if (t - cachedHead > mask) {
+			cachedHead = head.load(std::memory_order_acquire);
+			if (t - cachedHead > mask) {
+				return false;
+			}
+		}
+		new(&slots[t & mask]) T(std::forward<Args>(args)...);
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool tryEnqueue(const T& val) { return tryEmplace(val); }
+
+	bool tryDequeue(T* outValue) {
+		auto h = head.load(std::memory_order_relaxed);
+		if (h == cachedTail) {
+			cachedTail = tail.load(std::memory_order_acquire);
+			if (h == cachedTail) {
+				return false;
+			}
+		}
+		auto slot = &slots[h & mask];
+		*outValue = std::move(*slot);
+		slot->~T();
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+};
+
+// Multi-producer, multi-consumer.  Any thread may enqueue or dequeue.  Each cell
+// carries a sequence number which tells threads whether it's ready to be written
+// or read, so the only contention is a CAS on the shared index.
+
+template<typename T>
+class MPMCQueue {
+private:
+	struct Cell {
+		std::atomic<unsigned> sequence;
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+		T* value() { return reinterpret_cast<T*>(&storage); }
+	};
+
+	Cell* cells;
+	unsigned mask;
+	alignas(LP_CACHE_LINE) std::atomic<unsigned> enqueuePos;
+	alignas(LP_CACHE_LINE) std::atomic<unsigned> dequeuePos;
+
+	MPMCQueue(const MPMCQueue<T>&);
+	MPMCQueue<T>& operator=(const MPMCQueue<T>&);
+
+public:
+	MPMCQueue(unsigned aCapacity) : mask(lpNextPowerOfTwo(aCapacity < 2 ? 2 : aCapacity) - 1), enqueuePos(0), dequeuePos(0) {
+		LP_MEMORY_DEFAULT_TAG(MEMORY_TAG_COLLECTIONS);
+		cells = (Cell*) lpMalloc((mask + 1) * sizeof(Cell));
+		ASSERT(cells);
+		for(unsigned i=0; i<=mask; ++i) {
+			new(&cells[i].sequence) std::atomic<unsigned>(i);
+		}
+	}
+
+	~MPMCQueue() {
+		// (no other thread may be using the queue by now, so every claimed
+		// cell has been written)
+		auto end = enqueuePos.load(std::memory_order_acquire);
+		for(auto pos=dequeuePos.load(std::memory_order_acquire); pos!=end; ++pos) {
+			cells[pos & mask].value()->~T();
+		}
+		lpFree(cells);
+	}
+
+	unsigned capacity() const { return mask + 1; }
+
+	// only a snapshot if the queue is in use on other threads
+	unsigned countApprox() const { return enqueuePos.load(std::memory_order_acquire) - dequeuePos.load(std::memory_order_acquire); }
+
+	template<typename... Args>
+	bool tryEmplace(Args&&... args) {
+		Cell* cell;
+		auto pos = enqueuePos.load(std::memory_order_relaxed);
+		for(;;) {
+			cell = &cells[pos & mask];
+			auto seq = cell->sequence.load(std::memory_order_acquire);
+			auto diff = (int)(seq - pos);
+			if (diff == 0) {
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			} else if (diff < 0) {
+				return false; // full
+			} else {
+				pos = enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+		new(cell->value()) T(std::forward<Args>(args)...);
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool tryEnqueue(const T& val) { return tryEmplace(val); }
+
+	bool tryDequeue(T* outValue) {
+		Cell* cell;
+		auto pos = dequeuePos.load(std::memory_order_relaxed);
+		for(;;) {
+			cell = &cells[pos & mask];
+			auto seq = cell->sequence.load(std::memory_order_acquire);
+			auto diff = (int)(seq - (pos + 1));
+			if (diff == 0) {
+				if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			} else if (diff < 0) {
+				return false; // empty
+			} else {
+				pos = dequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+		*outValue = std::move(*cell->value());
+		cell->value()->~T();
+		cell->sequence.store(pos + mask + 1, std::memory_order_release);
+		return true;
+	}
+};
+
 //--------------------------------------------------------------------------------
 // SIMPLE TEMPLATE LIST
 
@@ -197,21 +391,23 @@ class List {
 private:
 	unsigned cap, n;
 	T* slots;
+	Allocator* allocator;
 
 	void makeRoom() {
+		LP_MEMORY_DEFAULT_TAG(MEMORY_TAG_COLLECTIONS);
 		if (slots == 0) {
-			slots = (T*) lpCalloc(cap, sizeof(T));
+			slots = (T*) (allocator ? allocator->calloc(cap, sizeof(T)) : lpCalloc(cap, sizeof(T)));
 			ASSERT(slots);
 		} else if (n == cap) {
 			ASSERT(grow);
 			cap += cap;
-			slots = (T*) lpRealloc(slots, cap * sizeof(T));
+			slots = (T*) (allocator ? allocator->realloc(slots, cap * sizeof(T)) : lpRealloc(slots, cap * sizeof(T)));
 			ASSERT(slots);
 		}
 	}
 	
 public:
-	List(unsigned aCapacity=32) : cap(aCapacity), n(0), slots(0) {
+	List(unsigned aCapacity=32, Allocator* anAllocator=0) : cap(aCapacity), n(0), slots(0), allocator(anAllocator) {
 		ASSERT(cap > 0);
 	}
 	
@@ -222,6 +418,7 @@ public:
 		cap = o.cap;
 		n = o.n;
 		slots = o.slots;
+		allocator = o.allocator;
 		o.cap = 0;
 		o.n = 0;
 		o.slots = 0;
@@ -232,7 +429,7 @@ public:
 			--n;
 			slots[n].~T();
 		}
-		lpFree(slots);
+		if (allocator) { allocator->release(slots); } else { lpFree(slots); }
 	}
 	
 	int capacity() const { return cap; }
@@ -249,18 +446,18 @@ public:
 	
 	T get(int i) const {
 		ASSERT(i >= 0);
-		ASSERT(i < n);
+		ASSERT(i < count());
 		return slots[i];
 	}
 
 	T& operator[](int i) {
 		ASSERT(i >= 0);
-		ASSERT(i < n);
+		ASSERT(i < count());
 		return slots[i];
 	}
 	const T& operator[](int i) const {
 		ASSERT(i >= 0);
-		ASSERT(i < n);
+		ASSERT(i < count());
 		return slots[i];
 	}
 	
@@ -324,8 +521,8 @@ public:
 	
 	void removeAt(int i) {
 		ASSERT(i >= 0);
-		ASSERT(i < n);
-		for(int j=i+1; j<n; ++j) {
+		ASSERT(i < count());
+		for(int j=i+1; j<count(); ++j) {
 			slots[j-1] = slots[j];
 		}
 		n--;
@@ -334,9 +531,9 @@ public:
 	
 	void insertAt(const T& val, int i) {
 		ASSERT(i >= 0);
-		ASSERT(i <= n);
+		ASSERT(i <= count());
 		ASSERT(n < cap);
-		if (i == n) {
+		if (i == count()) {
 			append(val);
 		} else {
 			makeRoom();
@@ -353,7 +550,7 @@ public:
 	}
 	
 	int findFirst(const T& val) const {
-		for(int i=0; i<n; ++i) {
+		for(int i=0; i<count(); ++i) {
 			if (slots[i] == val) { return i; }
 		}
 		return -1;
@@ -375,26 +572,52 @@ public:
 
 //--------------------------------------------------------------------------------
 // SIMPLE BITSET
+// Packed into 64-bit words, least-significant bit first.  Bulk operations work a
+// word (or SIMD register) at a time, so it's cheap enough to use for component
+// masks or visibility sets over large worlds.  Binary operations require both
+// arrays to have the same capacity.
 
 class BitArray {
 friend class BitLister;
 private:
 	unsigned capacity;
-	Array<uint32_t> words;
+	Array<uint64_t> words;
 	
 public:
 	BitArray(unsigned cap);
 	
+	unsigned size() const { return capacity; }
+
 	void clear();
 	void clear(unsigned i);
 	void mark(unsigned i);
+	void markAll();
+	void markRange(unsigned begin, unsigned end);
+	void clearRange(unsigned begin, unsigned end);
 
 	bool operator[](unsigned i) const;
+
+	unsigned count() const;
+	bool any() const;
+	bool intersects(const BitArray& other) const;
+	bool containsAll(const BitArray& other) const;
+
+	// index of the first marked bit in [begin, end), or -1
+	int findFirst() const { return findNext(0); }
+	int findNext(unsigned begin) const { return findNext(begin, capacity); }
+	int findNext(unsigned begin, unsigned end) const;
+
+	BitArray& operator&=(const BitArray& other);
+	BitArray& operator|=(const BitArray& other);
+	BitArray& operator^=(const BitArray& other);
+	BitArray& andNot(const BitArray& other);
 	
 private:
-	unsigned nwords() const { return (capacity + 31) >> 5; }
-	static uint32_t bit(unsigned i);
-	void getIndices(unsigned idx, unsigned* outWord, unsigned *outIndex) const;
+	unsigned nwords() const { return (capacity + 63) >> 6; }
+	static uint64_t bit(unsigned i) { return uint64_t(1) << (i & 63); }
+	static uint64_t maskFrom(unsigned i) { return ~uint64_t(0) << (i & 63); }
+	static uint64_t maskBelow(unsigned end) { return end & 63 ? ~maskFrom(end) : ~uint64_t(0); }
+	void trimTail();
 };
 
 class BitLister
@@ -403,12 +626,296 @@ private:
 	const BitArray *pArray;
 	unsigned currentWord;
 	unsigned currentIndex;
-	uint32_t remainder;
+	uint64_t remainder;
 	
 public:
 	BitLister(const BitArray *arr);
 	bool next();
 	
-	unsigned index() const { ASSERT(currentIndex != -1); return (currentWord<<5) + currentIndex; }
+	unsigned index() const { ASSERT(currentIndex != ~0u); return (currentWord<<6) + currentIndex; }
 };
 
+//--------------------------------------------------------------------------------
+// OPEN-ADDRESSING HASH MAP
+// Flat Robin Hood table: entries live in parallel arrays (hashes, keys, values),
+// and each probe sequence is kept short by letting inserts displace entries that
+// are closer to their home slot.  Removal shifts the following entries back, so
+// there are no tombstones.  Capacity is a power of two, grown at 7/8 load.
+//
+// Keys are hashed with HashTraits<K>, which covers integers and pointers.  For
+// names, key by the fnv1a() hash the same way assets and rigs do, or specialize
+// HashTraits for your own key type.
+
+inline uint32_t lpMixHash(uint64_t x)
+{
+	// 64-to-32 bit finalizer, so that sequential keys spread across the table
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return uint32_t(x);
+}
+
+template<typename K>
+struct HashTraits {
+	static uint32_t hash(const K& key) { return lpMixHash(uint64_t(key)); }
+	static bool equal(const K& a, const K& b) { return a == b; }
+};
+
+template<typename K>
+struct HashTraits<K*> {
+	static uint32_t hash(K* key) { return lpMixHash(uint64_t(uintptr_t(key))); }
+	static bool equal(K* a, K* b) { return a == b; }
+};
+
+template<typename K, typename V, typename Traits=HashTraits<K> >
+class HashMap {
+private:
+	uint32_t* hashes; // zero for an empty slot, otherwise hash with the high bit set
+	K* keys;
+	V* values;
+	unsigned mask;
+	int n;
+
+	HashMap(const HashMap<K,V,Traits>& noCopy);
+	HashMap<K,V,Traits>& operator=(const HashMap<K,V,Traits>& noAssign);
+
+	static uint32_t hashOf(const K& key) { return Traits::hash(key) | 0x80000000u; }
+	unsigned probeDistance(uint32_t h, unsigned slot) const { return (slot - h) & mask; }
+
+	static size_t alignUp(size_t x, size_t a) { return (x + a - 1) & ~(a - 1); }
+
+	// only requires move-construction (most collections aren't move-assignable)
+	template<typename T>
+	static void swapInPlace(T& a, T& b) {
+		T tmp(std::move(a));
+		a.~T();
+		new(&a) T(std::move(b));
+		b.~T();
+		new(&b) T(std::move(tmp));
+	}
+	
+	int lookup(const K& key) const {
+		if (n == 0) { return -1; }
+		auto h = hashOf(key);
+		unsigned i = h & mask;
+		for(unsigned dist=0;; ++dist) {
+			auto slotHash = hashes[i];
+			if (slotHash == 0 || probeDistance(slotHash, i) < dist) {
+				return -1;
+			}
+			if (slotHash == h && Traits::equal(keys[i], key)) {
+				return i;
+			}
+			i = (i + 1) & mask;
+		}
+	}
+
+	// assumes the key isn't present and there's room
+	V* insertNew(uint32_t h, K&& key, V&& value) {
+		V* result = 0;
+		unsigned i = h & mask;
+		for(unsigned dist=0;; ++dist) {
+			if (hashes[i] == 0) {
+				hashes[i] = h;
+				new(keys + i) K(std::move(key));
+				new(values + i) V(std::move(value));
+				++n;
+				return result ? result : values + i;
+			}
+			auto slotDist = probeDistance(hashes[i], i);
+			if (slotDist < dist) {
+				// take from the rich, carry the displaced entry forward
+				std::swap(h, hashes[i]);
+				swapInPlace(key, keys[i]);
+				swapInPlace(value, values[i]);
+				if (!result) { result = values + i; }
+				dist = slotDist;
+			}
+			i = (i + 1) & mask;
+		}
+	}
+
+	void rehash(unsigned newCapacity) {
+		ASSERT((newCapacity & (newCapacity - 1)) == 0);
+		auto oldHashes = hashes;
+		auto oldKeys = keys;
+		auto oldValues = values;
+		auto oldCapacity = capacity();
+
+		LP_MEMORY_DEFAULT_TAG(MEMORY_TAG_COLLECTIONS);
+		size_t keyOffset = alignUp(newCapacity * sizeof(uint32_t), alignof(K));
+		size_t valueOffset = alignUp(keyOffset + newCapacity * sizeof(K), alignof(V));
+		auto block = (uint8_t*) lpMalloc(valueOffset + newCapacity * sizeof(V));
+		ASSERT(block);
+		hashes = (uint32_t*) block;
+		keys = (K*) (block + keyOffset);
+		values = (V*) (block + valueOffset);
+		memset(hashes, 0, newCapacity * sizeof(uint32_t));
+		mask = newCapacity - 1;
+		n = 0;
+
+		for(unsigned i=0; i<oldCapacity; ++i) {
+			if (oldHashes[i]) {
+				insertNew(oldHashes[i], std::move(oldKeys[i]), std::move(oldValues[i]));
+				oldKeys[i].~K();
+				oldValues[i].~V();
+			}
+		}
+		lpFree(oldHashes);
+	}
+
+	void makeRoom() {
+		if (!hashes) {
+			rehash(mask + 1);
+		} else if (8 * unsigned(n + 1) > 7 * capacity()) {
+			rehash(2 * capacity());
+		}
+	}
+
+public:
+	HashMap(unsigned aCapacity=16) : hashes(0), keys(0), values(0), mask(lpNextPowerOfTwo(MAX(aCapacity, 2u)) - 1), n(0) {
+	}
+
+	HashMap(HashMap<K,V,Traits>&& o) : hashes(o.hashes), keys(o.keys), values(o.values), mask(o.mask), n(o.n) {
+		o.hashes = 0;
+		o.keys = 0;
+		o.values = 0;
+		o.n = 0;
+	}
+
+	~HashMap() {
+		clear();
+		lpFree(hashes);
+	}
+
+	int count() const { return n; }
+	unsigned capacity() const { return hashes ? mask + 1 : 0; }
+	bool empty() const { return n == 0; }
+
+	V* find(const K& key) {
+		auto i = lookup(key);
+		return i >= 0 ? values + i : 0;
+	}
+
+	const V* find(const K& key) const {
+		auto i = lookup(key);
+		return i >= 0 ? values + i : 0;
+	}
+
+	bool contains(const K& key) const { return lookup(key) >= 0; }
+
+	// inserts or overwrites, and returns the value's slot (only valid until the
+	// next insert or remove)
+	V* insert(const K& key, const V& value) {
+		auto i = lookup(key);
+		if (i >= 0) {
+			values[i] = value;
+			return values + i;
+		}
+		makeRoom();
+		return insertNew(hashOf(key), K(key), V(value));
+	}
+
+	// returns the existing value, or a default-constructed one
+	V* findOrInsert(const K& key) {
+		auto i = lookup(key);
+		if (i >= 0) {
+			return values + i;
+		}
+		makeRoom();
+		return insertNew(hashOf(key), K(key), V());
+	}
+
+	bool remove(const K& key) {
+		auto i = lookup(key);
+		if (i < 0) {
+			return false;
+		}
+		keys[i].~K();
+		values[i].~V();
+
+		// backward-shift the rest of the cluster so that lookups stay correct
+		unsigned hole = i;
+		unsigned next = (hole + 1) & mask;
+		while(hashes[next] && probeDistance(hashes[next], next) > 0) {
+			hashes[hole] = hashes[next];
+			new(keys + hole) K(std::move(keys[next]));
+			new(values + hole) V(std::move(values[next]));
+			keys[next].~K();
+			values[next].~V();
+			hole = next;
+			next = (next + 1) & mask;
+		}
+		hashes[hole] = 0;
+		--n;
+		return true;
+	}
+
+	void clear() {
+		for(unsigned i=0; n>0 && i<capacity(); ++i) {
+			if (hashes[i]) {
+				keys[i].~K();
+				values[i].~V();
+				hashes[i] = 0;
+				--n;
+			}
+		}
+	}
+
+	void reserve(unsigned aCount) {
+		auto needed = lpNextPowerOfTwo(MAX((8 * aCount + 6) / 7, 2u));
+		if (needed > capacity()) {
+			if (hashes) { rehash(needed); } else { mask = needed - 1; }
+		}
+	}
+
+	class Iterator {
+	private:
+		HashMap *map;
+		int idx;
+
+	public:
+		Iterator(HashMap& aMap) : map(&aMap), idx(-1) {
+		}
+
+		bool next() {
+			auto cap = (int) map->capacity();
+			do { ++idx; } while(idx < cap && map->hashes[idx] == 0);
+			return idx < cap;
+		}
+
+		const K& key() const { return map->keys[idx]; }
+		V& value() const { return map->values[idx]; }
+	};
+};
+
+template<typename K, typename Traits=HashTraits<K> >
+class HashSet {
+private:
+	HashMap<K, uint8_t, Traits> map;
+
+public:
+	HashSet(unsigned aCapacity=16) : map(aCapacity) {}
+
+	int count() const { return map.count(); }
+	unsigned capacity() const { return map.capacity(); }
+	bool empty() const { return map.empty(); }
+
+	bool contains(const K& key) const { return map.contains(key); }
+	void insert(const K& key) { map.insert(key, 0); }
+	bool remove(const K& key) { return map.remove(key); }
+	void clear() { map.clear(); }
+	void reserve(unsigned aCount) { map.reserve(aCount); }
+
+	class Iterator {
+	private:
+		typename HashMap<K, uint8_t, Traits>::Iterator iter;
+
+	public:
+		Iterator(HashSet& aSet) : iter(aSet.map) {}
+		bool next() { return iter.next(); }
+		const K& key() const { return iter.key(); }
+	};
+};
@@ -0,0 +1,168 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include "math.h"
+
+//--------------------------------------------------------------------------------
+// BROADPHASE
+// Sweep-and-prune over axis-aligned boxes, for finding every overlapping pair
+// among many moving bodies without testing them all against each other.
+//
+// Boxes are kept sorted by their left edge, so finding pairs is a single sweep
+// which only compares boxes whose x-intervals overlap.  Bodies move a little
+// each frame, so the order is repaired with an insertion sort, which is close
+// to linear when little has changed.  Large batch inserts are sorted outright.
+//
+//   Broadphase broadphase(1024);
+//   auto id = broadphase.create(e->position - e->halfSize, e->position + e->halfSize, e);
+//   ...
+//   broadphase.update(id, e->position - e->halfSize, e->position + e->halfSize);
+//   ...
+//   BroadphasePair pairs[256];
+//   int count = broadphase.findPairs(pairs, arraysize(pairs));
+//   for(int i=0; i<MIN(count, arraysize(pairs)); ++i) {
+//       collide((Entity*) broadphase.userData(pairs[i].a), (Entity*) broadphase.userData(pairs[i].b));
+//   }
+//
+// Like Entity::overlaps() in the demo, boxes which only touch don't overlap.
+
+struct BroadphasePair {
+	int a, b;  // proxy ids, a < b
+};
+
+class Broadphase {
+private:
+	struct Proxy {
+		lpVec lo, hi;
+		void* userData;
+		int nextFree;
+		bool live;
+		bool sorted;   // in the sort order (possibly dead, until it's compacted)
+	};
+
+	struct SortEntry {
+		lpVec lo, hi;
+		int id;
+	};
+
+	int capacity;
+	int count;
+	int nsorted;       // entries in the sort order, live or dead
+	int nappended;     // created since the last sort
+	int firstFree;
+	bool dirty;
+	lpFloat maxWidth;  // of any box, as of the last sort
+	Proxy* proxies;
+	SortEntry* entries;
+	int* order;        // ids, by left edge as of the last sort
+
+	Broadphase(const Broadphase&);
+	Broadphase& operator=(const Broadphase&);
+
+public:
+	Broadphase(int capacity);
+	~Broadphase();
+
+	int proxyCount() const { return count; }
+	bool isFull() const { return count == capacity; }
+
+	int create(lpVec lo, lpVec hi, void* userData=0);
+	void update(int id, lpVec lo, lpVec hi);
+	void destroy(int id);
+	void clear();
+
+	void* userData(int id) const { ASSERT(proxies[id].live); return proxies[id].userData; }
+	lpVec lowerBound(int id) const { ASSERT(proxies[id].live); return proxies[id].lo; }
+	lpVec upperBound(int id) const { ASSERT(proxies[id].live); return proxies[id].hi; }
+
+	// batch variants (outIds and userData may be null)
+	void create(int n, const lpVec* lo, const lpVec* hi, void* const* userData, int* outIds);
+	void update(int n, const int* ids, const lpVec* lo, const lpVec* hi);
+
+	// Writes up to maxPairs overlapping pairs, and returns how many there are in
+	// total (so a result greater than maxPairs means the buffer was too small).
+	int findPairs(BroadphasePair* outPairs, int maxPairs);
+
+	// Writes up to maxResults ids of boxes overlapping the given one, returning
+	// the total like findPairs().
+	int query(lpVec lo, lpVec hi, int* outIds, int maxResults);
+
+private:
+	void sort();
+};
+
+//--------------------------------------------------------------------------------
+// TILE MASK
+// A grid of solid cells, one unit square each, for colliding boxes against a
+// tilemap.  Cells are stored as row-major bits in 64-bit words, so a query
+// tests whole runs of a row at once with a mask, and finds the nearest solid
+// cell in a run with CTZ64/CLZ64, rather than visiting cells one at a time.
+//
+// As in the demo, columns left and right of the mask are solid (so it's walled
+// in), and rows above and below it are open.
+//
+// check() and the directional checks count a cell as touched if it contains any
+// point of the box, including its edges.  sweep() only counts cells which the
+// box's interior passes through, so a box resting on the floor can slide along
+// it.
+
+class TileMask {
+private:
+	int mWidth, mHeight;
+	int wordsPerRow;
+	uint64_t* words;
+
+	TileMask(const TileMask&);
+	TileMask& operator=(const TileMask&);
+
+public:
+	// bits, if given, are packed row-major and LSB-first, one per cell (the
+	// layout of the demo's world data)
+	TileMask(int width, int height, const uint8_t* bits=0);
+	~TileMask();
+
+	int width() const { return mWidth; }
+	int height() const { return mHeight; }
+
+	bool get(int x, int y) const;
+	void mark(int x, int y);
+	void clear(int x, int y);
+
+	// an open cell with a solid one below it
+	bool isFloor(int x, int y) const { return !get(x, y) && get(x, y+1); }
+
+	// Is any cell touched by the box solid?
+	bool check(lpVec lo, lpVec hi) const;
+
+	// Find the solid cell touched by the box which is furthest in the given
+	// direction (e.g. checkLeft finds the leftmost), and write the displacement
+	// which moves that side of the box clear of it, plus slop.  Writes zero and
+	// returns false if nothing is touched.
+	bool checkLeft(lpVec lo, lpVec hi, lpFloat* outResult, lpFloat slop=0) const;
+	bool checkRight(lpVec lo, lpVec hi, lpFloat* outResult, lpFloat slop=0) const;
+	bool checkTop(lpVec lo, lpVec hi, lpFloat* outResult, lpFloat slop=0) const;
+	bool checkBottom(lpVec lo, lpVec hi, lpFloat* outResult, lpFloat slop=0) const;
+
+	// Move the box by displacement and find the time of impact, in [0, 1], at
+	// which it first enters a solid cell (zero if it starts inside one).
+	// Writes 1 and returns false if the path is clear.
+	bool sweep(lpVec lo, lpVec hi, lpVec displacement, lpFloat* outTime) const;
+
+private:
+	bool findSolid(int y, int x0, int x1, bool forward, int* outX) const;
+	bool anySolid(int y0, int y1, int x0, int x1) const;
+};
@@ -19,6 +19,7 @@
 // THIS IS STRICTLY A CONVENIENCE MODULE :P
 
 #include "assets.h"
+#include "coroutines.h"
 #include "events.h"
 #include "utils.h"
 
@@ -31,12 +32,21 @@ public:
 	~SDLContext();
 };
 
+#ifndef LP_FRAME_ARENA_CAPACITY
+#define LP_FRAME_ARENA_CAPACITY (256 * 1024)
+#endif
+
+// The frame arena is for transient data that only lives until the end of the
+// current frame -- call lpFrame.reset() at the top of the main loop.
+
 class LPContext : public Singleton<LPContext>, public SDLContext {
 public:
+	LinearAllocator frame;
 	AssetBundle assets;
 	Viewport view;
 	Timer timer;
 	TimerQueue queue;
+	CoroutineScheduler coroutines;
 	Plotter plotter;
 	LinePlotter lines;
 	SpritePlotter sprites;
@@ -49,10 +59,12 @@ inline void lpInitialize(const char *caption, int w, int h, const char *assetPat
 }
 
 #define lpWindow  (LPContext::getInstance().window)
+#define lpFrame   (LPContext::getInstance().frame)
 #define lpAssets  (LPContext::getInstance().assets)
 #define lpView    (LPContext::getInstance().view)
 #define lpTimer   (LPContext::getInstance().timer)
 #define lpQueue   (LPContext::getInstance().queue)
+#define lpCoroutines (LPContext::getInstance().coroutines)
 #define lpLines   (LPContext::getInstance().lines)
 #define lpSprites (LPContext::getInstance().sprites)
 #define lpBatch   (LPContext::getInstance().batch)
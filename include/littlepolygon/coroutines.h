@@ -0,0 +1,129 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include "events.h"
+#include "pools.h"
+#include "utils.h"
+
+//--------------------------------------------------------------------------------
+// COROUTINE SCHEDULER
+// Runs stackless coroutines written with the COROUTINE_ macros from utils.h.
+// Rather than every object polling its own coroutine each frame, tasks are held
+// in a pool and only resumed when whatever they're waiting on comes around -- a
+// timeout on a TimerQueue, an EventDispatcher<> emitting, or a frame count.
+// Waiting tasks sit in intrusive lists and cost nothing per frame.
+//
+// A task is a function which receives its own CoroutineTask record.  The record
+// carries the coroutine's line state and a user context pointer; locals which
+// need to survive a yield must live in the context.
+//
+//   void blink(CoroutineTask* task) {
+//       auto sprite = (Sprite*) task->context;
+//       COROUTINE_TASK_BEGIN(task)
+//       for(;;) {
+//           sprite->setVisible(false);
+//           COROUTINE_WAIT_SECONDS(task, 0.25f)
+//           sprite->setVisible(true);
+//           COROUTINE_WAIT_EVENT(task, &sprite->onHit)
+//       }
+//       COROUTINE_END
+//   }
+//
+//   lpCoroutines.start(blink, sprite);
+//
+// A plain COROUTINE_YIELD resumes on the next frame, and COROUTINE_END releases
+// the task.  The scheduler should be ticked once per frame, after the TimerQueue
+// it waits on, so that expired timeouts resume on the same frame.
+
+class CoroutineScheduler;
+class CoroutineTask;
+
+typedef void (*CoroutineFunc)(CoroutineTask* task);
+
+#define COROUTINE_TASK_BEGIN(_task)              int& _line = (_task)->_line; COROUTINE_BEGIN
+#define COROUTINE_WAIT_SECONDS(_task, _seconds)  { (_task)->waitSeconds(_seconds); COROUTINE_YIELD }
+#define COROUTINE_WAIT_FRAMES(_task, _frames)    { (_task)->waitFrames(_frames); COROUTINE_YIELD }
+#define COROUTINE_WAIT_EVENT(_task, _event)      { (_task)->waitEvent(_event); COROUTINE_YIELD }
+
+// The task is its own wait link, so that it can sit in exactly one of the ready
+// list, a frame bucket, a TimerQueue, or an EventDispatcher at a time.
+
+class CoroutineTask : private TimerCallback {
+friend class CoroutineScheduler;
+template<typename, int> friend class ChunkedPool;
+public:
+	COROUTINE_PARAMETER
+	void* context;
+
+	CoroutineScheduler* scheduler() const { return mScheduler; }
+	bool isWaiting() const { return isBound(); }
+
+	// each of these replaces any wait that's already pending, and should be
+	// followed immediately by a yield
+
+	void waitSeconds(lpFloat seconds);
+	void waitFrames(unsigned frames);
+	void waitEvent(EventDispatcher<>* event);
+
+private:
+	CoroutineScheduler* mScheduler;
+	CoroutineFunc mFunc;
+	uint32_t mWakeFrame;
+
+	CoroutineTask(CoroutineScheduler* aScheduler, CoroutineFunc aFunc, void* aContext);
+
+	void wake();
+	void cancelWait() { if (isBound()) { unbind(); } }
+};
+
+class CoroutineScheduler {
+friend class CoroutineTask;
+public:
+	enum { kFrameSlots = 64 };
+
+	CoroutineScheduler(TimerQueue* aTimers);
+	~CoroutineScheduler();
+
+	int count() const { return tasks.count(); }
+	uint32_t frame() const { return currentFrame; }
+
+	// the task is first resumed on the next tick()
+	CoroutineTask* start(CoroutineFunc func, void* context=0);
+
+	// the task must still be running, and can't cancel itself (it should
+	// COROUTINE_END instead).  Neither of these can be called from a task.
+	void cancel(CoroutineTask* task);
+	void clear();
+
+	// returns the number of tasks resumed
+	int tick();
+
+private:
+	struct Head : EventCallback<> {
+		Head() : EventCallback<>(Action<>::none()) {}
+		CoroutineTask* first() const { return static_cast<CoroutineTask*>(static_cast<TimerCallback*>(next)); }
+	};
+
+	TimerQueue* timers;
+	ChunkedPool<CoroutineTask> tasks;
+	CoroutineTask* current;
+	Head ready;
+	Head frameSlots[kFrameSlots];
+	uint32_t currentFrame;
+
+	void schedule(CoroutineTask* task, uint32_t wakeFrame);
+};
@@ -73,7 +73,7 @@ public:
 	}
 	
 	template<class T, void (T::*TMethod)(Args...) const>
-	static void callConstMethod(T* context) {
+	static Action callConstMethod(const T* context) {
 		return Action(const_cast<T*>(context), &constMethodStub<T, TMethod>);
 	}
 	
@@ -83,7 +83,7 @@ public:
 	operator bool() const { return mThis != 0; }
 	bool operator!() const { return !(operator bool()); }
 
-	bool operator==(const Action<Args...>& other) { return mThis == other.mThis && mCallback == other.mCallback; }
+	bool operator==(const Action<Args...>& other) const { return mThis == other.mThis && mCallback == other.mCallback; }
 };
 
 
@@ -107,6 +107,7 @@ public:
 	typedef Action<Args...> Delegate;
 
 	friend class EventDispatcher<Args...>;
+	friend class TimerQueue;
 	Delegate callback;
 
 protected:
@@ -198,12 +199,177 @@ public:
 
 };
 
+//------------------------------------------------------------------------------
+// CONTIGUOUS MULTICAST EVENT DELEGATE
+//------------------------------------------------------------------------------
+
+// ArrayDispatcher is an alternative to EventDispatcher for hot events with
+// many listeners.  Delegates are stored by value in a contiguous array rather
+// than in caller-owned control blocks, so emit() is a linear scan with no list
+// surgery.  The tradeoff is that listeners are identified by their delegate,
+// and must be unbound explicitly.
+//
+// Changes made during emit() are deferred: listeners bound by a callback are
+// appended past the end of the current scan, and unbound listeners are left as
+// empty tombstones which are compacted when the outermost emit() returns.
+
+template<typename... Args>
+class ArrayDispatcher {
+public:
+	typedef Action<Args...> Delegate;
+
+private:
+	List<Delegate, true> listeners;
+	int depth;
+	bool dirty;
+
+	ArrayDispatcher(const ArrayDispatcher&);
+	ArrayDispatcher& operator=(const ArrayDispatcher&);
+
+	void compact() {
+		int live = 0;
+		for(int i=0; i<listeners.count(); ++i) {
+			if (listeners[i]) {
+				listeners[live++] = listeners[i];
+			}
+		}
+		while(listeners.count() > live) { listeners.pop(); }
+		dirty = false;
+	}
+
+public:
+	ArrayDispatcher(int capacity=8) : listeners(capacity), depth(0), dirty(false) {}
+	
+	int count() const { return listeners.count(); }
+	bool isBound() const { return listeners.count() > 0; }
+	bool isBound(Delegate callback) const { return callback && listeners.contains(callback); }
+
+	void bind(Delegate callback) {
+		ASSERT(callback);
+		listeners.append(callback);
+	}
+
+	void unbind(Delegate callback) {
+		auto i = listeners.findFirst(callback);
+		if (i == -1) {
+			return;
+		}
+		if (depth > 0) {
+			listeners[i] = Delegate::none();
+			dirty = true;
+		} else {
+			listeners.removeAt(i);
+		}
+	}
+
+	void unbind() {
+		if (depth > 0) {
+			for(auto p=listeners.begin(); p!=listeners.end(); ++p) { *p = Delegate::none(); }
+			dirty = true;
+		} else {
+			listeners.clear();
+		}
+	}
+
+	void emit(Args... args) {
+		
+		// the count is captured up front so that listeners bound as a side-
+		// effect are not invoked for this dispatch (matching EventDispatcher).
+		// Indexing (rather than holding a pointer) is deliberate, since bind()
+		// may reallocate the array.
+		
+		++depth;
+		int n = listeners.count();
+		for(int i=0; i<n; ++i) {
+			auto callback = listeners[i];
+			if (callback) {
+				callback(std::forward<Args>(args) ...);
+			}
+		}
+		if (--depth == 0 && dirty) {
+			compact();
+		}
+		
+	}
+
+};
+
+//------------------------------------------------------------------------------
+// BATCHED EVENT QUEUE
+//------------------------------------------------------------------------------
+
+// Rather than dispatching each event as it's raised, an EventQueue accumulates
+// events of one type and delivers them to listeners as a single contiguous
+// batch when flushed (e.g. once per frame), so each listener's code and data
+// stay hot across the whole batch.  postUnique() coalesces identical events.
+// Events posted by listeners during flush() are delivered in the next batch.
+//
+//   EventQueue<Collision> collisions;
+//   collisions.bind(EventQueue<Collision>::Handler::callMethod<Audio, &Audio::onCollisions>(&audio));
+//   ...
+//   collisions.post(Collision(a, b));
+//   ...
+//   collisions.flush(); // calls audio.onCollisions(events, count)
+
+template<typename T>
+class EventQueue {
+public:
+	typedef Action<const T*, int> Handler;
+
+private:
+	List<T, true> pending;
+	List<T, true> dispatching;
+	ArrayDispatcher<const T*, int> handlers;
+
+public:
+	EventQueue(int capacity=64) : pending(capacity), dispatching(capacity) {}
+
+	int count() const { return pending.count(); }
+	bool isEmpty() const { return pending.empty(); }
+
+	void bind(Handler handler) { handlers.bind(handler); }
+	void unbind(Handler handler) { handlers.unbind(handler); }
+
+	void post(const T& event) { pending.append(event); }
+
+	void postUnique(const T& event) {
+		if (!pending.contains(event)) {
+			pending.append(event);
+		}
+	}
+
+	void clear() { pending.clear(); }
+
+	// returns the number of events delivered
+	int flush() {
+		if (pending.empty()) {
+			return 0;
+		}
+		
+		// swap buffers so that listeners can post while we're dispatching
+		
+		List<T,true> tmp(std::move(pending));
+		pending.~List<T,true>();
+		new(&pending) List<T,true>(std::move(dispatching));
+		dispatching.~List<T,true>();
+		new(&dispatching) List<T,true>(std::move(tmp));
+		int result = dispatching.count();
+		if (handlers.isBound()) {
+			handlers.emit(dispatching.begin(), result);
+		}
+		dispatching.clear();
+		return result;
+	}
+
+};
+
 //------------------------------------------------------------------------------
 // GENERIC TIMER CALLBACK MULTIPLEXOR
 //------------------------------------------------------------------------------
 
 // Timer listeners are a special event listener that carries a timeout which
-// the timer queue uses to sort listeners.
+// the timer queue uses to schedule listeners.  Cancel a pending timer by
+// unbinding it (or destroying it).
 
 class TimerCallback : public EventCallback<> {
 friend class TimerQueue;
@@ -216,27 +382,58 @@ public:
 		ASSERT(prev == this);
 	}
 	
-	lpFloat nextTime() const { return static_cast<TimerCallback*>(next)->time; }
-	lpFloat prevTime() const { return static_cast<TimerCallback*>(prev)->time; }
+	lpFloat expirationTime() const { return time; }
 };
 
 // Multiplexes several timeouts to deduplicate timeout work and simply defered
 // callbacks.  Different timer queues could be used
+//
+// Timers are stored in a hierarchical timing wheel: time is quantized into
+// ticks, and each level of the wheel is a ring of slots covering 64x the span of
+// the level below it.  Enqueueing is O(1) (the slot is determined by the bits of
+// the expiration tick), as is cancelling, since slots are intrusive lists.  As
+// time advances, slots of the coarser levels are cascaded into the finer ones.
+//
+// Timers due in the same tick fire in enqueue order, so ordering is only exact
+// to within the wheel's resolution.
 
 class TimerQueue {
+public:
+	enum {
+		kTicksPerSecond = 1024,
+		kSlotBits = 6,
+		kSlotCount = 1 << kSlotBits,
+		kSlotMask = kSlotCount - 1,
+		kLevelCount = 4
+	};
+
 private:
+	struct Slot : EventCallback<> {
+		Slot() : EventCallback<>(Action<>::none()) {}
+	};
+
 	lpFloat time;
-	TimerCallback head;
+	uint32_t currentTick;
+	mutable uint64_t occupied[kLevelCount];
+	Slot wheel[kLevelCount][kSlotCount];
+	Slot overflow; // timers beyond the span of the outermost level
 	
 public:
-	TimerQueue() : time(0.0f), head(Action<>::none()) {}
+	TimerQueue();
 	~TimerQueue() { clear(); }
 	
-	inline bool hasQueue() const { return head.isBound(); }
+	bool hasQueue() const;
 
-	void clear() { while(hasQueue()) { head.next->unbind(); } }
+	void clear();
 	void enqueue(TimerCallback* newListener, lpFloat duration);
 	void tick(lpFloat dt);
+
+private:
+	static uint32_t ticksAt(lpFloat t) { return (uint32_t)(t * kTicksPerSecond); }
+	void place(TimerCallback* listener);
+	void cascade(Slot* slot);
+	void cascadeAt(uint32_t tick);
+	bool fireSlot(Slot* slot, bool all);
 };
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,257 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include "base.h"
+
+//--------------------------------------------------------------------------------
+// FAST APPROXIMATE MATH
+// Polynomial replacements for the libm calls in animation and particle inner
+// loops.  Each function takes a precision tier as a template parameter, which
+// defaults to LP_FAST_MATH_PRECISION so that a whole build can be switched:
+//
+//   LOW     cheapest polynomials; ~1e-5 for sin/cos/exp/log, ~6e-4 rad for atan2
+//   MEDIUM  close to float libm; ~1e-7, or a few 1e-6 for exp/pow of large
+//           arguments, where rounding the argument itself dominates (the default)
+//   LIBM    forwards to libm, for comparisons or bit-exact determinism
+//
+// Trig range reduction is accurate for |radians| up to LP_FAST_TRIG_RANGE, and
+// anything beyond it (or NaN) falls back to libm.  Exp/log handle the normal
+// float range; log of a non-positive number, and pow of a
+// non-positive base, fall back to libm.  Double-precision builds always use
+// libm.  Use lpMeasureFastMathAccuracy() to check a tier against libm.
+
+#define LP_FAST_MATH_LOW     0
+#define LP_FAST_MATH_MEDIUM  1
+#define LP_FAST_MATH_LIBM    2
+
+#if LITTLE_POLYGON_DOUBLES
+#	undef LP_FAST_MATH_PRECISION
+#	define LP_FAST_MATH_PRECISION LP_FAST_MATH_LIBM
+#elif !defined(LP_FAST_MATH_PRECISION)
+#	define LP_FAST_MATH_PRECISION LP_FAST_MATH_MEDIUM
+#endif
+
+#define LP_FAST_TRIG_RANGE 1e4f
+
+union lpFloatBits {
+	float f;
+	int32_t i;
+};
+
+//--------------------------------------------------------------------------------
+// TRIGONOMETRY
+
+// |radians| must be at most LP_FAST_TRIG_RANGE
+template<int P=LP_FAST_MATH_PRECISION>
+inline void fastSinCosUnchecked(lpFloat radians, lpFloat* outSin, lpFloat* outCos)
+{
+	// reduce to [-pi/4, pi/4] around the nearest multiple of pi/2, with
+	// pi/2 split into three parts so that the subtraction is nearly exact
+
+	auto y = radians * 0.63661977236758134f;
+	int q = (int)(y + (y >= 0.0f ? 0.5f : -0.5f));
+	auto fq = (lpFloat) q;
+	auto r = ((radians - fq * 1.5703125f) - fq * 4.837512969970703125e-4f) - fq * 7.54978995489188216e-8f;
+	auto z = r * r;
+
+	lpFloat s, c;
+	if (P == LP_FAST_MATH_LOW) {
+		s = r * (9.999949951e-01f + z * (-1.666015970e-01f + z * 8.121518663e-03f));
+		c = 9.999900316e-01f + z * (-4.997080619e-01f + z * 4.039834613e-02f);
+	} else {
+		s = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+		c = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+	}
+
+	// rotate by the quadrant
+
+	auto qs = (q & 1) ? c : s;
+	auto qc = (q & 1) ? s : c;
+	*outSin = (q & 2) ? -qs : qs;
+	*outCos = ((q + 1) & 2) ? -qc : qc;
+}
+
+template<int P=LP_FAST_MATH_PRECISION>
+inline void fastSinCos(lpFloat radians, lpFloat* outSin, lpFloat* outCos)
+{
+	if (P == LP_FAST_MATH_LIBM || !(lpAbs(radians) <= LP_FAST_TRIG_RANGE)) {
+		*outSin = lpSin(radians);
+		*outCos = lpCos(radians);
+		return;
+	}
+	fastSinCosUnchecked<P>(radians, outSin, outCos);
+}
+
+template<int P=LP_FAST_MATH_PRECISION>
+inline lpFloat fastSin(lpFloat radians) { lpFloat s, c; fastSinCos<P>(radians, &s, &c); return s; }
+
+template<int P=LP_FAST_MATH_PRECISION>
+inline lpFloat fastCos(lpFloat radians) { lpFloat s, c; fastSinCos<P>(radians, &s, &c); return c; }
+
+template<int P=LP_FAST_MATH_PRECISION>
+inline lpFloat fastAtan2(lpFloat y, lpFloat x)
+{
+	if (P == LP_FAST_MATH_LIBM) {
+		return lpAtan2(y, x);
+	}
+
+	// reduce to the first octant, a = tan(theta) in [0,1].  Everything
+	// below is written as selects rather than branches (and divides are
+	// unconditional) so that loops over it can vectorize.
+
+	auto ax = lpAbs(x);
+	auto ay = lpAbs(y);
+	auto hi = ax > ay ? ax : ay;
+	auto lo = ax > ay ? ay : ax;
+	auto a = lo / (hi > 0.0f ? hi : 1.0f);
+
+	lpFloat result;
+	if (P == LP_FAST_MATH_LOW) {
+		auto z = a * a;
+		result = a * (9.953584866e-01f + z * (-2.886928521e-01f + z * 7.934131283e-02f));
+	} else {
+		// a second reduction around tan(pi/8) keeps the polynomial short
+		auto reduce = a > 0.4142135623730950f;
+		auto offset = reduce ? 0.78539816339744830962f : 0.0f;
+		a = (reduce ? a - 1.0f : a) / (reduce ? a + 1.0f : 1.0f);
+		auto z = a * a;
+		result = (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z - 3.33329491539e-1f) * z * a + a + offset;
+	}
+
+	// unfold, testing sign bits so that signed zeros match libm
+
+	lpFloatBits sx, sy;
+	sx.f = x;
+	sy.f = y;
+	result = ay > ax ? 1.57079632679489661923f - result : result;
+	result = sx.i < 0 ? 3.14159265358979323846f - result : result;
+	return sy.i < 0 ? -result : result;
+}
+
+//--------------------------------------------------------------------------------
+// EXPONENTIALS
+
+template<int P=LP_FAST_MATH_PRECISION>
+inline lpFloat fastExp2(lpFloat x)
+{
+	if (P == LP_FAST_MATH_LIBM) {
+		return lpPow(2.0f, x);
+	}
+
+	// split into integer and fractional parts; the integer part goes
+	// straight into the exponent bits
+
+	x = x < -126.0f ? -126.0f : x;
+	x = x > 127.99f ? 127.99f : x;
+	int i = (int) x;
+	i -= x < (lpFloat) i ? 1 : 0;
+	auto f = x - (lpFloat) i;
+
+	lpFloat p;
+	if (P == LP_FAST_MATH_LOW) {
+		p = 9.999251655e-01f + f * (6.958335009e-01f + f * (2.260686190e-01f + f * 7.802281381e-02f));
+	} else {
+		p = 9.999999253e-01f + f * (6.931530689e-01f + f * (2.401536379e-01f + f * (5.582627792e-02f + f * (8.989371824e-03f + f * 1.877568559e-03f))));
+	}
+
+	lpFloatBits scale;
+	scale.i = (i + 127) << 23;
+	return p * scale.f;
+}
+
+// x must be positive and normal
+template<int P=LP_FAST_MATH_PRECISION>
+inline lpFloat fastLog2Unchecked(lpFloat x)
+{
+	// x = m * 2^e with m in [sqrt(1/2), sqrt(2)), then an odd series in
+	// t = (m-1)/(m+1), which converges quickly over that range
+
+	lpFloatBits bits;
+	bits.f = x;
+	int e = ((bits.i >> 23) & 0xff) - 127;
+	bits.i = (bits.i & 0x007fffff) | 0x3f800000;
+	auto m = bits.f;
+	auto wrap = m > 1.41421356237309505f;
+	m *= wrap ? 0.5f : 1.0f;
+	e += wrap ? 1 : 0;
+	auto t = (m - 1.0f) / (m + 1.0f);
+	auto z = t * t;
+
+	lpFloat p;
+	if (P == LP_FAST_MATH_LOW) {
+		p = t * (2.885228573e+00f + z * 9.835348927e-01f);
+	} else {
+		p = t * (2.885390073e+00f + z * (9.618007618e-01f + z * (5.765843392e-01f + z * 4.342603897e-01f)));
+	}
+	return (lpFloat) e + p;
+}
+
+template<int P=LP_FAST_MATH_PRECISION>
+inline lpFloat fastLog2(lpFloat x)
+{
+	if (P == LP_FAST_MATH_LIBM || !(x > 0.0f)) {
+		return lpLog(x) * 1.44269504088896341f;
+	}
+	return fastLog2Unchecked<P>(x);
+}
+
+template<int P=LP_FAST_MATH_PRECISION>
+inline lpFloat fastExp(lpFloat x) { return P == LP_FAST_MATH_LIBM ? (lpFloat) exp(x) : fastExp2<P>(x * 1.44269504088896341f); }
+
+template<int P=LP_FAST_MATH_PRECISION>
+inline lpFloat fastLog(lpFloat x) { return P == LP_FAST_MATH_LIBM ? lpLog(x) : fastLog2<P>(x) * 0.693147180559945309f; }
+
+// (one at a time this is no faster than powf; it pays off in the batch version)
+template<int P=LP_FAST_MATH_PRECISION>
+inline lpFloat fastPow(lpFloat x, lpFloat y)
+{
+	if (P == LP_FAST_MATH_LIBM || !(x > 0.0f)) {
+		return lpPow(x, y);
+	}
+	return fastExp2<P>(y * fastLog2<P>(x));
+}
+
+//--------------------------------------------------------------------------------
+// BATCH VERSIONS
+// At the configured precision.  These loop over the branch-free cores (patching
+// up any out-of-domain inputs in a second pass), so they vectorize, and being
+// out-of-line they can be compiled with wider vector instructions.  Because of
+// the second pass, outputs mustn't overlap the inputs.
+
+void fastSinCos(const lpFloat* radians, lpFloat* outSin, lpFloat* outCos, int count);
+void fastAtan2(const lpFloat* y, const lpFloat* x, lpFloat* outRadians, int count);
+void fastExp(const lpFloat* x, lpFloat* outValues, int count);
+void fastLog(const lpFloat* x, lpFloat* outValues, int count);
+void fastPow(const lpFloat* x, lpFloat y, lpFloat* outValues, int count);
+
+//--------------------------------------------------------------------------------
+// ACCURACY REPORT
+// Sweeps each function over a typical range and compares against libm in
+// double precision.  Trig errors are absolute (radians for atan2), exp/log/pow
+// errors are relative.
+
+struct FastMathAccuracy {
+	double sinError;
+	double cosError;
+	double atan2Error;
+	double expError;
+	double logError;
+	double powError;
+};
+
+FastMathAccuracy lpMeasureFastMathAccuracy(int precision=LP_FAST_MATH_PRECISION, int samples=100000);
+void lpLogFastMathAccuracy();
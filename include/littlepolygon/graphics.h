@@ -20,14 +20,161 @@
 #include "math.h"
 #include "collections.h"
 
-//------------------------------------------------------------------------------
-// ASSETS
-
 #define TEXTURE_FLAG_FILTER  0x1
 #define TEXTURE_FLAG_REPEAT  0x2
 #define TEXTURE_FLAG_LUM     0x4
 #define TEXTURE_FLAG_RGB     0x8
 
+//------------------------------------------------------------------------------
+// RENDER BACKEND
+// Shaders, textures and the plotters make all of their device calls through a
+// process-wide backend.  The default forwards to whatever OpenGL context is
+// current (which can just as well be a software one, like OSMesa or llvmpipe,
+// for pixel-exact tests).  Install a NullRenderBackend with lpSetRenderBackend()
+// at startup, before creating any graphics resources, to run the plotters
+// headless (e.g. to profile vertex generation on a build server).
+//
+// Calls are at the granularity of resources and batches rather than individual
+// GL entry points, so the indirection costs nothing per-sprite.
+
+struct VertexAttrib {
+	GLuint    location;
+	GLint     size;
+	GLenum    type;
+	GLboolean normalized;
+	uintptr_t offset;
+};
+
+class RenderBackend {
+public:
+	virtual ~RenderBackend() {}
+
+	// buffers (data may be null, to reserve space for later updates)
+	virtual GLuint createBuffer(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage) = 0;
+	virtual void updateBuffer(GLenum target, GLuint buffer, GLsizeiptr size, const GLvoid* data) = 0;
+	virtual void destroyBuffer(GLuint buffer) = 0;
+
+	// vertex arrays bind interleaved attributes of a single vertex buffer, and
+	// optionally an element buffer
+	virtual GLuint createVertexArray(GLuint vertexBuffer, GLuint elementBuffer, GLsizei stride, int nattribs, const VertexAttrib* attribs) = 0;
+	virtual void destroyVertexArray(GLuint vertexArray) = 0;
+
+	// programs (returns 0 if either stage fails to compile, or linking fails)
+	virtual GLuint createProgram(const GLchar* vsrc, const GLchar* fsrc) = 0;
+	virtual void destroyProgram(GLuint prog) = 0;
+	virtual void useProgram(GLuint prog) = 0;
+	virtual GLuint uniformLocation(GLuint prog, const char* name) = 0;
+	virtual GLuint attribLocation(GLuint prog, const char* name) = 0;
+	virtual void setUniformMatrix(GLuint location, const GLfloat* values) = 0;
+
+	// textures (flags are the TEXTURE_FLAG_* sampling flags)
+	virtual GLuint createTexture(GLsizei w, GLsizei h, GLenum format, uint32_t flags, const GLvoid* pixels) = 0;
+	virtual void destroyTexture(GLuint texture) = 0;
+	virtual void bindTexture(GLuint texture) = 0;
+
+	// draws (elements are 16-bit indices)
+	virtual void drawElements(GLuint vertexArray, GLenum mode, GLsizei count) = 0;
+	virtual void drawArrays(GLuint vertexArray, GLenum mode, GLsizei count) = 0;
+
+	// GPU timer queries (createQuery() returns 0 if they're unsupported; they
+	// can't nest, and results are only polled, never waited on)
+	virtual GLuint createQuery() = 0;
+	virtual void destroyQuery(GLuint query) = 0;
+	virtual void beginTimeQuery(GLuint query) = 0;
+	virtual void endTimeQuery() = 0;
+	virtual bool queryResult(GLuint query, uint64_t* outNanoseconds) = 0;
+};
+
+RenderBackend* lpRenderBackend();
+void lpSetRenderBackend(RenderBackend* backend);
+
+class GLRenderBackend : public RenderBackend {
+public:
+	GLuint createBuffer(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage);
+	void updateBuffer(GLenum target, GLuint buffer, GLsizeiptr size, const GLvoid* data);
+	void destroyBuffer(GLuint buffer);
+
+	GLuint createVertexArray(GLuint vertexBuffer, GLuint elementBuffer, GLsizei stride, int nattribs, const VertexAttrib* attribs);
+	void destroyVertexArray(GLuint vertexArray);
+
+	GLuint createProgram(const GLchar* vsrc, const GLchar* fsrc);
+	void destroyProgram(GLuint prog);
+	void useProgram(GLuint prog);
+	GLuint uniformLocation(GLuint prog, const char* name);
+	GLuint attribLocation(GLuint prog, const char* name);
+	void setUniformMatrix(GLuint location, const GLfloat* values);
+
+	GLuint createTexture(GLsizei w, GLsizei h, GLenum format, uint32_t flags, const GLvoid* pixels);
+	void destroyTexture(GLuint texture);
+	void bindTexture(GLuint texture);
+
+	void drawElements(GLuint vertexArray, GLenum mode, GLsizei count);
+	void drawArrays(GLuint vertexArray, GLenum mode, GLsizei count);
+
+	GLuint createQuery();
+	void destroyQuery(GLuint query);
+	void beginTimeQuery(GLuint query);
+	void endTimeQuery();
+	bool queryResult(GLuint query, uint64_t* outNanoseconds);
+};
+
+// Counts what would have been sent to the device.  Handles are allocated from
+// a counter (so they're unique and nonzero), programs always link, every
+// uniform and attribute is at location 0, and timer queries read zero.
+
+struct RenderStats {
+	uint32_t drawCalls;
+	uint32_t verticesDrawn;   // (indices, for element draws)
+	uint32_t bufferUploads;
+	size_t   bytesUploaded;
+	uint32_t textureUploads;
+	uint32_t textureBinds;
+	uint32_t programBinds;
+	uint32_t uniformUpdates;
+};
+
+class NullRenderBackend : public RenderBackend {
+private:
+	RenderStats mStats;
+	GLuint mNextHandle;
+
+public:
+	NullRenderBackend();
+
+	const RenderStats& stats() const { return mStats; }
+	void resetStats();
+
+	GLuint createBuffer(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage);
+	void updateBuffer(GLenum target, GLuint buffer, GLsizeiptr size, const GLvoid* data);
+	void destroyBuffer(GLuint buffer) {}
+
+	GLuint createVertexArray(GLuint vertexBuffer, GLuint elementBuffer, GLsizei stride, int nattribs, const VertexAttrib* attribs) { return ++mNextHandle; }
+	void destroyVertexArray(GLuint vertexArray) {}
+
+	GLuint createProgram(const GLchar* vsrc, const GLchar* fsrc) { return ++mNextHandle; }
+	void destroyProgram(GLuint prog) {}
+	void useProgram(GLuint prog) { ++mStats.programBinds; }
+	GLuint uniformLocation(GLuint prog, const char* name) { return 0; }
+	GLuint attribLocation(GLuint prog, const char* name) { return 0; }
+	void setUniformMatrix(GLuint location, const GLfloat* values) { ++mStats.uniformUpdates; }
+
+	GLuint createTexture(GLsizei w, GLsizei h, GLenum format, uint32_t flags, const GLvoid* pixels);
+	void destroyTexture(GLuint texture) {}
+	void bindTexture(GLuint texture) { ++mStats.textureBinds; }
+
+	void drawElements(GLuint vertexArray, GLenum mode, GLsizei count);
+	void drawArrays(GLuint vertexArray, GLenum mode, GLsizei count);
+
+	GLuint createQuery() { return ++mNextHandle; }
+	void destroyQuery(GLuint query) {}
+	void beginTimeQuery(GLuint query) {}
+	void endTimeQuery() {}
+	bool queryResult(GLuint query, uint64_t* outNanoseconds) { *outNanoseconds = 0; return true; }
+};
+
+//------------------------------------------------------------------------------
+// ASSETS
+
 struct TextureAsset
 {
 	
@@ -111,15 +258,15 @@ public:
 #define GLSL(src) "#version 150 core\n" #src
 
 struct Shader {
-	GLuint prog, vert, frag;
+	GLuint prog;
 	
 	Shader(const GLchar *vsrc, const GLchar *fsrc);
 	~Shader();
 
 	bool isValid() const { return prog != 0; }
-	void use() { ASSERT(prog); glUseProgram(prog); }
-	GLuint uniformLocation(const char *name) { ASSERT(prog); return glGetUniformLocation(prog, name); }
-	GLuint attribLocation(const char *name) { ASSERT(prog); return glGetAttribLocation(prog, name); }
+	void use() { ASSERT(prog); lpRenderBackend()->useProgram(prog); }
+	GLuint uniformLocation(const char *name) { ASSERT(prog); return lpRenderBackend()->uniformLocation(prog, name); }
+	GLuint attribLocation(const char *name) { ASSERT(prog); return lpRenderBackend()->attribLocation(prog, name); }
 
 };
 
@@ -129,6 +276,53 @@ struct Shader {
 typedef Color (*TextureGenerator)(double, double);
 GLuint generateTexture(TextureGenerator cb, int w=256, int h=256);
 
+//------------------------------------------------------------------------------
+// PLOTTER STATS
+// Every plotter counts what it submits, so that the cost of a frame can be
+// checked without a GPU profiler (and in headless runs).  Counts accumulate
+// until resetStats(), so snapshot and reset them once per frame, e.g.
+//
+//   auto frameStats = lpSprites.stats() + lpLines.stats();
+//   lpSprites.resetStats();
+//   lpLines.resetStats();
+//
+// and show the previous frame's numbers with SpritePlotter::drawStats().
+
+enum FlushReason {
+	FLUSH_CAPACITY,       // the vertex buffer filled up
+	FLUSH_ATLAS_CHANGE,   // the next draw needed a different texture
+	FLUSH_EXPLICIT,       // flush() or end()
+	FLUSH_REASON_COUNT
+};
+
+struct PlotterStats {
+	uint32_t draws;                        // quads, glyphs, tiles and lines plotted
+	uint32_t culled;                       // quads rejected by drawQuad()'s bounds test
+	uint32_t batches;                      // draw calls
+	uint32_t flushes[FLUSH_REASON_COUNT];  // batches, by why they were cut
+	uint32_t vertices;
+	size_t   bytesUploaded;
+	uint32_t textureBinds;
+	uint32_t shaderBinds;
+
+	void reset() { memset(this, 0, sizeof(PlotterStats)); }
+};
+
+inline PlotterStats operator+(const PlotterStats& a, const PlotterStats& b) {
+	PlotterStats result;
+	result.draws = a.draws + b.draws;
+	result.culled = a.culled + b.culled;
+	result.batches = a.batches + b.batches;
+	for(int i=0; i<FLUSH_REASON_COUNT; ++i) {
+		result.flushes[i] = a.flushes[i] + b.flushes[i];
+	}
+	result.vertices = a.vertices + b.vertices;
+	result.bytesUploaded = a.bytesUploaded + b.bytesUploaded;
+	result.textureBinds = a.textureBinds + b.textureBinds;
+	result.shaderBinds = a.shaderBinds + b.shaderBinds;
+	return result;
+}
+
 //------------------------------------------------------------------------------
 // DYNAMIC PLOTTER
 
@@ -154,11 +348,16 @@ private:
 	int currentArray;
 	GLuint vbo[3];
 	Array<Vertex> vertices;
+	PlotterStats mStats;
 	
 public:
 	Plotter(int capacity);
 	~Plotter();
 	
+	// only uploads are counted here (for every SpritePlotter sharing the buffer)
+	const PlotterStats& stats() const { return mStats; }
+	void resetStats() { mStats.reset(); }
+
 	int getCapacity() const { return capacity; }
 	GLuint getVBO(int i) { ASSERT(i >= 0 && i < 3); return vbo[i]; }
 	Vertex *getVertex(int i) { ASSERT(i >= 0 && i < capacity); return &vertices[i]; }
@@ -204,6 +403,7 @@ private:
 	int count, capacity;
 	Shader shader;
 	GLuint vao, vbo, uMVP, aPosition, aColor;
+	PlotterStats mStats;
 
 	struct LineVertex {
 		GLfloat x, y;
@@ -220,6 +420,10 @@ private:
 
 public:
 	LinePlotter(int capacity);
+	~LinePlotter();
+
+	const PlotterStats& stats() const { return mStats; }
+	void resetStats() { mStats.reset(); }
 
 	void begin(const Viewport& viewport);
 	void plot(lpVec p0, lpVec p1, Color c);
@@ -229,5 +433,5 @@ public:
 	void end();
 
 private:
-	void commitBatch();
+	void commitBatch(FlushReason reason);
 };
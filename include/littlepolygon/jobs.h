@@ -0,0 +1,115 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include "collections.h"
+
+//--------------------------------------------------------------------------------
+// WORK-STEALING JOB SYSTEM
+// Opt-in thread pool.  Nothing else in the library spawns threads or touches a
+// JobSystem -- the application creates one and hands work to it explicitly.
+//
+// The thread which constructs the JobSystem is the "main" worker.  It doesn't
+// run a loop of its own; it helps execute jobs while it's blocked in wait(), and
+// is the only thread which runs jobs posted with runOnMainThread() (e.g. for GL
+// calls), when it calls runMainThreadJobs().
+//
+// Each worker pushes and pops jobs at the bottom of its own deque, and idle
+// workers steal from the top of others'.  Jobs submitted from threads that
+// aren't workers go to a shared injection queue.
+//
+// Completion is tracked with JobCounters.  Every job submitted against a counter
+// increments it, and decrements it when it finishes.  A job can also depend on a
+// counter, in which case it's parked until that counter reaches zero.
+//
+//   JobCounter done;
+//   jobs.parallelFor(count, 64, &tickParticles, &system, &done);
+//   jobs.wait(&done);
+
+typedef void (*JobFunc)(void* context, int begin, int end);
+
+struct Job;
+struct JobDeque;
+
+class JobCounter {
+private:
+	std::atomic<int> pending;
+	SDL_SpinLock lock;
+	Job* parked;
+
+	friend class JobSystem;
+
+	JobCounter(const JobCounter&);
+	JobCounter& operator=(const JobCounter&);
+
+public:
+	JobCounter() : pending(0), lock(0), parked(0) {}
+	~JobCounter() { ASSERT(isDone()); }
+
+	bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+class JobSystem {
+private:
+	int nworkers;
+	SDL_Thread** threads;
+	JobDeque* deques;
+	Job* jobs;
+	MPMCQueue<Job*> freeJobs;
+	MPMCQueue<Job*> injected;
+	MPMCQueue<Job*> mainJobs;
+	SDL_sem* wakeup;
+	std::atomic<int> sleepers;
+	std::atomic<bool> running;
+
+	JobSystem(const JobSystem&);
+	JobSystem& operator=(const JobSystem&);
+
+public:
+
+	// workerCount includes the main thread; zero means one per CPU
+	JobSystem(int workerCount=0, int jobCapacity=4096);
+	~JobSystem();
+
+	int workerCount() const { return nworkers; }
+
+	// index of the calling thread in this system, or -1 if it isn't a worker
+	int currentWorker() const;
+	bool isMainThread() const { return currentWorker() == 0; }
+
+	void run(JobFunc func, void* context, JobCounter* counter=0, JobCounter* dependency=0, int begin=0, int end=1);
+
+	// split [0,count) into ranges of grainSize (zero picks a grain which gives
+	// each worker a few ranges to balance with)
+	void parallelFor(int count, int grainSize, JobFunc func, void* context, JobCounter* counter=0, JobCounter* dependency=0);
+
+	// blocks until the counter is done, executing other jobs in the meantime
+	void wait(JobCounter* counter);
+
+	// main-thread-affine jobs
+	void runOnMainThread(JobFunc func, void* context, JobCounter* counter=0, int begin=0, int end=1);
+	int runMainThreadJobs();
+
+private:
+	Job* allocJob(JobFunc func, void* context, JobCounter* counter, int begin, int end);
+	void submit(Job* job, JobCounter* dependency);
+	void push(Job* job);
+	Job* findJob(int worker);
+	void execute(Job* job);
+	void finish(JobCounter* counter);
+
+	static int workerMain(void* data);
+};
@@ -16,6 +16,7 @@
 
 #pragma once
 #include "base.h"
+#include "fastmath.h"
 #include "mrand.h"
 
 #ifndef M_PI
@@ -64,7 +65,7 @@ struct lpVec {
 	lpFloat manhattan() const    { return lpAbs(x)+lpAbs(y); }
 	lpFloat magnitude() const    { return lpSqrt(norm()); }
 	lpVec conjugate() const     { return lpVec(x,-y); }
-	lpFloat radians() const      { return lpAtan2(y,x); }
+	lpFloat radians() const      { return fastAtan2(y,x); }
 	lpVec reflection() const    { return lpVec(y,x); }
 	lpVec anticlockwise() const { return lpVec(-y, x); }
 	lpVec clockwise() const     { return lpVec(y, -x); }
@@ -109,17 +110,8 @@ inline lpVec slerp(lpVec u, lpVec v, lpFloat t)
 
 // simple 2d affine transform
 struct lpMatrix {
-	union {
-		struct {
-			// mathbooks use this stupid a-b-c row-major notation :P
-			lpFloat a,d,b,e,c,f;
-		};
-		struct {
-			// 
-			lpVec u, v, t;
-		};
-	};
-	
+	// columns: the images of the x- and y-axes, and the translation
+	lpVec u, v, t;
 
 	lpMatrix() {}
 	lpMatrix(lpVec au, lpVec av, lpVec at) : u(au), v(av), t(at) {}	
@@ -149,7 +141,7 @@ struct lpMatrix {
 		           u.y*w.x + v.y*w.y);
 	}
 
-	lpFloat radians() const { return lpAtan2(u.y, u.x); }
+	lpFloat radians() const { return fastAtan2(u.y, u.x); }
 	lpVec scale() const { return vec(u.magnitude(), v.magnitude()); }
 	
 	bool orthogonal() const { 
@@ -164,14 +156,14 @@ struct lpMatrix {
 		       un < M_COLINEAR_SLOP && vn < M_COLINEAR_SLOP;
 	}
 
-	lpFloat determinant() const { return a*e-b*d; }
+	lpFloat determinant() const { return u.x*v.y - v.x*u.y; }
 
 	lpMatrix inverse() const {
 		lpFloat invDet = 1.0f / determinant();
 		return lpMatrix(
-			invDet * vec( e, -d ),
-			invDet * vec( -b, a ),
-			vec( b*f - c*e , c*d - a*f )
+			invDet * vec( v.y, -u.y ),
+			invDet * vec( -v.x, u.x ),
+			invDet * vec( v.x*t.y - t.x*v.y, t.x*u.y - u.x*t.y )
 		);
 	}
 
@@ -180,8 +172,8 @@ struct lpMatrix {
 	}
 
 	lpVec invRigidTransformVector(const lpVec &w) const {
-		return vec(a * w.x + d * w.y,
-			       b * w.x + e * w.y);
+		return vec(u.x * w.x + u.y * w.y,
+			       v.x * w.x + v.y * w.y);
 	}
 
 	lpVec invRigidTransformPoint(const lpVec& p) const {
@@ -195,14 +187,19 @@ inline lpMatrix matTranslation(lpVec t) { return lpMatrix(vec(1,0), vec(0,1), t)
 inline lpMatrix matTranslation(lpFloat x, lpFloat y) { return matTranslation(vec(x,y)); }
 inline lpMatrix matAttitude(lpVec dir) { return lpMatrix(dir, vec(-dir.y,dir.x), vec(0,0)); }
 inline lpMatrix matAttitude(lpFloat x, lpFloat y) { return matAttitude(vec(x,y)); }
-inline lpMatrix matRotation(lpFloat radians) { return matAttitude(lpCos(radians), lpSin(radians)); }
-inline lpMatrix matPolar(lpFloat r, lpFloat radians) { return matAttitude(r*lpCos(radians), r*lpSin(radians)); }
+inline lpMatrix matRotation(lpFloat radians) { lpFloat s, c; fastSinCos(radians, &s, &c); return matAttitude(c, s); }
+inline lpMatrix matPolar(lpFloat r, lpFloat radians) { lpFloat s, c; fastSinCos(radians, &s, &c); return matAttitude(r*c, r*s); }
 inline lpMatrix matScale(lpVec s) { return lpMatrix(vec(s.x,0), vec(0,s.y), vec(0,0)); }
 inline lpMatrix matScale(lpFloat x, lpFloat y) { return matScale(vec(x,y)); }
 inline lpMatrix matScale(lpFloat k) { return matScale(vec(k,k)); }
 
 inline lpMatrix matAttitudeTranslation(lpVec dir, lpVec pos) { return lpMatrix(dir, vec(-dir.y, dir.x), pos); }
 
+// componentwise, so only a good approximation between nearby transforms
+inline lpMatrix lerp(const lpMatrix& m0, const lpMatrix& m1, lpFloat t) { 
+	return lpMatrix(lerp(m0.u, m1.u, t), lerp(m0.v, m1.v, t), lerp(m0.t, m1.t, t)); 
+}
+
 //--------------------------------------------------------------------------------
 // MISC FUNCTIONS
 
@@ -222,10 +219,10 @@ inline lpVec cdiv(lpVec u, lpVec v)
 	return lpVec((u.x*v.x+u.y*v.y)*normInv, (v.x*u.y-u.x*v.y)*normInv);
 }
 
-// polar -> linear conversion
+// polar -> linear conversion (at LP_FAST_MATH_PRECISION, see fastmath.h)
 
-inline lpVec polarVector(lpFloat radius, lpFloat radians) { return radius * lpVec(lpCos(radians), lpSin(radians)); }
-inline lpVec unitVector(lpFloat radians) { return lpVec(lpCos(radians), lpSin(radians)); }
+inline lpVec unitVector(lpFloat radians) { lpVec result; fastSinCos(radians, &result.y, &result.x); return result; }
+inline lpVec polarVector(lpFloat radius, lpFloat radians) { return radius * unitVector(radians); }
 
 inline int floorToInt(lpFloat x) { return (int) lpFloor(x); }
 
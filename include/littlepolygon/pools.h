@@ -39,6 +39,7 @@ public:
 	Pool(int n=1024)
 	: mCurr(0), mEnd(0), mCount(0), mCap(n)
 	{
+		LP_MEMORY_DEFAULT_TAG(MEMORY_TAG_COLLECTIONS);
 		mRecords = (T*) lpMalloc(n * (sizeof(T) + sizeof(T*) + sizeof(T**)));
 		mRoster = (T**) (mRecords + n);
 		mBackRefs = (T***) (mRoster + n);
@@ -194,6 +195,7 @@ public:
 	template<typename... Args>
 	T* alloc(Args&&... args)
 	{
+		LP_MEMORY_DEFAULT_TAG(MEMORY_TAG_COLLECTIONS);
 		if (slots == 0) {
 			slots = (T*) lpCalloc(capacity, sizeof(T));
 		} else if (count == capacity) {
@@ -277,7 +279,8 @@ public:
 
 	BatchPool(int cap=1024) : mCount(0), mCap(cap)
 	{
-		mSlots = (T*) lpMalloc(cap * (sizeof(T*) + sizeof(BatchIndex<T>*) + sizeof(BatchIndex<T>*)));
+		LP_MEMORY_DEFAULT_TAG(MEMORY_TAG_COLLECTIONS);
+		mSlots = (T*) lpMalloc(cap * (sizeof(T) + sizeof(BatchIndex<T>) + sizeof(BatchIndex<T>*)));
 		mIndex = (BatchIndex<T>*) (mSlots + cap);
 		mBack = (BatchIndex<T>**) (mIndex + cap);
 		
@@ -293,6 +296,13 @@ public:
 	bool isFull() const { return mCount == mCap; }
 	bool isActive(BatchHandle<T> h) const { return h.index->slot >= begin() && h.index->slot < end(); }
 
+	int count() const { return mCount; }
+	int cap() const { return mCap; }
+
+	// a dense id in [0, cap()) which, unlike the record's slot, doesn't
+	// change while the handle is live (for keying side-tables)
+	int indexOf(BatchHandle<T> h) const { return (int) (h.index - mIndex); }
+
 	T* begin() { return mSlots; }
 	T* end() { return mSlots+mCount; }
 	
@@ -354,3 +364,620 @@ private:
 	}
 
 };
+
+//------------------------------------------------------------------------------
+// CHUNKED POOLS are growable variants of Pool and BatchPool which allocate
+// fixed-size chunks of records on demand, rather than reserving the worst-case
+// capacity up-front.  Existing records never move to a different chunk, so
+// growing doesn't copy anything.
+//------------------------------------------------------------------------------
+
+// Like Pool, records remain at fixed memory addresses for their whole lifetime,
+// and the iteration interface is the same (safe to release during iteration).
+
+template<typename T, int kChunkSize=256>
+class ChunkedPool
+{
+private:
+	struct Slot {
+		T record;  // first, so that T* and Slot* are interchangeable
+		int iter;  // position in the roster, or -1 if inactive
+	};
+
+	List<Slot*, true> mChunks;
+	List<Slot*, true> mRoster;
+	int mCount;
+	int mCurr;
+	int mEnd;
+
+public:
+
+	ChunkedPool() : mChunks(16), mRoster(kChunkSize), mCount(0), mCurr(0), mEnd(0) {}
+	
+	~ChunkedPool()
+	{
+		drain();
+		for(int i=0; i<mChunks.count(); ++i) {
+			lpFree(mChunks[i]);
+		}
+	}
+
+	int count() const { return mCount; }
+	int cap() const { return mRoster.count(); }
+	bool isActive(T* inst) const { return slotOf(inst)->iter >= 0; }
+
+	template<typename... Args>
+	T* alloc(Args&&... args)
+	{
+		if (mCount == mRoster.count()) {
+			addChunk();
+		}
+		auto slot = mRoster[mCount];
+		slot->iter = mCount;
+		++mCount;
+		return new(&slot->record) T (std::forward<Args>(args)...);
+	}
+	
+	void drain()
+	{
+		ASSERT(mEnd == 0);
+		while(mCount > 0) {
+			release(&mRoster[mCount-1]->record);
+		}
+	}
+	
+	void release(T* inst)
+	{
+		ASSERT(isActive(inst));
+		auto iter = slotOf(inst)->iter;
+		--mCount;
+		if (iter >= mEnd) {
+			// element is after the iteration slice, 1 swap
+			doSwap(iter, mCount);
+		} else if (iter >= mCurr) {
+			// element is inside the iteration slice, 2 swaps
+			--mEnd;
+			doSwap(iter, mEnd);
+			doSwap(mEnd, mCount);
+		} else {
+			// element is before the iteration slice, 3 swaps
+			--mCurr;
+			--mEnd;
+			doSwap(iter, mCurr);
+			doSwap(mCurr, mEnd);
+			doSwap(mEnd, mCount);
+		}
+		slotOf(inst)->iter = -1;
+		inst->~T();
+	}
+
+	void iterBegin()
+	{
+		mCurr = 0;
+		mEnd = mCount;
+	}
+
+	void iterCancel()
+	{
+		mCurr = 0;
+		mEnd = 0;
+	}
+
+	T* iterNext()
+	{
+		if (mCurr != mEnd) {
+			auto result = &mRoster[mCurr]->record;
+			++mCurr;
+			return result;
+		} else {
+			mCurr = 0;
+			mEnd = 0;
+			return 0;
+		}
+	}
+
+private:
+	static Slot* slotOf(T* inst) { return reinterpret_cast<Slot*>(inst); }
+
+	void addChunk()
+	{
+		LP_MEMORY_DEFAULT_TAG(MEMORY_TAG_COLLECTIONS);
+		auto chunk = (Slot*) lpMalloc(kChunkSize * sizeof(Slot));
+		ASSERT(chunk);
+		mChunks.append(chunk);
+		for(int i=0; i<kChunkSize; ++i) {
+			chunk[i].iter = -1;
+			mRoster.append(chunk + i);
+		}
+	}
+
+	void doSwap(int i, int j)
+	{
+		if (i != j) {
+			std::swap(mRoster[i], mRoster[j]);
+			mRoster[i]->iter = i;
+			mRoster[j]->iter = j;
+		}
+	}
+
+};
+
+// Like BatchPool, records are treated like Plain-Old-Data and referenced with a
+// BatchHandle.  Records are dense within each chunk (holes are filled from the
+// end of the same chunk), so iterate chunk-by-chunk:
+//
+//   for(int i=0; i<pool.chunkCount(); ++i)
+//   for(auto p=pool.chunkBegin(i); p!=pool.chunkEnd(i); ++p) { ... }
+
+template<typename T, int kChunkSize=256>
+class ChunkedBatchPool
+{
+private:
+	struct Chunk;
+	
+	struct Index {
+		BatchIndex<T> index; // first, so that BatchHandles can be cast back
+		Chunk* chunk;
+	};
+	
+	struct Chunk {
+		int id, count;
+		T* records;
+		BatchIndex<T>** back;
+		Index* nodes;
+		BatchIndex<T>* freelist;
+	};
+
+	List<Chunk*, true> mChunks;
+	int mCount;
+	int mOpen; // no chunks before this one have free space
+
+public:
+
+	ChunkedBatchPool() : mChunks(16), mCount(0), mOpen(0) {}
+	
+	~ChunkedBatchPool()
+	{
+		for(int i=0; i<mChunks.count(); ++i) {
+			lpFree(mChunks[i]->records);
+			lpFree(mChunks[i]);
+		}
+	}
+
+	int count() const { return mCount; }
+	int cap() const { return kChunkSize * mChunks.count(); }
+	bool isEmpty() const { return mCount == 0; }
+	bool isActive(BatchHandle<T> h) const {
+		auto chunk = chunkOf(h);
+		return h.index->slot >= chunk->records && h.index->slot < chunk->records + chunk->count;
+	}
+
+	int chunkCount() const { return mChunks.count(); }
+	T* chunkBegin(int i) { return mChunks[i]->records; }
+	T* chunkEnd(int i) { return mChunks[i]->records + mChunks[i]->count; }
+	const T* chunkBegin(int i) const { return mChunks[i]->records; }
+	const T* chunkEnd(int i) const { return mChunks[i]->records + mChunks[i]->count; }
+
+	template<typename... Args>
+	BatchHandle<T> alloc(Args&&... args)
+	{
+		auto chunk = openChunk();
+
+		// pop a handle from the chunk's freelist
+		auto result = chunk->freelist;
+		chunk->freelist = result->next;
+
+		// append a new slot to the end of the chunk
+		auto idx = chunk->count;
+		++chunk->count;
+		++mCount;
+		result->slot = new(chunk->records + idx) T (std::forward<Args>(args)...);
+		chunk->back[idx] = result;
+		return result;
+	}
+
+	void release(BatchHandle<T> handle)
+	{
+		ASSERT(isActive(handle));
+		auto chunk = chunkOf(handle);
+		--chunk->count;
+		--mCount;
+
+		auto i = (int) (handle.index->slot - chunk->records);
+		if (i != chunk->count) {
+			// fill "hole" with last element of the chunk
+			memcpy(chunk->records + i, chunk->records + chunk->count, sizeof(T));
+			chunk->back[i] = chunk->back[chunk->count];
+
+			// update handle to reflect moved record 
+			chunk->back[i]->slot = chunk->records + i;
+		}
+
+		// return handle to freelist
+		handle.index->next = chunk->freelist;
+		chunk->freelist = handle.index;
+		if (chunk->id < mOpen) {
+			mOpen = chunk->id;
+		}
+	}
+
+	void clear()
+	{
+		for(int i=0; i<mChunks.count(); ++i) {
+			mChunks[i]->count = 0;
+			resetFreelist(mChunks[i]);
+		}
+		mCount = 0;
+		mOpen = 0;
+	}
+
+private:
+	static Chunk* chunkOf(BatchHandle<T> h) { return reinterpret_cast<Index*>(h.index)->chunk; }
+
+	Chunk* openChunk()
+	{
+		while(mOpen < mChunks.count() && mChunks[mOpen]->count == kChunkSize) {
+			++mOpen;
+		}
+		if (mOpen == mChunks.count()) {
+			addChunk();
+		}
+		return mChunks[mOpen];
+	}
+
+	void addChunk()
+	{
+		LP_MEMORY_DEFAULT_TAG(MEMORY_TAG_COLLECTIONS);
+		auto chunk = (Chunk*) lpMalloc(sizeof(Chunk));
+		chunk->id = mChunks.count();
+		chunk->count = 0;
+		chunk->records = (T*) lpMalloc(kChunkSize * (sizeof(T) + sizeof(Index) + sizeof(BatchIndex<T>*)));
+		chunk->nodes = (Index*) (chunk->records + kChunkSize);
+		chunk->back = (BatchIndex<T>**) (chunk->nodes + kChunkSize);
+		for(int i=0; i<kChunkSize; ++i) {
+			chunk->nodes[i].chunk = chunk;
+		}
+		resetFreelist(chunk);
+		mChunks.append(chunk);
+	}
+
+	static void resetFreelist(Chunk* chunk)
+	{
+		chunk->freelist = &chunk->nodes[0].index;
+		for(int i=0; i<kChunkSize-1; ++i) {
+			chunk->nodes[i].index.next = &chunk->nodes[i+1].index;
+		}
+		chunk->nodes[kChunkSize-1].index.next = 0;
+	}
+
+};
+
+//--------------------------------------------------------------------------------
+// SLOT POOLS are like Batches, but callers receive a generational handle
+// (slot index + generation) instead of a pointer.  Releasing a record bumps the
+// generation of its slot, so stale handles to reused slots are detected with a
+// single compare rather than silently aliasing a new record.  Handles are plain
+// values, so they can be stored across frames, serialized, and compared.
+//
+// Records are kept dense for iteration, and like Batches they move around
+// using memcpy() when a hole is filled, so don't hold onto raw pointers.  It's
+// safe to release records while iterating with an index as long as you don't
+// advance the index past a release (the hole is filled with the last record).
+//--------------------------------------------------------------------------------
+
+struct SlotHandle
+{
+	uint32_t index;
+	uint32_t generation; // 0 is never issued, so a zeroed handle is always stale
+
+	SlotHandle() : index(0), generation(0) {}
+	SlotHandle(uint32_t aIndex, uint32_t aGeneration) : index(aIndex), generation(aGeneration) {}
+
+	bool operator==(const SlotHandle& h) const { return index == h.index && generation == h.generation; }
+	bool operator!=(const SlotHandle& h) const { return index != h.index || generation != h.generation; }
+};
+
+template<typename T>
+class SlotPool
+{
+private:
+	struct Slot {
+		uint32_t generation;
+		uint32_t index; // dense index when active, next free slot otherwise
+	};
+
+	int mCount, mCap;
+	T* mRecords;
+	Slot* mSlots;
+	uint32_t* mDenseToSlot;
+	uint32_t mFreelist;
+
+public:
+
+	SlotPool(int cap=1024) : mCount(0), mCap(cap)
+	{
+		ASSERT(cap > 0);
+		LP_MEMORY_DEFAULT_TAG(MEMORY_TAG_COLLECTIONS);
+		mRecords = (T*) lpMalloc(cap * (sizeof(T) + sizeof(Slot) + sizeof(uint32_t)));
+		mSlots = (Slot*) (mRecords + cap);
+		mDenseToSlot = (uint32_t*) (mSlots + cap);
+		for(int i=0; i<cap; ++i) {
+			mSlots[i].generation = 1;
+		}
+		resetFreelist();
+	}
+
+	~SlotPool()
+	{
+		clear();
+		lpFree(mRecords);
+	}
+
+	int count() const { return mCount; }
+	int cap() const { return mCap; }
+	bool isEmpty() const { return mCount == 0; }
+	bool isFull() const { return mCount == mCap; }
+
+	bool isActive(SlotHandle h) const
+	{
+		ASSERT(h.index < (uint32_t) mCap);
+		return mSlots[h.index].generation == h.generation;
+	}
+
+	// returns NULL for stale handles
+	T* get(SlotHandle h) { return isActive(h) ? mRecords + mSlots[h.index].index : 0; }
+	const T* get(SlotHandle h) const { return isActive(h) ? mRecords + mSlots[h.index].index : 0; }
+
+	T* begin() { return mRecords; }
+	T* end() { return mRecords + mCount; }
+	const T* begin() const { return mRecords; }
+	const T* end() const { return mRecords + mCount; }
+
+	// recover the handle of a record during iteration
+	SlotHandle handleOf(const T* p) const
+	{
+		ASSERT(p >= begin() && p < end());
+		auto slot = mDenseToSlot[p - mRecords];
+		return SlotHandle(slot, mSlots[slot].generation);
+	}
+
+	template<typename... Args>
+	SlotHandle alloc(Args&&... args)
+	{
+		ASSERT(mCount < mCap);
+
+		// pop a slot from the freelist
+		auto slot = mFreelist;
+		mFreelist = mSlots[slot].index;
+
+		// append a new record to the end
+		auto idx = mCount;
+		++mCount;
+		new(mRecords + idx) T (std::forward<Args>(args)...);
+		mSlots[slot].index = idx;
+		mDenseToSlot[idx] = slot;
+		return SlotHandle(slot, mSlots[slot].generation);
+	}
+
+	void release(SlotHandle h)
+	{
+		ASSERT(isActive(h));
+		auto i = mSlots[h.index].index;
+		mRecords[i].~T();
+		--mCount;
+
+		if (i != (uint32_t) mCount) {
+			// fill "hole" with last element
+			memcpy(mRecords + i, mRecords + mCount, sizeof(T));
+			mDenseToSlot[i] = mDenseToSlot[mCount];
+			mSlots[mDenseToSlot[i]].index = i;
+		}
+
+		// invalidate outstanding handles and return the slot to the freelist
+		++mSlots[h.index].generation;
+		if (mSlots[h.index].generation == 0) { mSlots[h.index].generation = 1; }
+		mSlots[h.index].index = mFreelist;
+		mFreelist = h.index;
+	}
+
+	void release(T* p) { release(handleOf(p)); }
+
+	void clear()
+	{
+		while(mCount > 0) {
+			release(handleOf(mRecords + (mCount-1)));
+		}
+	}
+
+private:
+
+	void resetFreelist()
+	{
+		mFreelist = 0;
+		for(int i=0; i<mCap; ++i) {
+			mSlots[i].index = i+1;
+		}
+	}
+
+};
+
+//--------------------------------------------------------------------------------
+// COMPONENT STORES are sparse sets: a dense array of records (plus the entity id
+// that owns each one) and a sparse array mapping entity ids to dense indices.
+// Systems update a component type in one cache-linear pass over the dense array,
+// and multi-component systems use lpJoin(), which walks the smallest store and
+// probes the others in O(1).
+//
+// Entity ids are small integers, e.g. the SlotHandle index of an entity record,
+// and the sparse array grows to cover the largest id seen.
+//
+// WARNING: Like Batches, records are treated like Plain-Old-Data and are moved
+// around with memcpy() when a hole is filled, so don't hold onto raw pointers.
+//--------------------------------------------------------------------------------
+
+typedef uint32_t EntityID;
+
+template<typename T>
+class ComponentStore
+{
+private:
+	enum { kNone = 0xffffffff };
+
+	T* mRecords;
+	EntityID* mEntities;
+	uint32_t* mSparse;
+	int mCount;
+	int mCap;
+	unsigned mSparseCap;
+
+	ComponentStore(const ComponentStore<T>&);
+	ComponentStore<T>& operator=(const ComponentStore<T>&);
+
+public:
+
+	ComponentStore(int capacity=64, unsigned entityCapacity=256)
+	: mRecords(0), mEntities(0), mSparse(0), mCount(0), mCap(0), mSparseCap(0)
+	{
+		reserve(capacity);
+		reserveEntities(entityCapacity);
+	}
+
+	~ComponentStore()
+	{
+		lpFree(mRecords);
+		lpFree(mSparse);
+	}
+
+	int count() const { return mCount; }
+	int cap() const { return mCap; }
+	bool isEmpty() const { return mCount == 0; }
+
+	T* begin() { return mRecords; }
+	T* end() { return mRecords + mCount; }
+	const T* begin() const { return mRecords; }
+	const T* end() const { return mRecords + mCount; }
+
+	const EntityID* entities() const { return mEntities; }
+	EntityID entityAt(int i) const { ASSERT(i >= 0 && i < mCount); return mEntities[i]; }
+	EntityID entityOf(const T* p) const { ASSERT(p >= mRecords && p < mRecords + mCount); return mEntities[p - mRecords]; }
+
+	bool has(EntityID e) const { return e < mSparseCap && mSparse[e] != kNone; }
+	T* get(EntityID e) { return has(e) ? mRecords + mSparse[e] : 0; }
+	const T* get(EntityID e) const { return has(e) ? mRecords + mSparse[e] : 0; }
+
+	template<typename... Args>
+	T* add(EntityID e, Args&&... args)
+	{
+		ASSERT(!has(e));
+		if (e >= mSparseCap) {
+			reserveEntities(MAX(e + 1, 2 * mSparseCap));
+		}
+		if (mCount == mCap) {
+			reserve(MAX(2 * mCap, 16));
+		}
+		auto idx = mCount++;
+		mSparse[e] = idx;
+		mEntities[idx] = e;
+		return new(mRecords + idx) T(std::forward<Args>(args)...);
+	}
+
+	void remove(EntityID e)
+	{
+		ASSERT(has(e));
+		auto idx = mSparse[e];
+		mSparse[e] = kNone;
+		--mCount;
+		if (idx != (uint32_t)mCount) {
+			// fill "hole" with the last record
+			memcpy(mRecords + idx, mRecords + mCount, sizeof(T));
+			mEntities[idx] = mEntities[mCount];
+			mSparse[mEntities[idx]] = idx;
+		}
+	}
+
+	void clear()
+	{
+		for(int i=0; i<mCount; ++i) {
+			mSparse[mEntities[i]] = kNone;
+		}
+		mCount = 0;
+	}
+
+	void reserve(int capacity)
+	{
+		if (capacity <= mCap) { return; }
+		LP_MEMORY_DEFAULT_TAG(MEMORY_TAG_COLLECTIONS);
+
+		// records and their owning entities share one block
+		auto block = (uint8_t*) lpMalloc(capacity * (sizeof(T) + sizeof(EntityID)));
+		ASSERT(block);
+		auto records = (T*) block;
+		auto entities = (EntityID*) (records + capacity);
+		if (mCount > 0) {
+			memcpy(records, mRecords, mCount * sizeof(T));
+			memcpy(entities, mEntities, mCount * sizeof(EntityID));
+		}
+		lpFree(mRecords);
+		mRecords = records;
+		mEntities = entities;
+		mCap = capacity;
+	}
+
+	void reserveEntities(unsigned entityCapacity)
+	{
+		if (entityCapacity <= mSparseCap) { return; }
+		LP_MEMORY_DEFAULT_TAG(MEMORY_TAG_COLLECTIONS);
+		mSparse = (uint32_t*) lpRealloc(mSparse, entityCapacity * sizeof(uint32_t));
+		ASSERT(mSparse);
+		memset(mSparse + mSparseCap, 0xff, (entityCapacity - mSparseCap) * sizeof(uint32_t));
+		mSparseCap = entityCapacity;
+	}
+
+};
+
+// Calls func(entity, A*, B*, ...) for every entity which has all of the given
+// components.  Iterates the smallest store back-to-front, so it's safe for the
+// callback to remove the current entity's components (but not to add any).
+//
+//   lpJoin([](EntityID e, Body* body, Sprite* sprite) {
+//       sprite->setPosition(body->position);
+//   }, bodies, sprites);
+
+template<typename T>
+inline void lpJoinSmallest(const EntityID** outIds, int* outCount, ComponentStore<T>& store)
+{
+	if (store.count() < *outCount) {
+		*outCount = store.count();
+		*outIds = store.entities();
+	}
+}
+
+template<typename T, typename... Rest>
+inline void lpJoinSmallest(const EntityID** outIds, int* outCount, ComponentStore<T>& store, ComponentStore<Rest>&... rest)
+{
+	lpJoinSmallest(outIds, outCount, store);
+	lpJoinSmallest(outIds, outCount, rest...);
+}
+
+template<typename T>
+inline bool lpJoinHasAll(EntityID e, ComponentStore<T>& store) { return store.has(e); }
+
+template<typename T, typename... Rest>
+inline bool lpJoinHasAll(EntityID e, ComponentStore<T>& store, ComponentStore<Rest>&... rest)
+{
+	return store.has(e) && lpJoinHasAll(e, rest...);
+}
+
+template<typename Func, typename... Ts>
+void lpJoin(Func func, ComponentStore<Ts>&... stores)
+{
+	const EntityID* ids = 0;
+	int count = INT_MAX;
+	lpJoinSmallest(&ids, &count, stores...);
+	for(int i=count-1; i>=0; --i) {
+		auto e = ids[i];
+		if (lpJoinHasAll(e, stores...)) {
+			func(e, stores.get(e)...);
+		}
+	}
+}
@@ -0,0 +1,96 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include "base.h"
+
+//--------------------------------------------------------------------------------
+// FRAME PROFILER
+// Scoped zones record where each frame goes, for viewing in chrome://tracing
+// (or any other viewer which reads the Chrome trace JSON format).
+//
+//   void Level::tick() {
+//       LP_PROFILE_ZONE("level tick");
+//       ...
+//   }
+//
+// CPU zones are written to a ring buffer owned by the calling thread, so they
+// take no locks, and each thread keeps its last LP_PROFILER_CAPACITY zones.
+// GPU zones wrap a GL_TIME_ELAPSED query around a stretch of render calls (on
+// the GL thread only, and not nested); results are collected in
+// lpProfilerFrame() a few frames later, so it's never waited on.
+//
+// Zone names must be string literals (or otherwise outlive the trace).
+//
+// When built with LP_PROFILER, the library wraps plotter batches, rig and
+// particle ticks, and asset initialization in zones.  Without it the macros
+// expand to nothing.  The classes are always available, so tools can time
+// specific code regardless.
+
+#ifndef LP_PROFILER
+#define LP_PROFILER 0
+#endif
+
+#ifndef LP_PROFILER_CAPACITY
+#define LP_PROFILER_CAPACITY 16384
+#endif
+
+#ifndef LP_PROFILER_GPU_QUERIES
+#define LP_PROFILER_GPU_QUERIES 64
+#endif
+
+class ProfileZone {
+private:
+	const char* name;
+	uint64_t begin;
+
+public:
+	ProfileZone(const char* aName);
+	~ProfileZone();
+};
+
+class GPUProfileZone {
+private:
+	int slot;
+
+public:
+	GPUProfileZone(const char* name);
+	~GPUProfileZone();
+};
+
+#if LP_PROFILER
+#	define LP_PROFILE_ZONE(_name)      ProfileZone lpProfileZone__(_name)
+#	define LP_PROFILE_GPU_ZONE(_name)  GPUProfileZone lpGPUProfileZone__(_name)
+#else
+#	define LP_PROFILE_ZONE(_name)
+#	define LP_PROFILE_GPU_ZONE(_name)
+#endif
+
+// Recording can be paused at runtime, e.g. to only capture a problem section.
+void lpSetProfilerEnabled(bool enabled);
+bool lpProfilerEnabled();
+
+// Labels the calling thread's track in the trace.
+void lpSetProfilerThreadName(const char* name);
+
+// Call once per frame on the GL thread: marks the frame boundary and collects
+// finished GPU queries.
+void lpProfilerFrame();
+
+// Writes the zones recorded so far as a Chrome trace and discards them.  Only
+// one thread should export at a time.
+bool lpWriteProfilerTrace(const char* path);
+void lpClearProfiler();
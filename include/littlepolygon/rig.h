@@ -22,6 +22,8 @@
 #define kTimelineTranslation   1
 #define kTimelineRotation      2
 #define kTimelineScale         3
+#define kTimelineKindMask      0xff
+#define kTimelineQuantized     0x100
 
 //------------------------------------------------------------------------------
 // ASSETS
@@ -61,16 +63,39 @@ struct RigAnimationAsset
 {
 	uint32_t hash;
 	lpFloat  duration;
+	uint32_t firstTimeline; // timelines are grouped by animation
+	uint32_t ntimelines;
+};
+
+struct RigHashIndex
+{
+	uint32_t hash;
+	uint32_t index;
+};
+
+// Quantized timelines store 16-bit keys interleaved as (time, radians) or
+// (time, x, y), so that sampling a pair of keyframes only touches a single
+// cache line.  This is a size win: while the keys are in cache, dequantizing
+// them makes sampling about a quarter slower than with float keys.
+struct RigQuantization
+{
+	lpFloat timeScale; // seconds = timeScale * key
+	lpVec   offset;    // value = offset + scale * key
+	lpVec   scale;
 };
 
 struct RigTimelineAsset
 {
-	lpFloat* times;
 	union {
-		lpFloat* rotationValues;
-		lpVec*   translationValues;
-		lpVec*   scaleValues;
-		int*     attachmentValues;
+		lpFloat*  times;
+		uint16_t* packedKeys;
+	};
+	union {
+		lpFloat*         rotationValues;
+		lpVec*           translationValues;
+		lpVec*           scaleValues;
+		int*             attachmentValues;
+		RigQuantization* quantization;
 	};
 	uint32_t nkeyframes;
 	uint32_t animHash;
@@ -79,6 +104,9 @@ struct RigTimelineAsset
 		uint32_t slotIndex;
 	};
 	uint32_t kind;
+	
+	uint32_t type() const { return kind & kTimelineKindMask; }
+	bool quantized() const { return (kind & kTimelineQuantized) != 0; }
 };
 
 struct RigAsset
@@ -92,14 +120,45 @@ struct RigAsset
 	RigBoneAsset*       bones;
 	RigSlotAsset*       slots;
 	RigAttachmentAsset* attachments;
-	RigAnimationAsset*  anims;
+	RigAnimationAsset*  anims;      // sorted by hash
 	RigTimelineAsset*   timelines;
+	RigHashIndex*       boneLookup; // bone indices sorted by hash
+};
+
+//------------------------------------------------------------------------------
+// BAKED ANIMATION
+//
+// An animation pre-sampled into fixed-rate frames of root-relative bone
+// transforms.  Bakes are immutable, so one bake can be shared by every rig
+// playing it (e.g. a crowd of background characters), and playing one skips
+// timeline evaluation and the hierarchy walk entirely.  The frame rate trades
+// memory for fidelity, since transforms are lerped between frames.
+
+class RigBake {
+friend class Rig;
+private:
+	const RigAsset* asset;
+	const RigAnimationAsset* anim;
+	unsigned nbones;
+	unsigned nframes;
+	lpFloat frameDuration;
+	lpMatrix* frames;
+
+public:
+	RigBake(const RigAsset* anAsset, const char* animName, lpFloat framesPerSecond=30.0f);
+	~RigBake();
+	
+	bool isValid() const { return frames != 0; }
+	unsigned frameCount() const { return nframes; }
+	size_t rawSize() const { return nframes * nbones * sizeof(lpMatrix); }
+	const lpMatrix* frame(unsigned i) const { ASSERT(i < nframes); return frames + i * nbones; }
 };
 
 //------------------------------------------------------------------------------
 // RUNTIME CONTROLLER
 
 class Rig {
+friend class RigBake;
 private:
 	const RigAsset* data;
 
@@ -120,14 +179,22 @@ private:
 	lpMatrix* worldTransforms;
 	
 	// (indexed by timeline)
-	BitArray timelineMask;
+	unsigned timelineBegin, timelineEnd;
 	unsigned* currentKeyframes;
 	
-	RigAnimationAsset* currentAnimation;
+	// (draw list of attachments in the current layer)
+	unsigned nlayerAttachments;
+	unsigned* layerAttachments;
+	ImageAsset** layerImages;
+	lpMatrix* layerTransforms;
+	
+	const RigAnimationAsset* currentAnimation;
+	const RigBake* currentBake;
 	uint32_t currentLayer;
 	lpFloat currentTime;
 	
 	bool xformDirty;
+	bool layerDirty;
 	
 public:
 	Rig(const RigAsset* asset);
@@ -146,6 +213,7 @@ public:
 	void setRootTransform(const lpMatrix& mat, bool updateChildren=true);
 	void setLayer(const char *layerName);
 	void setAnimation(const char *animName);
+	void setAnimation(const RigBake* bake);
 	
 	// METHODS
 	
@@ -159,8 +227,10 @@ private:
 	
 	void setDefaultPose();
 	void computeWorldTransforms();
-	void updateTimeline(int i);
-	void applyTimeline(int i);
+	void sampleBake();
+	void updateLayerAttachments();
+	void sampleTimeline(int i, bool seek=true);
+	template<typename Keys> void sampleTimeline(int i, const Keys& keys, bool seek);
 	
 };
 
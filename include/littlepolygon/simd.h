@@ -0,0 +1,281 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+#include "math.h"
+
+//--------------------------------------------------------------------------------
+// PACKED VECTOR MATH
+// Four-lane versions of lpVec and lpMatrix in structure-of-arrays layout, for
+// hot loops which apply the same math to many vectors or transforms at once.
+// The backend is chosen at compile time: SSE2 on x86, NEON on ARM, and plain
+// arrays otherwise (which compilers are usually able to auto-vectorize).  Double
+// precision builds always use the plain fallback.
+//
+//   for(int i=0; i+4<=n; i+=4) {
+//       auto p = lpVec4x::load(positions + i);
+//       auto v = lpVec4x::load(velocities + i);
+//       (p + v * lpFloat4x::splat(dt)).store(positions + i);
+//   }
+//
+// The bulk kernels at the bottom operate directly on ordinary lpVec/lpMatrix
+// arrays, and use 8-wide AVX2 when the library is compiled with it enabled.
+
+#if !LITTLE_POLYGON_DOUBLES && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#	include <emmintrin.h>
+#	define LP_SIMD_SSE 1
+#	if defined(__AVX2__)
+#		include <immintrin.h>
+#		define LP_SIMD_AVX2 1
+#	endif
+#elif !LITTLE_POLYGON_DOUBLES && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#	include <arm_neon.h>
+#	define LP_SIMD_NEON 1
+#endif
+
+//--------------------------------------------------------------------------------
+// FLOAT LANES
+
+struct lpFloat4x {
+	#if LP_SIMD_SSE
+	__m128 v;
+	#elif LP_SIMD_NEON
+	float32x4_t v;
+	#else
+	lpFloat v[4];
+	#endif
+
+	lpFloat4x() {}
+
+	#if LP_SIMD_SSE
+	lpFloat4x(__m128 av) : v(av) {}
+	static lpFloat4x splat(lpFloat k) { return _mm_set1_ps(k); }
+	static lpFloat4x load(const lpFloat* p) { return _mm_loadu_ps(p); }
+	void store(lpFloat* p) const { _mm_storeu_ps(p, v); }
+	#elif LP_SIMD_NEON
+	lpFloat4x(float32x4_t av) : v(av) {}
+	static lpFloat4x splat(lpFloat k) { return vdupq_n_f32(k); }
+	static lpFloat4x load(const lpFloat* p) { return vld1q_f32(p); }
+	void store(lpFloat* p) const { vst1q_f32(p, v); }
+	#else
+	static lpFloat4x splat(lpFloat k) { lpFloat4x r; for(int i=0; i<4; ++i) { r.v[i] = k; } return r; }
+	static lpFloat4x load(const lpFloat* p) { lpFloat4x r; for(int i=0; i<4; ++i) { r.v[i] = p[i]; } return r; }
+	void store(lpFloat* p) const { for(int i=0; i<4; ++i) { p[i] = v[i]; } }
+	#endif
+
+	lpFloat lane(int i) const {
+		ASSERT(i >= 0 && i < 4);
+		lpFloat tmp[4];
+		store(tmp);
+		return tmp[i];
+	}
+};
+
+#if LP_SIMD_SSE
+
+inline lpFloat4x operator+(lpFloat4x a, lpFloat4x b) { return _mm_add_ps(a.v, b.v); }
+inline lpFloat4x operator-(lpFloat4x a, lpFloat4x b) { return _mm_sub_ps(a.v, b.v); }
+inline lpFloat4x operator*(lpFloat4x a, lpFloat4x b) { return _mm_mul_ps(a.v, b.v); }
+inline lpFloat4x operator/(lpFloat4x a, lpFloat4x b) { return _mm_div_ps(a.v, b.v); }
+inline lpFloat4x operator-(lpFloat4x a) { return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)); }
+inline lpFloat4x minimum(lpFloat4x a, lpFloat4x b) { return _mm_min_ps(a.v, b.v); }
+inline lpFloat4x maximum(lpFloat4x a, lpFloat4x b) { return _mm_max_ps(a.v, b.v); }
+
+#elif LP_SIMD_NEON
+
+inline lpFloat4x operator+(lpFloat4x a, lpFloat4x b) { return vaddq_f32(a.v, b.v); }
+inline lpFloat4x operator-(lpFloat4x a, lpFloat4x b) { return vsubq_f32(a.v, b.v); }
+inline lpFloat4x operator*(lpFloat4x a, lpFloat4x b) { return vmulq_f32(a.v, b.v); }
+inline lpFloat4x operator-(lpFloat4x a) { return vnegq_f32(a.v); }
+inline lpFloat4x minimum(lpFloat4x a, lpFloat4x b) { return vminq_f32(a.v, b.v); }
+inline lpFloat4x maximum(lpFloat4x a, lpFloat4x b) { return vmaxq_f32(a.v, b.v); }
+
+inline lpFloat4x operator/(lpFloat4x a, lpFloat4x b) {
+	#if defined(__aarch64__)
+	return vdivq_f32(a.v, b.v);
+	#else
+	// ARMv7 has no divide -- refine the reciprocal estimate twice
+	auto r = vrecpeq_f32(b.v);
+	r = vmulq_f32(vrecpsq_f32(b.v, r), r);
+	r = vmulq_f32(vrecpsq_f32(b.v, r), r);
+	return vmulq_f32(a.v, r);
+	#endif
+}
+
+#else
+
+#define LP_LANEWISE(_expr) { lpFloat4x r; for(int i=0; i<4; ++i) { r.v[i] = (_expr); } return r; }
+inline lpFloat4x operator+(lpFloat4x a, lpFloat4x b) LP_LANEWISE(a.v[i] + b.v[i])
+inline lpFloat4x operator-(lpFloat4x a, lpFloat4x b) LP_LANEWISE(a.v[i] - b.v[i])
+inline lpFloat4x operator*(lpFloat4x a, lpFloat4x b) LP_LANEWISE(a.v[i] * b.v[i])
+inline lpFloat4x operator/(lpFloat4x a, lpFloat4x b) LP_LANEWISE(a.v[i] / b.v[i])
+inline lpFloat4x operator-(lpFloat4x a) LP_LANEWISE(-a.v[i])
+inline lpFloat4x minimum(lpFloat4x a, lpFloat4x b) LP_LANEWISE(a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+inline lpFloat4x maximum(lpFloat4x a, lpFloat4x b) LP_LANEWISE(a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+#undef LP_LANEWISE
+
+#endif
+
+inline lpFloat4x lerp(lpFloat4x u, lpFloat4x v, lpFloat4x t) { return u + t * (v - u); }
+
+//--------------------------------------------------------------------------------
+// PACKED VEC2
+
+struct lpVec4x {
+	lpFloat4x x, y;
+
+	lpVec4x() {}
+	lpVec4x(lpFloat4x ax, lpFloat4x ay) : x(ax), y(ay) {}
+
+	static lpVec4x splat(lpVec p) { return lpVec4x(lpFloat4x::splat(p.x), lpFloat4x::splat(p.y)); }
+
+	// de-interleave from (and re-interleave to) four consecutive lpVecs
+	static lpVec4x load(const lpVec* p) {
+		#if LP_SIMD_SSE
+		auto lo = _mm_loadu_ps(&p[0].x);
+		auto hi = _mm_loadu_ps(&p[2].x);
+		return lpVec4x(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2,0,2,0)), _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3,1,3,1)));
+		#elif LP_SIMD_NEON
+		auto xy = vld2q_f32(&p[0].x);
+		return lpVec4x(xy.val[0], xy.val[1]);
+		#else
+		lpVec4x r;
+		for(int i=0; i<4; ++i) { r.x.v[i] = p[i].x; r.y.v[i] = p[i].y; }
+		return r;
+		#endif
+	}
+
+	void store(lpVec* p) const {
+		#if LP_SIMD_SSE
+		_mm_storeu_ps(&p[0].x, _mm_unpacklo_ps(x.v, y.v));
+		_mm_storeu_ps(&p[2].x, _mm_unpackhi_ps(x.v, y.v));
+		#elif LP_SIMD_NEON
+		float32x4x2_t xy = {{ x.v, y.v }};
+		vst2q_f32(&p[0].x, xy);
+		#else
+		for(int i=0; i<4; ++i) { p[i].x = x.v[i]; p[i].y = y.v[i]; }
+		#endif
+	}
+
+	lpVec lane(int i) const { return vec(x.lane(i), y.lane(i)); }
+
+	lpFloat4x norm() const { return x*x + y*y; }
+	lpVec4x anticlockwise() const { return lpVec4x(-y, x); }
+	lpVec4x clockwise() const { return lpVec4x(y, -x); }
+
+	lpVec4x operator+(lpVec4x q) const { return lpVec4x(x+q.x, y+q.y); }
+	lpVec4x operator-(lpVec4x q) const { return lpVec4x(x-q.x, y-q.y); }
+	lpVec4x operator*(lpVec4x q) const { return lpVec4x(x*q.x, y*q.y); }
+	lpVec4x operator/(lpVec4x q) const { return lpVec4x(x/q.x, y/q.y); }
+	lpVec4x operator-() const { return lpVec4x(-x, -y); }
+	lpVec4x operator*(lpFloat4x k) const { return lpVec4x(x*k, y*k); }
+
+	lpVec4x operator+=(lpVec4x q) { x=x+q.x; y=y+q.y; return *this; }
+	lpVec4x operator-=(lpVec4x q) { x=x-q.x; y=y-q.y; return *this; }
+	lpVec4x operator*=(lpFloat4x k) { x=x*k; y=y*k; return *this; }
+};
+
+inline lpFloat4x dot(lpVec4x u, lpVec4x v) { return u.x*v.x + u.y*v.y; }
+inline lpFloat4x cross(lpVec4x u, lpVec4x v) { return u.x*v.y - v.x*u.y; }
+inline lpVec4x lerp(lpVec4x u, lpVec4x v, lpFloat4x t) { return u + (v - u) * t; }
+inline lpVec4x minimum(lpVec4x u, lpVec4x v) { return lpVec4x(minimum(u.x, v.x), minimum(u.y, v.y)); }
+inline lpVec4x maximum(lpVec4x u, lpVec4x v) { return lpVec4x(maximum(u.x, v.x), maximum(u.y, v.y)); }
+
+//--------------------------------------------------------------------------------
+// PACKED AFFINE MATRIX
+
+struct lpMatrix4x {
+	lpVec4x u, v, t;
+
+	lpMatrix4x() {}
+	lpMatrix4x(lpVec4x au, lpVec4x av, lpVec4x at) : u(au), v(av), t(at) {}
+
+	static lpMatrix4x splat(const lpMatrix& m) { return lpMatrix4x(lpVec4x::splat(m.u), lpVec4x::splat(m.v), lpVec4x::splat(m.t)); }
+
+	// transposes four consecutive lpMatrix records through the stack
+	static lpMatrix4x load(const lpMatrix* m) {
+		lpFloat tmp[6][4];
+		for(int i=0; i<4; ++i) {
+			tmp[0][i] = m[i].u.x; tmp[1][i] = m[i].u.y;
+			tmp[2][i] = m[i].v.x; tmp[3][i] = m[i].v.y;
+			tmp[4][i] = m[i].t.x; tmp[5][i] = m[i].t.y;
+		}
+		return lpMatrix4x(
+			lpVec4x(lpFloat4x::load(tmp[0]), lpFloat4x::load(tmp[1])),
+			lpVec4x(lpFloat4x::load(tmp[2]), lpFloat4x::load(tmp[3])),
+			lpVec4x(lpFloat4x::load(tmp[4]), lpFloat4x::load(tmp[5]))
+		);
+	}
+
+	void store(lpMatrix* m) const {
+		lpFloat tmp[6][4];
+		u.x.store(tmp[0]); u.y.store(tmp[1]);
+		v.x.store(tmp[2]); v.y.store(tmp[3]);
+		t.x.store(tmp[4]); t.y.store(tmp[5]);
+		for(int i=0; i<4; ++i) {
+			m[i] = lpMatrix(vec(tmp[0][i], tmp[1][i]), vec(tmp[2][i], tmp[3][i]), vec(tmp[4][i], tmp[5][i]));
+		}
+	}
+
+	lpMatrix lane(int i) const { return lpMatrix(u.lane(i), v.lane(i), t.lane(i)); }
+
+	lpMatrix4x operator*(const lpMatrix4x& m) const {
+		return lpMatrix4x(
+			transformVector(m.u),
+			transformVector(m.v),
+			transformPoint(m.t)
+		);
+	}
+
+	lpVec4x transformPoint(lpVec4x p) const {
+		return lpVec4x(u.x*p.x + v.x*p.y + t.x,
+		               u.y*p.x + v.y*p.y + t.y);
+	}
+
+	lpVec4x transformVector(lpVec4x w) const {
+		return lpVec4x(u.x*w.x + v.x*w.y,
+		               u.y*w.x + v.y*w.y);
+	}
+
+	lpFloat4x determinant() const { return u.x*v.y - v.x*u.y; }
+};
+
+// componentwise, like lerp(lpMatrix)
+inline lpMatrix4x lerp(const lpMatrix4x& m0, const lpMatrix4x& m1, lpFloat4x t) {
+	return lpMatrix4x(lerp(m0.u, m1.u, t), lerp(m0.v, m1.v, t), lerp(m0.t, m1.t, t));
+}
+
+//--------------------------------------------------------------------------------
+// BULK KERNELS
+// These handle any count (with a scalar tail), and allow in-place operation
+// where the input and output are the same array.
+
+void lpTransformPoints(const lpMatrix& m, const lpVec* points, lpVec* outPoints, int count);
+void lpTransformVectors(const lpMatrix& m, const lpVec* vectors, lpVec* outVectors, int count);
+
+// outMatrices[i] = lhs[i] * rhs[i]
+void lpConcatMatrices(const lpMatrix* lhs, const lpMatrix* rhs, lpMatrix* outMatrices, int count);
+
+// returns false (leaving the outputs untouched) if there are no points
+bool lpComputeAABB(const lpVec* points, int count, lpVec* outMin, lpVec* outMax);
+
+void lpLerp(const lpFloat* u, const lpFloat* v, lpFloat t, lpFloat* outValues, int count);
+inline void lpLerp(const lpVec* u, const lpVec* v, lpFloat t, lpVec* outVecs, int count) {
+	lpLerp(&u->x, &v->x, t, &outVecs->x, count << 1);
+}
+inline void lpLerp(const lpMatrix* m0, const lpMatrix* m1, lpFloat t, lpMatrix* outMatrices, int count) {
+	lpLerp(&m0->u.x, &m1->u.x, t, &outMatrices->u.x, 6 * count);
+}
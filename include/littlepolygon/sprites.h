@@ -143,6 +143,7 @@ private:
 	GLuint elementBuf;
 	
 	TextureAsset *workingTexture;
+	PlotterStats mStats;
 
 public:
 	SpritePlotter(Plotter *plotter);
@@ -152,6 +153,9 @@ public:
 	bool isBound() const { return count >= 0; }
 	const Viewport& viewport() const { return view; }
 
+	const PlotterStats& stats() const { return mStats; }
+	void resetStats() { mStats.reset(); }
+
 	// Call this method to initialize the graphics context state.  Asserts that the plotter
 	// is already bound (in case you're coalescing with other plotters) and state e.g. blending are
 	// enabled.  Any additional state changes can be set *after* this function but *before*
@@ -166,11 +170,21 @@ public:
 	void drawImage(ImageAsset *image, lpVec position, lpVec u, int frame=0, Color color=rgba(0), Color tint=rgba(0xffffffff));
 	void drawImage(ImageAsset *image, const lpMatrix& xform, int frame=0, Color color=rgba(0), Color tint=rgba(0xffffffff));
 	void drawQuad(ImageAsset *image, lpVec p0, lpVec p1, lpVec p2, lpVec p3, int frame=0, Color color=rgba(0), Color tint=rgba(0xffffffff));
+
+	// Bulk path for drawing many images with precomputed transforms (e.g. the
+	// attachments of a rig) in one call.  Always uses the first frame.  Runs of
+	// visible images which share an atlas are written straight into the batch,
+	// with one atlas and capacity check per run rather than per image.
+	void drawImages(int count, ImageAsset* const* images, const lpMatrix* xforms, Color color=rgba(0), Color tint=rgba(0xffffffff));
 	void drawLabel(FontAsset *font, lpVec p, Color c, const char *msg, Color tint=rgba(0xffffffff));
 	void drawLabelCentered(FontAsset *font, lpVec p, Color c, const char *msg, Color tint=rgba(0xffffffff));
 	void drawLabelRightJustified(FontAsset *font, lpVec p, Color c, const char *msg, Color tint=rgba(0xffffffff));
 	void drawTilemap(TilemapAsset *map, lpVec position=vec(0,0), Color tint=rgba(0xffffffff));
 
+	// Debug overlay listing the given counts (e.g. a snapshot of the previous
+	// frame's stats, so that the overlay isn't counting itself mid-frame).
+	void drawStats(FontAsset *font, lpVec p, Color c, const PlotterStats& stats, Color tint=rgba(0xffffffff));
+
 	// if you want to monkey with the global rendering state (e.g. change blending settings)
 	// you need to flush the render queue first.
 	void flush();
@@ -182,7 +196,7 @@ public:
 private:
 	Vertex *nextSlice() { return plotter->getVertex(count<<2); }
 	void setTextureAtlas(TextureAsset* texture);
-	void commitBatch();
+	void commitBatch(FlushReason reason);
 	void plotGlyph(const GlyphAsset& g, lpFloat x, lpFloat y, lpFloat h, Color c, Color t);
 
 };
@@ -245,5 +259,62 @@ struct Sprite
 typedef BatchPool<Sprite> SpriteBatch;
 typedef BatchHandle<Sprite> SpriteHandle;
 
+//------------------------------------------------------------------------------
+// SPRITE GRID
+//
+// A loose uniform grid over the sprites in a SpriteBatch, so that drawing a big
+// world only visits the cells which overlap the viewport, rather than testing
+// every sprite.  Each sprite is filed under the cell containing its position,
+// and queries are padded by the largest sprite extent seen, so sprites can
+// overhang their cell.  Positions outside the grid go in the edge cells.
+//
+// The grid doesn't observe the batch -- tell it when sprites are added, moved
+// (or rotated or scaled), and removed:
+//
+//   auto h = batch.alloc(image, position);
+//   grid.insert(h);
+//   h->setPosition(newPosition);
+//   grid.update(h);
+//   grid.remove(h);
+//   batch.release(h);
+//
+// Sprites are drawn cell-by-cell, so the draw order of overlapping sprites
+// isn't preserved.  Use it for layers where that doesn't matter.
+
+class SpriteGrid {
+private:
+	SpriteBatch *batch;
+	lpVec origin, invCellSize, maxExtent;
+	int cols, rows;
+	SpriteHandle *handles;
+	int *heads;     // first entry in each cell
+	int *next;      // links between entries in the same cell
+	int *prev;
+	int *cellOf;    // -1 for sprites not in the grid
+
+	SpriteGrid(const SpriteGrid&);
+	SpriteGrid& operator=(const SpriteGrid&);
+
+public:
+	SpriteGrid(SpriteBatch *batch, lpVec origin, lpVec cellSize, int cols, int rows);
+	~SpriteGrid();
+
+	void insert(SpriteHandle h);
+	void update(SpriteHandle h);
+	void remove(SpriteHandle h);
+	void clear();
+
+	bool contains(SpriteHandle h) const { return cellOf[batch->indexOf(h)] >= 0; }
+
+	// draws the sprites which might overlap the plotter's viewport
+	void draw(SpritePlotter *plotter);
+
+private:
+	int cellAt(lpVec p) const;
+	void link(int i, int cell);
+	void unlink(int i);
+	void growExtent(const Sprite& sprite);
+};
+
 
 
@@ -0,0 +1,736 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "littlepolygon/allocators.h"
+
+#ifndef LP_SCRATCH_CAPACITY
+#define LP_SCRATCH_CAPACITY (1024 * 1024)
+#endif
+
+#define NO_BLOCK ((size_t)-1)
+
+static inline size_t alignedSize(size_t size)
+{
+	return (size + LP_ALLOC_ALIGNMENT - 1) & ~(size_t)(LP_ALLOC_ALIGNMENT - 1);
+}
+
+//--------------------------------------------------------------------------------
+// REGISTRY
+
+static SDL_SpinLock sRegistryLock = 0;
+static Allocator* sFirstAllocator = 0;
+static Allocator* sDefaultAllocator = 0;
+
+Allocator::Allocator(const char* name) : mName(name), mPrev(0)
+{
+	memset(&mStats, 0, sizeof(mStats));
+	SDL_AtomicLock(&sRegistryLock);
+	mNext = sFirstAllocator;
+	if (mNext) { mNext->mPrev = this; }
+	sFirstAllocator = this;
+	SDL_AtomicUnlock(&sRegistryLock);
+}
+
+Allocator::~Allocator()
+{
+	SDL_AtomicLock(&sRegistryLock);
+	if (mPrev) { mPrev->mNext = mNext; } else { sFirstAllocator = mNext; }
+	if (mNext) { mNext->mPrev = mPrev; }
+	SDL_AtomicUnlock(&sRegistryLock);
+}
+
+void* Allocator::calloc(size_t count, size_t size)
+{
+	auto result = alloc(count * size);
+	if (result) {
+		memset(result, 0, count * size);
+	}
+	return result;
+}
+
+void lpVisitAllocators(AllocatorVisitor visitor, void* context)
+{
+	SDL_AtomicLock(&sRegistryLock);
+	for(auto p=sFirstAllocator; p; p=p->next()) {
+		visitor(p, context);
+	}
+	SDL_AtomicUnlock(&sRegistryLock);
+}
+
+#if DEBUG
+static void logStats(Allocator* allocator, void*)
+{
+	auto& stats = allocator->stats();
+	LOG((
+		"%-10s inUse=%lu peak=%lu reserved=%lu allocs=%u releases=%u overflows=%u\n",
+		allocator->name(),
+		(unsigned long) stats.bytesInUse,
+		(unsigned long) stats.peakBytes,
+		(unsigned long) stats.reservedBytes,
+		stats.allocCount,
+		stats.releaseCount,
+		stats.overflowCount
+	));
+}
+#endif
+
+void lpLogAllocatorStats()
+{
+	#if DEBUG
+	lpVisitAllocators(logStats);
+	#endif
+}
+
+//--------------------------------------------------------------------------------
+// DEFAULT ALLOCATOR
+
+union TrackingHeader {
+	struct {
+		size_t size;
+		MemoryTag tag;
+	} info;
+	uint8_t padding[LP_ALLOC_ALIGNMENT];
+};
+
+Allocator* lpDefaultAllocator()
+{
+	if (!sDefaultAllocator) {
+		// constructed in static storage and never destroyed, so that it's safe to
+		// release memory from other static destructors
+		static union { uint8_t bytes[sizeof(HeapAllocator)]; void* align; } storage;
+		static HeapAllocator* heap = new(storage.bytes) HeapAllocator("heap");
+		sDefaultAllocator = heap;
+	}
+	return sDefaultAllocator;
+}
+
+void lpSetDefaultAllocator(Allocator* allocator)
+{
+	ASSERT(allocator);
+	ASSERT(lpDefaultAllocator()->stats().allocCount == 0);
+	sDefaultAllocator = allocator;
+}
+
+#if LP_MEMORY_TRACKING
+
+static void* trackAlloc(void* block, size_t size, MemoryTag tag);
+static void* untrackAlloc(void* ptr, size_t* outSize, MemoryTag* outTag);
+
+void* lpMalloc(size_t size)
+{
+	return trackAlloc(lpDefaultAllocator()->alloc(sizeof(TrackingHeader) + size), size, lpCurrentMemoryTag());
+}
+
+void* lpRealloc(void* ptr, size_t size)
+{
+	if (!ptr) {
+		return lpMalloc(size);
+	}
+	
+	// resized blocks keep their original tag
+	size_t oldSize;
+	MemoryTag tag;
+	auto block = untrackAlloc(ptr, &oldSize, &tag);
+	auto result = lpDefaultAllocator()->realloc(block, sizeof(TrackingHeader) + size);
+	if (!result) {
+		// the original block is still live
+		trackAlloc(block, oldSize, tag);
+		return 0;
+	}
+	return trackAlloc(result, size, tag);
+}
+
+void* lpCalloc(size_t count, size_t size)
+{
+	auto result = lpMalloc(count * size);
+	if (result) {
+		memset(result, 0, count * size);
+	}
+	return result;
+}
+
+void lpFree(void* ptr)
+{
+	if (ptr) {
+		lpDefaultAllocator()->release(untrackAlloc(ptr, 0, 0));
+	}
+}
+
+#else
+
+void* lpMalloc(size_t size)
+{
+	return lpDefaultAllocator()->alloc(size);
+}
+
+void* lpRealloc(void* ptr, size_t size)
+{
+	return lpDefaultAllocator()->realloc(ptr, size);
+}
+
+void* lpCalloc(size_t count, size_t size)
+{
+	return lpDefaultAllocator()->calloc(count, size);
+}
+
+void lpFree(void* ptr)
+{
+	if (ptr) {
+		lpDefaultAllocator()->release(ptr);
+	}
+}
+
+#endif
+
+//--------------------------------------------------------------------------------
+// SYSTEM HEAP
+
+union HeapHeader {
+	size_t size;
+	uint8_t padding[LP_ALLOC_ALIGNMENT];
+};
+
+HeapAllocator::HeapAllocator(const char* name) : Allocator(name), mLock(0)
+{
+}
+
+void* HeapAllocator::alloc(size_t size)
+{
+	auto header = (HeapHeader*) malloc(sizeof(HeapHeader) + size);
+	if (!header) {
+		return 0;
+	}
+	header->size = size;
+	SDL_AtomicLock(&mLock);
+	recordAlloc(size);
+	mStats.reservedBytes = mStats.bytesInUse;
+	SDL_AtomicUnlock(&mLock);
+	return header + 1;
+}
+
+void* HeapAllocator::realloc(void* ptr, size_t size)
+{
+	if (!ptr) {
+		return alloc(size);
+	}
+	auto header = ((HeapHeader*)ptr) - 1;
+	auto oldSize = header->size;
+	header = (HeapHeader*) ::realloc(header, sizeof(HeapHeader) + size);
+	if (!header) {
+		return 0;
+	}
+	header->size = size;
+	SDL_AtomicLock(&mLock);
+	recordRelease(oldSize);
+	recordAlloc(size);
+	mStats.releaseCount--;
+	mStats.reservedBytes = mStats.bytesInUse;
+	SDL_AtomicUnlock(&mLock);
+	return header + 1;
+}
+
+void HeapAllocator::release(void* ptr)
+{
+	if (!ptr) {
+		return;
+	}
+	auto header = ((HeapHeader*)ptr) - 1;
+	SDL_AtomicLock(&mLock);
+	recordRelease(header->size);
+	mStats.reservedBytes = mStats.bytesInUse;
+	SDL_AtomicUnlock(&mLock);
+	free(header);
+}
+
+//--------------------------------------------------------------------------------
+// LINEAR ALLOCATOR
+
+union LinearHeader {
+	struct {
+		size_t size;
+		size_t prevTop;
+	} info;
+	uint8_t padding[LP_ALLOC_ALIGNMENT];
+};
+
+union OverflowHeader {
+	struct {
+		OverflowHeader* next;
+		size_t size;
+		size_t spill;
+	} info;
+	uint8_t padding[2 * LP_ALLOC_ALIGNMENT];
+};
+
+LinearAllocator::LinearAllocator(const char* name, size_t capacity) :
+Allocator(name),
+mBuffer((uint8_t*) malloc(alignedSize(capacity))),
+mCapacity(alignedSize(capacity)),
+mOffset(0),
+mTop(NO_BLOCK),
+mOverflow(0),
+mOverflowBytes(0),
+mSpills(0)
+{
+	ASSERT(mBuffer);
+	mStats.reservedBytes = mCapacity;
+}
+
+LinearAllocator::~LinearAllocator()
+{
+	reset();
+	free(mBuffer);
+}
+
+void* LinearAllocator::alloc(size_t size)
+{
+	++mStats.allocCount;
+	auto blockBytes = sizeof(LinearHeader) + alignedSize(size);
+	if (mOffset + blockBytes <= mCapacity) {
+		auto header = (LinearHeader*)(mBuffer + mOffset);
+		header->info.size = size;
+		header->info.prevTop = mTop;
+		mTop = mOffset;
+		mOffset += blockBytes;
+		updateUsage();
+		return header + 1;
+	}
+
+	// spill over to the system heap
+	auto header = (OverflowHeader*) malloc(sizeof(OverflowHeader) + size);
+	if (!header) {
+		return 0;
+	}
+	header->info.next = (OverflowHeader*) mOverflow;
+	header->info.size = size;
+	header->info.spill = mSpills++;
+	mOverflow = header;
+	mOverflowBytes += size;
+	++mStats.overflowCount;
+	updateUsage();
+	return header + 1;
+}
+
+void* LinearAllocator::realloc(void* ptr, size_t size)
+{
+	if (!ptr) {
+		return alloc(size);
+	}
+
+	// the most recent block can be resized in-place
+	if (owns(ptr)) {
+		auto header = ((LinearHeader*)ptr) - 1;
+		auto offset = (size_t)((uint8_t*)header - mBuffer);
+		auto end = offset + sizeof(LinearHeader) + alignedSize(size);
+		if (offset == mTop && end <= mCapacity) {
+			header->info.size = size;
+			mOffset = end;
+			++mStats.allocCount;
+			updateUsage();
+			return ptr;
+		}
+	}
+
+	auto result = alloc(size);
+	if (result) {
+		memcpy(result, ptr, MIN(size, blockSize(ptr)));
+		release(ptr);
+	}
+	return result;
+}
+
+void LinearAllocator::release(void* ptr)
+{
+	if (!ptr) {
+		return;
+	}
+	++mStats.releaseCount;
+	if (owns(ptr)) {
+		// only the most recent block is reclaimed immediately
+		auto header = ((LinearHeader*)ptr) - 1;
+		if ((size_t)((uint8_t*)header - mBuffer) == mTop) {
+			mOffset = mTop;
+			mTop = header->info.prevTop;
+			updateUsage();
+		}
+	} else {
+		// spilled blocks are freed right away, wherever they are in the chain
+		// (realloc() pushes the new block before releasing the old one)
+		auto header = ((OverflowHeader*)ptr) - 1;
+		if (header == mOverflow) {
+			mOverflow = header->info.next;
+		} else {
+			auto prev = (OverflowHeader*) mOverflow;
+			while(prev->info.next != header) {
+				ASSERT(prev->info.next);
+				prev = prev->info.next;
+			}
+			prev->info.next = header->info.next;
+		}
+		mOverflowBytes -= header->info.size;
+		free(header);
+		updateUsage();
+	}
+}
+
+void LinearAllocator::reset()
+{
+	Mark m = { 0, NO_BLOCK, 0 };
+	rewind(m);
+}
+
+LinearAllocator::Mark LinearAllocator::mark() const
+{
+	Mark result = { mOffset, mTop, mSpills };
+	return result;
+}
+
+void LinearAllocator::rewind(Mark m)
+{
+	ASSERT(m.offset <= mOffset);
+	// spilled blocks may have been released out of order, so they're compared
+	// by number rather than by address
+	while(mOverflow && ((OverflowHeader*) mOverflow)->info.spill >= m.spills) {
+		auto header = (OverflowHeader*) mOverflow;
+		mOverflow = header->info.next;
+		mOverflowBytes -= header->info.size;
+		free(header);
+	}
+	mOffset = m.offset;
+	mTop = m.top;
+	updateUsage();
+}
+
+size_t LinearAllocator::blockSize(void* ptr) const
+{
+	return owns(ptr) ?
+		(((LinearHeader*)ptr) - 1)->info.size :
+		(((OverflowHeader*)ptr) - 1)->info.size;
+}
+
+void LinearAllocator::updateUsage()
+{
+	mStats.bytesInUse = mOffset + mOverflowBytes;
+	mStats.reservedBytes = mCapacity + mOverflowBytes;
+	if (mStats.bytesInUse > mStats.peakBytes) {
+		mStats.peakBytes = mStats.bytesInUse;
+	}
+}
+
+// The scratch stack has a constructor, so it can't be LP_THREAD_LOCAL itself.
+// Each thread caches a pointer to its own, which is also registered with SDL's
+// TLS to be destroyed when the thread exits.
+
+static SDL_SpinLock sScratchLock = 0;
+static SDL_TLSID sScratchID = 0;
+static LP_THREAD_LOCAL LinearAllocator* tScratch = 0;
+
+static void SDLCALL destroyScratch(void* scratch)
+{
+	auto allocator = (LinearAllocator*) scratch;
+	allocator->~LinearAllocator();
+	free(allocator);
+}
+
+LinearAllocator& lpScratch()
+{
+	if (!tScratch) {
+		SDL_AtomicLock(&sScratchLock);
+		if (!sScratchID) {
+			sScratchID = SDL_TLSCreate();
+		}
+		SDL_AtomicUnlock(&sScratchLock);
+		tScratch = new(malloc(sizeof(LinearAllocator))) LinearAllocator("scratch", LP_SCRATCH_CAPACITY);
+		SDL_TLSSet(sScratchID, tScratch, destroyScratch);
+	}
+	return *tScratch;
+}
+
+//--------------------------------------------------------------------------------
+// SIZE-CLASS POOLS
+
+#define LARGE_BLOCK (-1)
+
+union PoolHeader {
+	struct {
+		size_t size;
+		int sizeClass;
+	} info;
+	uint8_t padding[LP_ALLOC_ALIGNMENT];
+};
+
+static inline size_t classBlockSize(int sizeClass)
+{
+	return size_t(PoolAllocator::kMinBlockSize) << sizeClass;
+}
+
+static inline int sizeClassFor(size_t size)
+{
+	auto total = sizeof(PoolHeader) + size;
+	int result = 0;
+	while(result < PoolAllocator::kSizeClassCount && classBlockSize(result) < total) {
+		++result;
+	}
+	return result < PoolAllocator::kSizeClassCount ? result : LARGE_BLOCK;
+}
+
+PoolAllocator::PoolAllocator(const char* name) : Allocator(name), mLock(0), mPages(0)
+{
+	memset(mFreelists, 0, sizeof(mFreelists));
+}
+
+PoolAllocator::~PoolAllocator()
+{
+	ASSERT(mStats.bytesInUse == 0);
+	while(mPages) {
+		auto page = mPages;
+		mPages = *(void**)page;
+		free(page);
+	}
+}
+
+void* PoolAllocator::allocBlock(int sizeClass)
+{
+	if (!mFreelists[sizeClass]) {
+		// carve a new page into blocks, reserving the first slot for the page link
+		auto page = (uint8_t*) malloc(kPageSize);
+		if (!page) {
+			return 0;
+		}
+		*(void**)page = mPages;
+		mPages = page;
+		mStats.reservedBytes += kPageSize;
+		auto blockBytes = classBlockSize(sizeClass);
+		for(auto p=page+LP_ALLOC_ALIGNMENT; p+blockBytes<=page+kPageSize; p+=blockBytes) {
+			*(void**)p = mFreelists[sizeClass];
+			mFreelists[sizeClass] = p;
+		}
+	}
+	auto result = mFreelists[sizeClass];
+	mFreelists[sizeClass] = *(void**)result;
+	return result;
+}
+
+void* PoolAllocator::alloc(size_t size)
+{
+	auto sizeClass = sizeClassFor(size);
+	PoolHeader* header;
+	SDL_AtomicLock(&mLock);
+	if (sizeClass == LARGE_BLOCK) {
+		header = (PoolHeader*) malloc(sizeof(PoolHeader) + size);
+		if (header) {
+			++mStats.overflowCount;
+			mStats.reservedBytes += size;
+		}
+	} else {
+		header = (PoolHeader*) allocBlock(sizeClass);
+	}
+	if (header) {
+		header->info.size = size;
+		header->info.sizeClass = sizeClass;
+		recordAlloc(size);
+	}
+	SDL_AtomicUnlock(&mLock);
+	return header ? header + 1 : 0;
+}
+
+void* PoolAllocator::realloc(void* ptr, size_t size)
+{
+	if (!ptr) {
+		return alloc(size);
+	}
+
+	// resize in-place if the block is still the right size class
+	auto header = ((PoolHeader*)ptr) - 1;
+	if (header->info.sizeClass != LARGE_BLOCK && sizeClassFor(size) == header->info.sizeClass) {
+		SDL_AtomicLock(&mLock);
+		recordRelease(header->info.size);
+		recordAlloc(size);
+		mStats.releaseCount--;
+		header->info.size = size;
+		SDL_AtomicUnlock(&mLock);
+		return ptr;
+	}
+
+	auto result = alloc(size);
+	if (result) {
+		memcpy(result, ptr, MIN(size, header->info.size));
+		release(ptr);
+	}
+	return result;
+}
+
+void PoolAllocator::release(void* ptr)
+{
+	if (!ptr) {
+		return;
+	}
+	auto header = ((PoolHeader*)ptr) - 1;
+	SDL_AtomicLock(&mLock);
+	recordRelease(header->info.size);
+	if (header->info.sizeClass == LARGE_BLOCK) {
+		mStats.reservedBytes -= header->info.size;
+		free(header);
+	} else {
+		*(void**)header = mFreelists[header->info.sizeClass];
+		mFreelists[header->info.sizeClass] = header;
+	}
+	SDL_AtomicUnlock(&mLock);
+}
+
+//--------------------------------------------------------------------------------
+// ALLOCATION TRACKING
+
+static SDL_SpinLock sTrackingLock = 0;
+static MemoryTagStats sTagStats[MEMORY_TAG_COUNT];
+static LP_THREAD_LOCAL MemoryTag sCurrentTag = MEMORY_TAG_GENERAL;
+
+static const char* sTagNames[MEMORY_TAG_COUNT] = {
+	"general",
+	"assets",
+	"sprites",
+	"rig",
+	"particles",
+	"collections"
+};
+
+MemoryTagScope::MemoryTagScope(MemoryTag tag, bool overrideEnclosing) : prevTag(sCurrentTag)
+{
+	if (overrideEnclosing || sCurrentTag == MEMORY_TAG_GENERAL) {
+		sCurrentTag = tag;
+	}
+}
+
+MemoryTagScope::~MemoryTagScope()
+{
+	sCurrentTag = prevTag;
+}
+
+#if LP_MEMORY_TRACKING
+
+static void* trackAlloc(void* block, size_t size, MemoryTag tag)
+{
+	if (!block) {
+		return 0;
+	}
+	auto header = (TrackingHeader*) block;
+	header->info.size = size;
+	header->info.tag = tag;
+	
+	SDL_AtomicLock(&sTrackingLock);
+	auto& stats = sTagStats[tag];
+	stats.bytes += size;
+	stats.count++;
+	if (stats.bytes > stats.peakBytes) { stats.peakBytes = stats.bytes; }
+	if (stats.count > stats.peakCount) { stats.peakCount = stats.count; }
+	bool overBudget = stats.budget && stats.bytes > stats.budget;
+	if (overBudget) { stats.overBudget++; }
+	SDL_AtomicUnlock(&sTrackingLock);
+	
+	if (overBudget) {
+		LOG(("Memory budget exceeded for \"%s\" (%lu bytes)\n", sTagNames[tag], (unsigned long) stats.bytes));
+		ASSERT(false);
+	}
+	return header + 1;
+}
+
+static void* untrackAlloc(void* ptr, size_t* outSize, MemoryTag* outTag)
+{
+	auto header = ((TrackingHeader*)ptr) - 1;
+	SDL_AtomicLock(&sTrackingLock);
+	auto& stats = sTagStats[header->info.tag];
+	ASSERT(stats.bytes >= header->info.size);
+	ASSERT(stats.count > 0);
+	stats.bytes -= header->info.size;
+	stats.count--;
+	SDL_AtomicUnlock(&sTrackingLock);
+	if (outSize) { *outSize = header->info.size; }
+	if (outTag) { *outTag = header->info.tag; }
+	return header;
+}
+
+#endif
+
+const char* lpMemoryTagName(MemoryTag tag)
+{
+	ASSERT(tag >= 0 && tag < MEMORY_TAG_COUNT);
+	return sTagNames[tag];
+}
+
+MemoryTag lpCurrentMemoryTag()
+{
+	return sCurrentTag;
+}
+
+MemoryTagStats lpMemoryTagStats(MemoryTag tag)
+{
+	ASSERT(tag >= 0 && tag < MEMORY_TAG_COUNT);
+	SDL_AtomicLock(&sTrackingLock);
+	auto result = sTagStats[tag];
+	SDL_AtomicUnlock(&sTrackingLock);
+	return result;
+}
+
+void lpSetMemoryBudget(MemoryTag tag, size_t bytes)
+{
+	ASSERT(tag >= 0 && tag < MEMORY_TAG_COUNT);
+	SDL_AtomicLock(&sTrackingLock);
+	sTagStats[tag].budget = bytes;
+	SDL_AtomicUnlock(&sTrackingLock);
+}
+
+bool lpMemoryWithinBudgets()
+{
+	bool result = true;
+	SDL_AtomicLock(&sTrackingLock);
+	for(int i=0; i<MEMORY_TAG_COUNT; ++i) {
+		if (sTagStats[i].overBudget) {
+			result = false;
+		}
+	}
+	SDL_AtomicUnlock(&sTrackingLock);
+	return result;
+}
+
+void lpResetMemoryPeaks()
+{
+	SDL_AtomicLock(&sTrackingLock);
+	for(int i=0; i<MEMORY_TAG_COUNT; ++i) {
+		sTagStats[i].peakBytes = sTagStats[i].bytes;
+		sTagStats[i].peakCount = sTagStats[i].count;
+		sTagStats[i].overBudget = 0;
+	}
+	SDL_AtomicUnlock(&sTrackingLock);
+}
+
+void lpLogMemoryTags()
+{
+	#if DEBUG
+	for(int i=0; i<MEMORY_TAG_COUNT; ++i) {
+		auto stats = lpMemoryTagStats(MemoryTag(i));
+		LOG((
+			"%-12s bytes=%lu peak=%lu budget=%lu count=%u peakCount=%u overBudget=%u\n",
+			sTagNames[i],
+			(unsigned long) stats.bytes,
+			(unsigned long) stats.peakBytes,
+			(unsigned long) stats.budget,
+			stats.count,
+			stats.peakCount,
+			stats.overBudget
+		));
+	}
+	#endif
+}
@@ -15,6 +15,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "littlepolygon/assets.h"
+#include "littlepolygon/profiler.h"
 
 struct AssetHeader {
 	uint32_t hash, type;
@@ -46,9 +47,10 @@ AssetBundle::AssetBundle(const char* path, uint32_t crc) : data(0), fallback(0)
 	int count = SDL_ReadLE32(file);
 
 	// read data
+	LP_MEMORY_TAG(MEMORY_TAG_ASSETS);
 	data = (AssetData*) lpMalloc(sizeof(AssetData)-sizeof(AssetHeader) + length);
 	void *result = &(data->headers);
-	if (SDL_RWread(file, result, length, 1) == -1) {
+	if (SDL_RWread(file, result, length, 1) != 1) {
 		lpFree(data);
 		SDL_RWclose(file);
 		data = 0;
@@ -106,6 +108,7 @@ void AssetBundle::setFallback(AssetBundle *aFallback)
 
 void AssetBundle::init()
 {
+	LP_PROFILE_ZONE("asset bundle init");
 	if (data && data->assetCount) { 
 		for(unsigned i=0; i<data->assetCount; ++i) {
 			switch(data->headers[i].type) {
@@ -16,72 +16,259 @@
 
 #include "littlepolygon/collections.h"
 
+#if defined(__SSE2__) || defined(_M_X64)
+#	include <emmintrin.h>
+#	define BITARRAY_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#	include <arm_neon.h>
+#	define BITARRAY_NEON 1
+#endif
+
+//--------------------------------------------------------------------------------
+// WORD KERNELS
+// Two words per step with SSE2/NEON, then a scalar tail.
+
+enum BitOp { BIT_AND, BIT_OR, BIT_XOR, BIT_ANDNOT };
+
+template<BitOp op>
+static inline uint64_t applyWord(uint64_t a, uint64_t b)
+{
+	switch(op) {
+		case BIT_AND: return a & b;
+		case BIT_OR: return a | b;
+		case BIT_XOR: return a ^ b;
+		default: return a & ~b;
+	}
+}
+
+template<BitOp op>
+static void applyWords(uint64_t* dst, const uint64_t* src, unsigned n)
+{
+	unsigned i = 0;
+	#if BITARRAY_SSE2
+	for(; i+2<=n; i+=2) {
+		auto a = _mm_loadu_si128((const __m128i*)(dst + i));
+		auto b = _mm_loadu_si128((const __m128i*)(src + i));
+		switch(op) {
+			case BIT_AND: a = _mm_and_si128(a, b); break;
+			case BIT_OR: a = _mm_or_si128(a, b); break;
+			case BIT_XOR: a = _mm_xor_si128(a, b); break;
+			default: a = _mm_andnot_si128(b, a); break;
+		}
+		_mm_storeu_si128((__m128i*)(dst + i), a);
+	}
+	#elif BITARRAY_NEON
+	for(; i+2<=n; i+=2) {
+		auto a = vld1q_u64(dst + i);
+		auto b = vld1q_u64(src + i);
+		switch(op) {
+			case BIT_AND: a = vandq_u64(a, b); break;
+			case BIT_OR: a = vorrq_u64(a, b); break;
+			case BIT_XOR: a = veorq_u64(a, b); break;
+			default: a = vbicq_u64(a, b); break;
+		}
+		vst1q_u64(dst + i, a);
+	}
+	#endif
+	for(; i<n; ++i) {
+		dst[i] = applyWord<op>(dst[i], src[i]);
+	}
+}
+
+//--------------------------------------------------------------------------------
+// BIT ARRAY
+
 BitArray::BitArray(unsigned cap) :
-capacity(cap), words(cap)
+capacity(cap), words((cap + 63) >> 6)
 {
 }
 
 void BitArray::clear()
 {
-	memset(words.ptr(), 0, nwords() * sizeof(uint32_t));
+	memset(words.ptr(), 0, nwords() * sizeof(uint64_t));
 }
 
 void BitArray::clear(unsigned i)
 {
-	unsigned word, local; getIndices(i, &word, &local);
-	words[word] &= ~bit(local);
+	ASSERT(i < capacity);
+	words[i >> 6] &= ~bit(i);
 }
 
 void BitArray::mark(unsigned i)
 {
-	unsigned word, local; getIndices(i, &word, &local);
-	words[word] |= bit(local);
+	ASSERT(i < capacity);
+	words[i >> 6] |= bit(i);
+}
+
+void BitArray::markAll()
+{
+	memset(words.ptr(), 0xff, nwords() * sizeof(uint64_t));
+	trimTail();
+}
+
+void BitArray::markRange(unsigned begin, unsigned end)
+{
+	ASSERT(begin <= end && end <= capacity);
+	if (begin == end) { return; }
+	auto first = begin >> 6;
+	auto last = (end - 1) >> 6;
+	auto w = words.ptr();
+	auto tailMask = maskBelow(end);
+	if (first == last) {
+		w[first] |= maskFrom(begin) & tailMask;
+	} else {
+		w[first] |= maskFrom(begin);
+		for(auto i=first+1; i<last; ++i) { w[i] = ~uint64_t(0); }
+		w[last] |= tailMask;
+	}
+}
+
+void BitArray::clearRange(unsigned begin, unsigned end)
+{
+	ASSERT(begin <= end && end <= capacity);
+	if (begin == end) { return; }
+	auto first = begin >> 6;
+	auto last = (end - 1) >> 6;
+	auto w = words.ptr();
+	auto tailMask = maskBelow(end);
+	if (first == last) {
+		w[first] &= ~(maskFrom(begin) & tailMask);
+	} else {
+		w[first] &= ~maskFrom(begin);
+		for(auto i=first+1; i<last; ++i) { w[i] = 0; }
+		w[last] &= ~tailMask;
+	}
 }
 
 bool BitArray::operator[](unsigned i) const
 {
-	unsigned word, local; getIndices(i, &word, &local);
-	return (words[word] & bit(local)) != 0;
+	ASSERT(i < capacity);
+	return (words[i >> 6] & bit(i)) != 0;
+}
+
+unsigned BitArray::count() const
+{
+	unsigned result = 0;
+	auto w = words.ptr();
+	for(unsigned i=0; i<nwords(); ++i) {
+		result += POPCOUNT64(w[i]);
+	}
+	return result;
+}
+
+bool BitArray::any() const
+{
+	auto w = words.ptr();
+	uint64_t accum = 0;
+	for(unsigned i=0; i<nwords(); ++i) {
+		accum |= w[i];
+	}
+	return accum != 0;
+}
+
+bool BitArray::intersects(const BitArray& other) const
+{
+	ASSERT(capacity == other.capacity);
+	auto a = words.ptr();
+	auto b = other.words.ptr();
+	for(unsigned i=0; i<nwords(); ++i) {
+		if (a[i] & b[i]) { return true; }
+	}
+	return false;
 }
 
-void BitArray::getIndices(unsigned idx, unsigned* outWord, unsigned *outIndex) const
+bool BitArray::containsAll(const BitArray& other) const
 {
-	*outWord = idx >> 5;
-	*outIndex = idx % 32;
+	ASSERT(capacity == other.capacity);
+	auto a = words.ptr();
+	auto b = other.words.ptr();
+	for(unsigned i=0; i<nwords(); ++i) {
+		if (b[i] & ~a[i]) { return false; }
+	}
+	return true;
+}
 
+int BitArray::findNext(unsigned begin, unsigned end) const
+{
+	ASSERT(end <= capacity);
+	if (begin >= end) { return -1; }
+	auto w = words.ptr();
+	auto i = begin >> 6;
+	auto last = (end - 1) >> 6;
+	auto word = w[i] & maskFrom(begin);
+	for(;;) {
+		if (word) {
+			auto result = (i << 6) + CTZ64(word);
+			return result < end ? int(result) : -1;
+		}
+		if (++i > last) {
+			return -1;
+		}
+		word = w[i];
+	}
 }
 
-uint32_t BitArray::bit(unsigned i)
+BitArray& BitArray::operator&=(const BitArray& other)
 {
-	return 0x80000000 >> i;
+	ASSERT(capacity == other.capacity);
+	applyWords<BIT_AND>(words.ptr(), other.words.ptr(), nwords());
+	return *this;
 }
 
+BitArray& BitArray::operator|=(const BitArray& other)
+{
+	ASSERT(capacity == other.capacity);
+	applyWords<BIT_OR>(words.ptr(), other.words.ptr(), nwords());
+	return *this;
+}
+
+BitArray& BitArray::operator^=(const BitArray& other)
+{
+	ASSERT(capacity == other.capacity);
+	applyWords<BIT_XOR>(words.ptr(), other.words.ptr(), nwords());
+	return *this;
+}
+
+BitArray& BitArray::andNot(const BitArray& other)
+{
+	ASSERT(capacity == other.capacity);
+	applyWords<BIT_ANDNOT>(words.ptr(), other.words.ptr(), nwords());
+	return *this;
+}
+
+void BitArray::trimTail()
+{
+	// keep bits past the capacity clear, so counts and searches stay exact
+	if (capacity & 63) {
+		words[nwords()-1] &= ~maskFrom(capacity);
+	}
+}
+
+//--------------------------------------------------------------------------------
+// BIT LISTER
+
 BitLister::BitLister(const BitArray *arr) :
 pArray(arr),
 currentWord(-1),
-currentIndex(-1),
+currentIndex(~0u),
 remainder(0)
 {
 }
 
 bool BitLister::next()
 {
-	if (remainder) {
-		currentIndex = CLZ(remainder);
-		remainder ^= BitArray::bit(currentIndex);
-		return true;
-	} else {
+	if (!remainder) {
+		auto w = pArray->words.ptr();
 		do {
 			currentWord++;
-		} while(currentWord < pArray->nwords() && pArray->words[currentWord] == 0);
-		if (currentWord < pArray->nwords()) {
-			remainder = pArray->words[currentWord];
-			currentIndex = CLZ(remainder);
-			remainder ^= BitArray::bit(currentIndex);
-			return true;
-		} else {
-			currentIndex = -1;
+		} while(currentWord < pArray->nwords() && w[currentWord] == 0);
+		if (currentWord >= pArray->nwords()) {
+			currentIndex = ~0u;
 			return false;
 		}
+		remainder = w[currentWord];
 	}
+	currentIndex = CTZ64(remainder);
+	remainder &= remainder - 1;
+	return true;
 }
@@ -0,0 +1,212 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "littlepolygon/collision.h"
+
+Broadphase::Broadphase(int aCapacity) :
+capacity(aCapacity),
+proxies(0)
+{
+	ASSERT(capacity > 0);
+	proxies = (Proxy*) lpMalloc(capacity * (sizeof(Proxy) + sizeof(SortEntry) + sizeof(int)));
+	entries = (SortEntry*) (proxies + capacity);
+	order = (int*) (entries + capacity);
+	clear();
+}
+
+Broadphase::~Broadphase()
+{
+	lpFree(proxies);
+}
+
+int Broadphase::create(lpVec lo, lpVec hi, void* userData)
+{
+	ASSERT(firstFree >= 0);
+	ASSERT(lo.x <= hi.x && lo.y <= hi.y);
+	auto id = firstFree;
+	auto& proxy = proxies[id];
+	firstFree = proxy.nextFree;
+
+	proxy.lo = lo;
+	proxy.hi = hi;
+	proxy.userData = userData;
+	proxy.live = true;
+	if (!proxy.sorted) {
+		// (a recycled id may still be in the order, waiting to be compacted)
+		proxy.sorted = true;
+		order[nsorted++] = id;
+		++nappended;
+	}
+	++count;
+	dirty = true;
+	return id;
+}
+
+void Broadphase::update(int id, lpVec lo, lpVec hi)
+{
+	ASSERT(id >= 0 && id < capacity && proxies[id].live);
+	ASSERT(lo.x <= hi.x && lo.y <= hi.y);
+	proxies[id].lo = lo;
+	proxies[id].hi = hi;
+	dirty = true;
+}
+
+void Broadphase::destroy(int id)
+{
+	ASSERT(id >= 0 && id < capacity && proxies[id].live);
+	auto& proxy = proxies[id];
+	proxy.live = false;
+	proxy.nextFree = firstFree;
+	firstFree = id;
+	--count;
+	dirty = true;
+}
+
+void Broadphase::clear()
+{
+	count = 0;
+	nsorted = 0;
+	nappended = 0;
+	firstFree = 0;
+	dirty = false;
+	maxWidth = 0;
+	for(int i=0; i<capacity; ++i) {
+		proxies[i].nextFree = i+1 < capacity ? i+1 : -1;
+		proxies[i].live = false;
+		proxies[i].sorted = false;
+	}
+}
+
+void Broadphase::create(int n, const lpVec* lo, const lpVec* hi, void* const* userData, int* outIds)
+{
+	for(int i=0; i<n; ++i) {
+		auto id = create(lo[i], hi[i], userData ? userData[i] : 0);
+		if (outIds) {
+			outIds[i] = id;
+		}
+	}
+}
+
+void Broadphase::update(int n, const int* ids, const lpVec* lo, const lpVec* hi)
+{
+	for(int i=0; i<n; ++i) {
+		update(ids[i], lo[i], hi[i]);
+	}
+}
+
+static int compareEntries(const void* a, const void* b)
+{
+	auto xa = ((const lpVec*) a)->x;
+	auto xb = ((const lpVec*) b)->x;
+	return xa < xb ? -1 : xa > xb ? 1 : 0;
+}
+
+void Broadphase::sort()
+{
+	if (!dirty) {
+		return;
+	}
+
+	// gather the current bounds in the previous order (so they're nearly
+	// sorted already), compacting away destroyed proxies
+	int n = 0;
+	for(int k=0; k<nsorted; ++k) {
+		auto id = order[k];
+		auto& proxy = proxies[id];
+		if (proxy.live) {
+			entries[n].lo = proxy.lo;
+			entries[n].hi = proxy.hi;
+			entries[n].id = id;
+			++n;
+		} else {
+			proxy.sorted = false;
+		}
+	}
+	ASSERT(n == count);
+
+	if (nappended > 64 && nappended > n / 8) {
+		// lots of unordered new proxies
+		qsort(entries, n, sizeof(SortEntry), compareEntries);
+	} else {
+		for(int i=1; i<n; ++i) {
+			auto entry = entries[i];
+			int j = i;
+			for(; j > 0 && entries[j-1].lo.x > entry.lo.x; --j) {
+				entries[j] = entries[j-1];
+			}
+			entries[j] = entry;
+		}
+	}
+
+	maxWidth = 0;
+	for(int k=0; k<n; ++k) {
+		order[k] = entries[k].id;
+		maxWidth = MAX(maxWidth, entries[k].hi.x - entries[k].lo.x);
+	}
+	nsorted = n;
+	nappended = 0;
+	dirty = false;
+}
+
+int Broadphase::findPairs(BroadphasePair* outPairs, int maxPairs)
+{
+	sort();
+	int total = 0;
+	for(int i=0; i<count; ++i) {
+		auto& a = entries[i];
+		for(int j=i+1; j<count && entries[j].lo.x < a.hi.x; ++j) {
+			auto& b = entries[j];
+			if (b.lo.y < a.hi.y && a.lo.y < b.hi.y) {
+				if (total < maxPairs) {
+					outPairs[total].a = MIN(a.id, b.id);
+					outPairs[total].b = MAX(a.id, b.id);
+				}
+				++total;
+			}
+		}
+	}
+	return total;
+}
+
+int Broadphase::query(lpVec lo, lpVec hi, int* outIds, int maxResults)
+{
+	sort();
+
+	// nothing starting left of this can reach the query
+	auto start = lo.x - maxWidth;
+	int first = 0;
+	int last = count;
+	while(first < last) {
+		int mid = (first + last) >> 1;
+		if (entries[mid].lo.x < start) {
+			first = mid + 1;
+		} else {
+			last = mid;
+		}
+	}
+
+	int total = 0;
+	for(int i=first; i<count && entries[i].lo.x < hi.x; ++i) {
+		auto& entry = entries[i];
+		if (lo.x < entry.hi.x && entry.lo.y < hi.y && lo.y < entry.hi.y) {
+			if (total < maxResults) {
+				outIds[total] = entry.id;
+			}
+			++total;
+		}
+	}
+	return total;
+}
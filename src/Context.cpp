@@ -113,8 +113,10 @@ SDLContext::~SDLContext()
 LPContext::LPContext(const char *caption, int w, int h, const char *assetPath, int plotterCap, int linesCap) :
 Singleton<LPContext>(this),
 SDLContext(caption, w, h),
+frame("frame", LP_FRAME_ARENA_CAPACITY),
 assets(assetPath),
 view(makeView()),
+coroutines(&queue),
 plotter(plotterCap),
 lines(linesCap),
 sprites(&plotter)
@@ -0,0 +1,154 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "littlepolygon/coroutines.h"
+
+//--------------------------------------------------------------------------------
+// TASKS
+
+CoroutineTask::CoroutineTask(CoroutineScheduler* aScheduler, CoroutineFunc aFunc, void* aContext) :
+TimerCallback(Action<>::callMethod<CoroutineTask, &CoroutineTask::wake>(this)),
+COROUTINE_INIT,
+context(aContext),
+mScheduler(aScheduler),
+mFunc(aFunc),
+mWakeFrame(0)
+{
+}
+
+void CoroutineTask::waitSeconds(lpFloat seconds)
+{
+	ASSERT(mScheduler->timers);
+	cancelWait();
+	mScheduler->timers->enqueue(this, seconds);
+}
+
+void CoroutineTask::waitFrames(unsigned frames)
+{
+	cancelWait();
+	mScheduler->schedule(this, mScheduler->currentFrame + MAX(frames, 1u));
+}
+
+void CoroutineTask::waitEvent(EventDispatcher<>* event)
+{
+	cancelWait();
+	event->bind(this);
+}
+
+void CoroutineTask::wake()
+{
+	// timer queues and dispatchers have already unbound us by the time this
+	// is called (or we're being moved between scheduler lists)
+
+	cancelWait();
+	attachBefore(&mScheduler->ready);
+}
+
+//--------------------------------------------------------------------------------
+// SCHEDULER
+
+CoroutineScheduler::CoroutineScheduler(TimerQueue* aTimers) :
+timers(aTimers),
+current(0),
+currentFrame(0)
+{
+}
+
+CoroutineScheduler::~CoroutineScheduler()
+{
+	clear();
+}
+
+CoroutineTask* CoroutineScheduler::start(CoroutineFunc func, void* context)
+{
+	ASSERT(func);
+	auto result = tasks.alloc(this, func, context);
+	result->attachBefore(&ready);
+	return result;
+}
+
+void CoroutineScheduler::cancel(CoroutineTask* task)
+{
+	ASSERT(task->mScheduler == this);
+	ASSERT(tasks.isActive(task));
+	ASSERT(task != current);
+	tasks.release(task);
+}
+
+void CoroutineScheduler::clear()
+{
+	// releasing a task unbinds it from whatever it was waiting on
+
+	ASSERT(current == 0);
+	tasks.drain();
+}
+
+void CoroutineScheduler::schedule(CoroutineTask* task, uint32_t wakeFrame)
+{
+	task->mWakeFrame = wakeFrame;
+	task->attachBefore(&frameSlots[wakeFrame % kFrameSlots]);
+}
+
+int CoroutineScheduler::tick()
+{
+	++currentFrame;
+
+	// move this frame's bucket to the ready list.  Buckets are shared by every
+	// frame which is congruent mod kFrameSlots, so longer waits are put back.
+
+	auto bucket = &frameSlots[currentFrame % kFrameSlots];
+	Head later;
+	while(bucket->isBound()) {
+		auto task = bucket->first();
+		task->unbind();
+		if (task->mWakeFrame == currentFrame) {
+			task->attachBefore(&ready);
+		} else {
+			task->attachBefore(&later);
+		}
+	}
+	if (later.isBound()) {
+		bucket->attachAfter(&later);
+		later.unbind();
+	}
+
+	// detach the ready list, so that tasks woken while we're resuming (e.g. by
+	// events emitted from other tasks) wait until the next tick
+
+	Head running;
+	if (!ready.isBound()) {
+		return 0;
+	}
+	running.attachAfter(&ready);
+	ready.unbind();
+
+	int result = 0;
+	while(running.isBound()) {
+		auto task = running.first();
+		task->unbind();
+		current = task;
+		task->mFunc(task);
+		current = 0;
+		++result;
+		if (task->_line == -1) {
+			tasks.release(task);
+		} else if (!task->isBound()) {
+			// plain yield -- resume next frame
+			schedule(task, currentFrame + 1);
+		}
+	}
+	return result;
+}
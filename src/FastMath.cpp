@@ -0,0 +1,176 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// By default GCC won't speculate float ops past a select (in case they raise
+// an FP exception), which leaves control flow in the batch loops and stops
+// them vectorizing.  Nothing here inspects the FP exception flags.  At -O2,
+// GCC also only vectorizes loops that need no alias check or remainder loop,
+// which rules out all of these, so the cheap cost model is asked for too.
+#if defined(__GNUC__) && !defined(__clang__)
+#	pragma GCC optimize("no-trapping-math", "tree-vectorize", "vect-cost-model=cheap")
+#endif
+
+#include "littlepolygon/math.h"
+
+//--------------------------------------------------------------------------------
+// BATCH VERSIONS
+
+void fastSinCos(const lpFloat* radians, lpFloat* outSin, lpFloat* outCos, int count)
+{
+	if (LP_FAST_MATH_PRECISION == LP_FAST_MATH_LIBM) {
+		for(int i=0; i<count; ++i) { fastSinCos(radians[i], outSin + i, outCos + i); }
+		return;
+	}
+
+	// The range check is a pass of its own, staging the clamped input in
+	// outSin -- folded into the main loop GCC if-converts it by evaluating
+	// the whole polynomial twice, which costs about as much again.
+	int outside = 0;
+	for(int i=0; i<count; ++i) {
+		auto x = radians[i];
+		auto inside = lpAbs(x) <= LP_FAST_TRIG_RANGE;
+		outSin[i] = inside ? x : 0.0f;
+		outside += !inside;
+	}
+	for(int i=0; i<count; ++i) {
+		fastSinCosUnchecked(outSin[i], outSin + i, outCos + i);
+	}
+	if (outside) {
+		for(int i=0; i<count; ++i) {
+			if (!(lpAbs(radians[i]) <= LP_FAST_TRIG_RANGE)) {
+				outSin[i] = lpSin(radians[i]);
+				outCos[i] = lpCos(radians[i]);
+			}
+		}
+	}
+}
+
+void fastAtan2(const lpFloat* y, const lpFloat* x, lpFloat* outRadians, int count)
+{
+	for(int i=0; i<count; ++i) {
+		outRadians[i] = fastAtan2(y[i], x[i]);
+	}
+}
+
+void fastExp(const lpFloat* x, lpFloat* outValues, int count)
+{
+	for(int i=0; i<count; ++i) {
+		outValues[i] = fastExp(x[i]);
+	}
+}
+
+void fastLog(const lpFloat* x, lpFloat* outValues, int count)
+{
+	if (LP_FAST_MATH_PRECISION == LP_FAST_MATH_LIBM) {
+		for(int i=0; i<count; ++i) { outValues[i] = lpLog(x[i]); }
+		return;
+	}
+	int outside = 0;
+	for(int i=0; i<count; ++i) {
+		outValues[i] = fastLog2Unchecked(x[i]) * 0.693147180559945309f;
+		outside += !(x[i] > 0.0f);
+	}
+	if (outside) {
+		for(int i=0; i<count; ++i) {
+			if (!(x[i] > 0.0f)) { outValues[i] = lpLog(x[i]); }
+		}
+	}
+}
+
+void fastPow(const lpFloat* x, lpFloat y, lpFloat* outValues, int count)
+{
+	if (LP_FAST_MATH_PRECISION == LP_FAST_MATH_LIBM) {
+		for(int i=0; i<count; ++i) { outValues[i] = lpPow(x[i], y); }
+		return;
+	}
+	int outside = 0;
+	for(int i=0; i<count; ++i) {
+		outValues[i] = fastExp2(y * fastLog2Unchecked(x[i]));
+		outside += !(x[i] > 0.0f);
+	}
+	if (outside) {
+		for(int i=0; i<count; ++i) {
+			if (!(x[i] > 0.0f)) { outValues[i] = lpPow(x[i], y); }
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------
+// ACCURACY REPORT
+
+template<int P>
+static FastMathAccuracy measure(int samples)
+{
+	FastMathAccuracy result = { 0, 0, 0, 0, 0, 0 };
+	for(int i=0; i<samples; ++i) {
+		double u = (i + 0.5) / samples;
+
+		// trig over a few turns either side of zero
+		auto radians = (lpFloat) (-8.0 * M_PI + 16.0 * M_PI * u);
+		lpFloat s, c;
+		fastSinCos<P>(radians, &s, &c);
+		result.sinError = MAX(result.sinError, fabs(s - sin((double)radians)));
+		result.cosError = MAX(result.cosError, fabs(c - cos((double)radians)));
+
+		// atan2 all the way around the circle, at varying radii
+		auto theta = -M_PI + 2.0 * M_PI * u;
+		auto r = 0.001 + 1000.0 * u;
+		auto y = (lpFloat) (r * sin(theta));
+		auto x = (lpFloat) (r * cos(theta));
+		result.atan2Error = MAX(result.atan2Error, fabs(fastAtan2<P>(y, x) - atan2((double)y, (double)x)));
+
+		// exp over the range that stays well inside float
+		auto ex = (lpFloat) (-80.0 + 160.0 * u);
+		auto expected = exp((double)ex);
+		result.expError = MAX(result.expError, fabs(fastExp<P>(ex) - expected) / expected);
+
+		// log from tiny to huge, avoiding the neighborhood of 1 where the
+		// relative error of any approximation blows up
+		auto lx = (lpFloat) pow(10.0, -30.0 + 60.0 * u);
+		if (fabs(lx - 1.0) > 0.01) {
+			auto expectedLog = log((double)lx);
+			result.logError = MAX(result.logError, fabs(fastLog<P>(lx) - expectedLog) / fabs(expectedLog));
+		}
+
+		// pow as used by easing: base in (0,1], exponent around 60*dt
+		auto base = (lpFloat) (0.01 + 0.99 * u);
+		auto exponent = (lpFloat) (0.1 + 10.0 * fmod(u * 7919.0, 1.0));
+		auto expectedPow = pow((double)base, (double)exponent);
+		result.powError = MAX(result.powError, fabs(fastPow<P>(base, exponent) - expectedPow) / expectedPow);
+	}
+	return result;
+}
+
+FastMathAccuracy lpMeasureFastMathAccuracy(int precision, int samples)
+{
+	switch(precision) {
+		case LP_FAST_MATH_LOW: return measure<LP_FAST_MATH_LOW>(samples);
+		case LP_FAST_MATH_MEDIUM: return measure<LP_FAST_MATH_MEDIUM>(samples);
+		default: return measure<LP_FAST_MATH_LIBM>(samples);
+	}
+}
+
+void lpLogFastMathAccuracy()
+{
+	#if DEBUG
+	static const char* names[] = { "low", "medium", "libm" };
+	for(int p=LP_FAST_MATH_LOW; p<=LP_FAST_MATH_LIBM; ++p) {
+		auto acc = lpMeasureFastMathAccuracy(p);
+		LOG(("fast math (%s): sin %.2e, cos %.2e, atan2 %.2e, exp %.2e, log %.2e, pow %.2e\n",
+			names[p], acc.sinError, acc.cosError, acc.atan2Error, acc.expError, acc.logError, acc.powError));
+	}
+	#endif
+}
@@ -0,0 +1,412 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "littlepolygon/jobs.h"
+
+#define DEQUE_CAPACITY 1024
+#define SPINS_BEFORE_SLEEP 64
+
+struct Job {
+	JobFunc func;
+	void* context;
+	JobCounter* counter;
+	Job* next;
+	int begin;
+	int end;
+};
+
+//--------------------------------------------------------------------------------
+// CHASE-LEV DEQUE
+// The owning worker pushes and pops at the bottom; thieves take from the top.
+// The only contention is over the last remaining job, resolved with a CAS on top.
+
+struct JobDeque {
+	alignas(LP_CACHE_LINE) std::atomic<long> top;
+	alignas(LP_CACHE_LINE) std::atomic<long> bottom;
+	std::atomic<Job*> slots[DEQUE_CAPACITY];
+
+	JobDeque() : top(0), bottom(0) {}
+
+	bool push(Job* job) {
+		auto b = bottom.load(std::memory_order_relaxed);
+		auto t = top.load(std::memory_order_acquire);
+		if (b - t >= DEQUE_CAPACITY) {
+			return false;
+		}
+		slots[b & (DEQUE_CAPACITY-1)].store(job, std::memory_order_relaxed);
+		bottom.store(b + 1, std::memory_order_release);
+		return true;
+	}
+
+	Job* pop() {
+		auto b = bottom.load(std::memory_order_relaxed) - 1;
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		auto t = top.load(std::memory_order_relaxed);
+		if (t > b) {
+			// empty
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return 0;
+		}
+		auto result = slots[b & (DEQUE_CAPACITY-1)].load(std::memory_order_relaxed);
+		if (t == b) {
+			// last job -- race thieves for it
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				result = 0;
+			}
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		return result;
+	}
+
+	Job* steal() {
+		auto t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		auto b = bottom.load(std::memory_order_acquire);
+		if (t >= b) {
+			return 0;
+		}
+		auto result = slots[t & (DEQUE_CAPACITY-1)].load(std::memory_order_relaxed);
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			return 0;
+		}
+		return result;
+	}
+};
+
+//--------------------------------------------------------------------------------
+// WORKER IDENTITY
+
+static LP_THREAD_LOCAL const JobSystem* tSystem = 0;
+static LP_THREAD_LOCAL int tWorker = -1;
+static LP_THREAD_LOCAL uint32_t tRandom = 0;
+
+struct WorkerStart {
+	JobSystem* system;
+	int index;
+};
+
+int JobSystem::currentWorker() const
+{
+	return tSystem == this ? tWorker : -1;
+}
+
+//--------------------------------------------------------------------------------
+// LIFECYCLE
+
+// lpMalloc() only guarantees malloc alignment, so deques are over-allocated and
+// aligned by hand (stashing the original block just before them) to keep each
+// worker's indices on their own cache lines.
+
+static JobDeque* allocDeques(int count)
+{
+	auto block = (uint8_t*) lpMalloc(count * sizeof(JobDeque) + LP_CACHE_LINE + sizeof(void*));
+	auto aligned = (uintptr_t(block) + sizeof(void*) + LP_CACHE_LINE - 1) & ~uintptr_t(LP_CACHE_LINE - 1);
+	((void**) aligned)[-1] = block;
+	return (JobDeque*) aligned;
+}
+
+static void freeDeques(JobDeque* deques)
+{
+	lpFree(((void**) deques)[-1]);
+}
+
+JobSystem::JobSystem(int workerCount, int jobCapacity) :
+nworkers(workerCount > 0 ? workerCount : SDL_GetCPUCount()),
+threads(0),
+freeJobs(jobCapacity),
+injected(jobCapacity),
+mainJobs(jobCapacity),
+wakeup(SDL_CreateSemaphore(0)),
+sleepers(0),
+running(true)
+{
+	ASSERT(nworkers > 0);
+	ASSERT(tSystem == 0);
+	tSystem = this;
+	tWorker = 0;
+	tRandom = 0x9e3779b9u * (tWorker + 1);
+
+	deques = allocDeques(nworkers);
+	for(int i=0; i<nworkers; ++i) {
+		new(deques + i) JobDeque();
+	}
+
+	jobs = (Job*) lpMalloc(jobCapacity * sizeof(Job));
+	for(int i=0; i<jobCapacity; ++i) {
+		freeJobs.tryEnqueue(jobs + i);
+	}
+
+	if (nworkers > 1) {
+		threads = (SDL_Thread**) lpMalloc((nworkers-1) * sizeof(SDL_Thread*));
+		for(int i=1; i<nworkers; ++i) {
+			auto start = (WorkerStart*) lpMalloc(sizeof(WorkerStart));
+			start->system = this;
+			start->index = i;
+			threads[i-1] = SDL_CreateThread(workerMain, "lpWorker", start);
+			ASSERT(threads[i-1]);
+		}
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	ASSERT(isMainThread());
+
+	// finish anything still outstanding before shutting down
+	Job* job;
+	while((job = findJob(0)) != 0) {
+		execute(job);
+	}
+	runMainThreadJobs();
+
+	running.store(false);
+	for(int i=1; i<nworkers; ++i) {
+		SDL_SemPost(wakeup);
+	}
+	for(int i=1; i<nworkers; ++i) {
+		SDL_WaitThread(threads[i-1], 0);
+	}
+	lpFree(threads);
+	SDL_DestroySemaphore(wakeup);
+
+	for(int i=0; i<nworkers; ++i) {
+		deques[i].~JobDeque();
+	}
+	freeDeques(deques);
+	lpFree(jobs);
+	tSystem = 0;
+	tWorker = -1;
+}
+
+int JobSystem::workerMain(void* data)
+{
+	auto start = (WorkerStart*) data;
+	auto system = start->system;
+	auto index = start->index;
+	lpFree(start);
+
+	tSystem = system;
+	tWorker = index;
+	tRandom = 0x9e3779b9u * (index + 1);
+
+	int idleSpins = 0;
+	while(system->running.load(std::memory_order_relaxed)) {
+		if (auto job = system->findJob(index)) {
+			system->execute(job);
+			idleSpins = 0;
+		} else if (++idleSpins < SPINS_BEFORE_SLEEP) {
+			SDL_Delay(0);
+		} else {
+			// timeout guards against missing a post between findJob() and here
+			system->sleepers.fetch_add(1);
+			SDL_SemWaitTimeout(system->wakeup, 2);
+			system->sleepers.fetch_sub(1);
+			idleSpins = 0;
+		}
+	}
+	return 0;
+}
+
+//--------------------------------------------------------------------------------
+// SUBMISSION
+
+Job* JobSystem::allocJob(JobFunc func, void* context, JobCounter* counter, int begin, int end)
+{
+	Job* result;
+	if (!freeJobs.tryDequeue(&result)) {
+		return 0;
+	}
+	result->func = func;
+	result->context = context;
+	result->counter = counter;
+	result->next = 0;
+	result->begin = begin;
+	result->end = end;
+	return result;
+}
+
+void JobSystem::run(JobFunc func, void* context, JobCounter* counter, JobCounter* dependency, int begin, int end)
+{
+	if (counter) {
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	}
+	auto job = allocJob(func, context, counter, begin, end);
+	if (job) {
+		submit(job, dependency);
+	} else {
+		// out of job records -- run it synchronously instead
+		if (dependency) {
+			wait(dependency);
+		}
+		func(context, begin, end);
+		if (counter) {
+			finish(counter);
+		}
+	}
+}
+
+void JobSystem::parallelFor(int count, int grainSize, JobFunc func, void* context, JobCounter* counter, JobCounter* dependency)
+{
+	if (grainSize <= 0) {
+		grainSize = MAX(1, count / (4 * nworkers));
+	}
+	for(int begin=0; begin<count; begin+=grainSize) {
+		run(func, context, counter, dependency, begin, MIN(begin + grainSize, count));
+	}
+}
+
+void JobSystem::runOnMainThread(JobFunc func, void* context, JobCounter* counter, int begin, int end)
+{
+	if (counter) {
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	}
+	auto job = allocJob(func, context, counter, begin, end);
+	if (job && mainJobs.tryEnqueue(job)) {
+		return;
+	}
+
+	// out of room, so there's no choice but to block until the main thread
+	// picks it up (or run it now, if this is the main thread)
+	if (isMainThread()) {
+		if (job) { execute(job); } else { func(context, begin, end); if (counter) { finish(counter); } }
+	} else {
+		while(!job) {
+			SDL_Delay(0);
+			job = allocJob(func, context, counter, begin, end);
+		}
+		while(!mainJobs.tryEnqueue(job)) {
+			SDL_Delay(0);
+		}
+	}
+}
+
+int JobSystem::runMainThreadJobs()
+{
+	ASSERT(isMainThread());
+	int result = 0;
+	Job* job;
+	while(mainJobs.tryDequeue(&job)) {
+		execute(job);
+		++result;
+	}
+	return result;
+}
+
+void JobSystem::submit(Job* job, JobCounter* dependency)
+{
+	if (dependency) {
+		SDL_AtomicLock(&dependency->lock);
+		if (!dependency->isDone()) {
+			job->next = dependency->parked;
+			dependency->parked = job;
+			SDL_AtomicUnlock(&dependency->lock);
+			return;
+		}
+		SDL_AtomicUnlock(&dependency->lock);
+	}
+	push(job);
+}
+
+void JobSystem::push(Job* job)
+{
+	auto worker = currentWorker();
+	bool queued = worker >= 0 ? deques[worker].push(job) : injected.tryEnqueue(job);
+	if (!queued) {
+		execute(job);
+		return;
+	}
+	if (sleepers.load(std::memory_order_relaxed) > 0) {
+		SDL_SemPost(wakeup);
+	}
+}
+
+//--------------------------------------------------------------------------------
+// EXECUTION
+
+Job* JobSystem::findJob(int worker)
+{
+	if (auto result = deques[worker].pop()) {
+		return result;
+	}
+
+	Job* result;
+	if (injected.tryDequeue(&result)) {
+		return result;
+	}
+
+	// steal from a random victim, then sweep the rest
+	if (nworkers > 1) {
+		ASSERT(tRandom != 0); // (xorshift never leaves zero)
+		tRandom ^= tRandom << 13;
+		tRandom ^= tRandom >> 17;
+		tRandom ^= tRandom << 5;
+		int first = tRandom % nworkers;
+		for(int i=0; i<nworkers; ++i) {
+			int victim = (first + i) % nworkers;
+			if (victim != worker) {
+				if ((result = deques[victim].steal()) != 0) {
+					return result;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+void JobSystem::execute(Job* job)
+{
+	job->func(job->context, job->begin, job->end);
+	auto counter = job->counter;
+	freeJobs.tryEnqueue(job);
+	if (counter) {
+		finish(counter);
+	}
+}
+
+void JobSystem::finish(JobCounter* counter)
+{
+	if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		// release jobs which were waiting on this counter
+		SDL_AtomicLock(&counter->lock);
+		auto parked = counter->parked;
+		counter->parked = 0;
+		SDL_AtomicUnlock(&counter->lock);
+		while(parked) {
+			auto next = parked->next;
+			parked->next = 0;
+			push(parked);
+			parked = next;
+		}
+	}
+}
+
+void JobSystem::wait(JobCounter* counter)
+{
+	auto worker = currentWorker();
+	ASSERT(worker >= 0);
+	while(!counter->isDone()) {
+		Job* job = findJob(worker);
+		if (!job && worker == 0) {
+			mainJobs.tryDequeue(&job);
+		}
+		if (job) {
+			execute(job);
+		} else {
+			SDL_Delay(0);
+		}
+	}
+}
@@ -15,6 +15,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "littlepolygon/graphics.h"
+#include "littlepolygon/profiler.h"
 
 const GLchar LINE_VERT[] = GLSL(
 
@@ -46,44 +47,35 @@ LinePlotter::LinePlotter(int aCapacity) :
 count(-1),
 capacity(aCapacity),
 shader(LINE_VERT, LINE_FRAG),
-vertices(2*capacity)
+vertices(lpTagged<Array<LineVertex>>(MEMORY_TAG_SPRITES, 2*capacity))
 
 {
+	mStats.reset();
 	shader.use();
 	uMVP = shader.uniformLocation("mvp");
 	aPosition = shader.attribLocation("aPosition");
 	aColor = shader.attribLocation("aColor");
 	
-	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
+	vbo = lpRenderBackend()->createBuffer(GL_ARRAY_BUFFER, 2*sizeof(LineVertex) * capacity, 0, GL_DYNAMIC_DRAW);
 	
-	glGenBuffers(1, &vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, 2*sizeof(LineVertex) * capacity, 0, GL_DYNAMIC_DRAW);
-	
-	glEnableVertexAttribArray(aPosition);
-	glEnableVertexAttribArray(aColor);
-	glVertexAttribPointer(
-		aPosition, 2, GL_FLOAT, GL_FALSE,
-		sizeof(LineVertex),
-		(void*) 0
-	);
-	glVertexAttribPointer(
-		aColor, 4, GL_UNSIGNED_BYTE, GL_TRUE,
-		sizeof(LineVertex),
-		(void*) 8
-	);
-	
-	glBindVertexArray(0);
-	
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	const VertexAttrib attribs[] = {
+		{ aPosition, 2, GL_FLOAT, GL_FALSE, 0 },
+		{ aColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, 8 }
+	};
+	vao = lpRenderBackend()->createVertexArray(vbo, 0, sizeof(LineVertex), arraysize(attribs), attribs);
 }
 
+LinePlotter::~LinePlotter()
+{
+	lpRenderBackend()->destroyVertexArray(vao);
+	lpRenderBackend()->destroyBuffer(vbo);
+}
 
 void LinePlotter::begin(const Viewport& viewport) {
 	ASSERT(count == -1);
 	count = 0;
 	shader.use();
+	++mStats.shaderBinds;
 	viewport.setMVP(uMVP);
 }
 
@@ -92,9 +84,10 @@ void LinePlotter::plot(lpVec p0, lpVec p1, Color c) {
 	vertices[2*count  ].set(p0, c);
 	vertices[2*count+1].set(p1, c);
 
+	++mStats.draws;
 	++count;
 	if (count == capacity) {
-		commitBatch();
+		commitBatch(FLUSH_CAPACITY);
 	}
 }
 
@@ -125,19 +118,23 @@ void LinePlotter::plotArrow(lpVec p0, lpVec p1, lpFloat r, Color c) {
 void LinePlotter::end() {
 	ASSERT(count >= 0);
 	if (count > 0) {
-		commitBatch();
+		commitBatch(FLUSH_EXPLICIT);
 	}
 	count = -1;
 }
 
-void LinePlotter::commitBatch() {
+void LinePlotter::commitBatch(FlushReason reason) {
+	LP_PROFILE_ZONE("line batch");
 	ASSERT(count > 0);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, 2*count*sizeof(LineVertex), vertices.ptr());
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(vao);
-	glDrawArrays(GL_LINES, 0, 2*count);
-	glBindVertexArray(0);
+	++mStats.batches;
+	++mStats.flushes[reason];
+	mStats.vertices += 2*count;
+	mStats.bytesUploaded += 2*count*sizeof(LineVertex);
+	lpRenderBackend()->updateBuffer(GL_ARRAY_BUFFER, vbo, 2*count*sizeof(LineVertex), vertices.ptr());
+	{
+		LP_PROFILE_GPU_ZONE("line batch");
+		lpRenderBackend()->drawArrays(vao, GL_LINES, 2*count);
+	}
 	count = 0;
 }
 
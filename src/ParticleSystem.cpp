@@ -1,4 +1,5 @@
 #include "littlepolygon/particles.h"
+#include "littlepolygon/profiler.h"
 
 //--------------------------------------------------------------------------------
 
@@ -93,6 +94,8 @@ particles(1024)
 
 void ParticleSystem::tick(lpFloat dt)
 {
+	LP_PROFILE_ZONE("particles tick");
+	LP_MEMORY_TAG(MEMORY_TAG_PARTICLES);
 	time += dt;
 	
 	// tick emitters
@@ -18,20 +18,19 @@
 Plotter::Plotter(int cap) :
 capacity(cap),
 currentArray(0),
-vertices(cap)
+vertices(lpTagged<Array<Vertex>>(MEMORY_TAG_SPRITES, cap))
 {
-	glGenBuffers(3, vbo);
-	
+	mStats.reset();
 	for(int i=0; i<3; ++i) {
-		glBindBuffer(GL_ARRAY_BUFFER, vbo[i]);
-		glBufferData(GL_ARRAY_BUFFER, capacity*sizeof(Vertex), 0, GL_DYNAMIC_DRAW);
+		vbo[i] = lpRenderBackend()->createBuffer(GL_ARRAY_BUFFER, capacity*sizeof(Vertex), 0, GL_DYNAMIC_DRAW);
 	}
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 Plotter::~Plotter()
 {
-	glDeleteBuffers(3, vbo);
+	for(int i=0; i<3; ++i) {
+		lpRenderBackend()->destroyBuffer(vbo[i]);
+	}
 }
 
 void Plotter::swapBuffer()
@@ -41,7 +40,6 @@ void Plotter::swapBuffer()
 
 void Plotter::bufferData(int count)
 {
-	glBindBuffer(GL_ARRAY_BUFFER, vbo[currentArray]);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, count*sizeof(Vertex), vertices.ptr());
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	mStats.bytesUploaded += count*sizeof(Vertex);
+	lpRenderBackend()->updateBuffer(GL_ARRAY_BUFFER, vbo[currentArray], count*sizeof(Vertex), vertices.ptr());
 }
@@ -0,0 +1,316 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "littlepolygon/profiler.h"
+#include "littlepolygon/graphics.h"
+#include <atomic>
+
+static_assert((LP_PROFILER_CAPACITY & (LP_PROFILER_CAPACITY - 1)) == 0, "LP_PROFILER_CAPACITY must be a power of two");
+
+//--------------------------------------------------------------------------------
+// THREAD BUFFERS
+// Each thread owns a ring which only it writes.  The exporter reads behind the
+// head and drops anything the owner may have lapped while it was reading, so
+// neither side ever waits.  Buffers are never freed (threads are expected to
+// be long-lived, like a JobSystem's), and are linked into a lock-free list.
+
+struct ProfileEvent {
+	const char* name;
+	uint64_t begin;
+	uint64_t end;
+};
+
+struct ProfileThread {
+	ProfileThread* next;
+	SDL_threadID id;
+	std::atomic<const char*> name;
+	std::atomic<uint32_t> head;
+	uint32_t tail;
+	ProfileEvent events[LP_PROFILER_CAPACITY];
+
+	ProfileThread(SDL_threadID anId) : next(0), id(anId), name(0), head(0), tail(0) {}
+
+	void record(const char* eventName, uint64_t begin, uint64_t end) {
+		auto h = head.load(std::memory_order_relaxed);
+		auto& event = events[h & (LP_PROFILER_CAPACITY-1)];
+		event.name = eventName;
+		event.begin = begin;
+		event.end = end;
+		head.store(h+1, std::memory_order_release);
+	}
+};
+
+static std::atomic<ProfileThread*> sThreads(nullptr);
+static std::atomic<bool> sEnabled(true);
+static LP_THREAD_LOCAL ProfileThread* tThread = 0;
+
+// marks frame boundaries in the ring, which are exported as instant events
+static const char sFrameMarker[] = "frame";
+
+static uint64_t epoch()
+{
+	static uint64_t result = SDL_GetPerformanceCounter();
+	return result;
+}
+
+static ProfileThread* createThread(SDL_threadID id)
+{
+	epoch();
+	auto result = new(lpMalloc(sizeof(ProfileThread))) ProfileThread(id);
+	auto head = sThreads.load(std::memory_order_relaxed);
+	do {
+		result->next = head;
+	} while(!sThreads.compare_exchange_weak(head, result, std::memory_order_release, std::memory_order_relaxed));
+	return result;
+}
+
+static ProfileThread* currentThread()
+{
+	if (!tThread) {
+		tThread = createThread(SDL_ThreadID());
+	}
+	return tThread;
+}
+
+void lpSetProfilerEnabled(bool enabled)
+{
+	sEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool lpProfilerEnabled()
+{
+	return sEnabled.load(std::memory_order_relaxed);
+}
+
+void lpSetProfilerThreadName(const char* name)
+{
+	currentThread()->name.store(name, std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------------------------
+// CPU ZONES
+
+ProfileZone::ProfileZone(const char* aName) :
+name(lpProfilerEnabled() ? aName : 0),
+begin(name ? SDL_GetPerformanceCounter() : 0)
+{
+}
+
+ProfileZone::~ProfileZone()
+{
+	if (name) {
+		currentThread()->record(name, begin, SDL_GetPerformanceCounter());
+	}
+}
+
+//--------------------------------------------------------------------------------
+// GPU ZONES
+// Only touched from the GL thread.  Queries are recycled in submission order,
+// which is also the order they complete in, so lpProfilerFrame() only has to
+// poll the oldest.
+
+struct PendingGPUZone {
+	const char* name;
+	uint64_t begin;
+};
+
+static GLuint sQueries[LP_PROFILER_GPU_QUERIES];
+static PendingGPUZone sPendingZones[LP_PROFILER_GPU_QUERIES];
+static uint32_t sPendingHead = 0;
+static uint32_t sPendingTail = 0;
+static bool sGPUZoneActive = false;
+static bool sGPUUnsupported = false;
+static ProfileThread* sGPUThread = 0;
+
+GPUProfileZone::GPUProfileZone(const char* name) : slot(-1)
+{
+	if (!lpProfilerEnabled() || sGPUUnsupported || sGPUZoneActive) {
+		return;
+	}
+	if (sPendingHead - sPendingTail == LP_PROFILER_GPU_QUERIES) {
+		// results aren't being collected fast enough; skip this zone
+		return;
+	}
+	int i = sPendingHead % LP_PROFILER_GPU_QUERIES;
+	if (!sQueries[i]) {
+		sQueries[i] = lpRenderBackend()->createQuery();
+		if (!sQueries[i]) {
+			sGPUUnsupported = true;
+			return;
+		}
+	}
+	sPendingZones[i].name = name;
+	sPendingZones[i].begin = SDL_GetPerformanceCounter();
+	lpRenderBackend()->beginTimeQuery(sQueries[i]);
+	sGPUZoneActive = true;
+	slot = i;
+}
+
+GPUProfileZone::~GPUProfileZone()
+{
+	if (slot >= 0) {
+		lpRenderBackend()->endTimeQuery();
+		sGPUZoneActive = false;
+		++sPendingHead;
+	}
+}
+
+static void collectGPUZones()
+{
+	if (sPendingTail == sPendingHead) {
+		return;
+	}
+	if (!sGPUThread) {
+		sGPUThread = createThread(0);
+		sGPUThread->name.store("GPU", std::memory_order_relaxed);
+	}
+
+	// there's no common clock with the GPU, so zones are placed at the time
+	// they were submitted, with the duration the GPU measured
+	auto ticksPerNanosecond = SDL_GetPerformanceFrequency() / 1e9;
+	while(sPendingTail != sPendingHead) {
+		int i = sPendingTail % LP_PROFILER_GPU_QUERIES;
+		uint64_t nanoseconds;
+		if (!lpRenderBackend()->queryResult(sQueries[i], &nanoseconds)) {
+			break;
+		}
+		auto& zone = sPendingZones[i];
+		sGPUThread->record(zone.name, zone.begin, zone.begin + (uint64_t)(nanoseconds * ticksPerNanosecond));
+		++sPendingTail;
+	}
+}
+
+void lpProfilerFrame()
+{
+	if (lpProfilerEnabled()) {
+		auto now = SDL_GetPerformanceCounter();
+		currentThread()->record(sFrameMarker, now, now);
+	}
+	collectGPUZones();
+}
+
+//--------------------------------------------------------------------------------
+// CHROME TRACE EXPORT
+
+class TraceWriter {
+private:
+	SDL_RWops* file;
+	uint64_t start;
+	double microsecondsPerTick;
+	bool first;
+	char line[256];
+
+public:
+	TraceWriter(SDL_RWops* aFile) :
+	file(aFile),
+	start(epoch()),
+	microsecondsPerTick(1e6 / SDL_GetPerformanceFrequency()),
+	first(true) {
+		write("{\"traceEvents\":[\n");
+	}
+
+	~TraceWriter() {
+		write("\n]}\n");
+	}
+
+	void writeThreadName(SDL_threadID tid, const char* name) {
+		char escaped[64];
+		escape(escaped, sizeof(escaped), name);
+		writeEvent("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+			(unsigned long) tid, escaped);
+	}
+
+	void writeZone(SDL_threadID tid, const ProfileEvent& event) {
+		char escaped[64];
+		escape(escaped, sizeof(escaped), event.name);
+		auto ts = microsecondsPerTick * (double)(int64_t)(event.begin - start);
+		if (event.name == sFrameMarker) {
+			writeEvent("{\"name\":\"frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f}",
+				(unsigned long) tid, ts);
+		} else {
+			auto dur = microsecondsPerTick * (double)(event.end - event.begin);
+			writeEvent("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+				escaped, (unsigned long) tid, ts, dur);
+		}
+	}
+
+private:
+	void write(const char* str) {
+		SDL_RWwrite(file, str, 1, strlen(str));
+	}
+
+	template<typename... Args>
+	void writeEvent(const char* format, Args... args) {
+		if (!first) {
+			write(",\n");
+		}
+		first = false;
+		snprintf(line, sizeof(line), format, args...);
+		write(line);
+	}
+
+	static void escape(char* dst, size_t size, const char* src) {
+		size_t n = 0;
+		for(; *src && n+2 < size; ++src) {
+			if (*src == '"' || *src == '\\') {
+				dst[n++] = '\\';
+			}
+			dst[n++] = *src;
+		}
+		dst[n] = 0;
+	}
+};
+
+bool lpWriteProfilerTrace(const char* path)
+{
+	SDL_RWops* file = SDL_RWFromFile(path, "wb");
+	if (!file) {
+		LOG(("Could not open trace file: %s\n", path));
+		return false;
+	}
+
+	{
+		TraceWriter writer(file);
+		for(auto thread=sThreads.load(std::memory_order_acquire); thread; thread=thread->next) {
+			if (auto name = thread->name.load(std::memory_order_relaxed)) {
+				writer.writeThreadName(thread->id, name);
+			}
+
+			// skip anything which was overwritten before we got to it
+			auto head = thread->head.load(std::memory_order_acquire);
+			auto i = head - thread->tail > LP_PROFILER_CAPACITY ? head - LP_PROFILER_CAPACITY : thread->tail;
+			for(; i != head; ++i) {
+				auto event = thread->events[i & (LP_PROFILER_CAPACITY-1)];
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (thread->head.load(std::memory_order_relaxed) - i >= LP_PROFILER_CAPACITY) {
+					continue;
+				}
+				writer.writeZone(thread->id, event);
+			}
+			thread->tail = head;
+		}
+	}
+
+	SDL_RWclose(file);
+	return true;
+}
+
+void lpClearProfiler()
+{
+	for(auto thread=sThreads.load(std::memory_order_acquire); thread; thread=thread->next) {
+		thread->tail = thread->head.load(std::memory_order_acquire);
+	}
+}
@@ -0,0 +1,292 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "littlepolygon/graphics.h"
+
+static RenderBackend* sRenderBackend = 0;
+
+RenderBackend* lpRenderBackend()
+{
+	if (!sRenderBackend) {
+		// never destroyed, so that it's safe to release resources from other
+		// static destructors
+		static union { uint8_t bytes[sizeof(GLRenderBackend)]; void* align; } storage;
+		static GLRenderBackend* gl = new(storage.bytes) GLRenderBackend();
+		sRenderBackend = gl;
+	}
+	return sRenderBackend;
+}
+
+void lpSetRenderBackend(RenderBackend* backend)
+{
+	ASSERT(backend);
+	sRenderBackend = backend;
+}
+
+//------------------------------------------------------------------------------
+// OPENGL
+
+GLuint GLRenderBackend::createBuffer(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage)
+{
+	GLuint result;
+	glGenBuffers(1, &result);
+	glBindBuffer(target, result);
+	glBufferData(target, size, data, usage);
+	glBindBuffer(target, 0);
+	return result;
+}
+
+void GLRenderBackend::updateBuffer(GLenum target, GLuint buffer, GLsizeiptr size, const GLvoid* data)
+{
+	glBindBuffer(target, buffer);
+	glBufferSubData(target, 0, size, data);
+	glBindBuffer(target, 0);
+}
+
+void GLRenderBackend::destroyBuffer(GLuint buffer)
+{
+	glDeleteBuffers(1, &buffer);
+}
+
+GLuint GLRenderBackend::createVertexArray(GLuint vertexBuffer, GLuint elementBuffer, GLsizei stride, int nattribs, const VertexAttrib* attribs)
+{
+	GLuint result;
+	glGenVertexArrays(1, &result);
+	glBindVertexArray(result);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	for(int i=0; i<nattribs; ++i) {
+		auto& attrib = attribs[i];
+		glEnableVertexAttribArray(attrib.location);
+		glVertexAttribPointer(attrib.location, attrib.size, attrib.type, attrib.normalized, stride, (GLvoid*) attrib.offset);
+	}
+	if (elementBuffer) {
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	return result;
+}
+
+void GLRenderBackend::destroyVertexArray(GLuint vertexArray)
+{
+	glDeleteVertexArrays(1, &vertexArray);
+}
+
+static GLuint compileShader(GLenum type, const GLchar* src)
+{
+	const char preamble[] = "\n";
+	const char* srcList[] = { preamble, src };
+	int lengths[] = { (int) strlen(preamble), (int) strlen(src) };
+	GLuint result = glCreateShader(type);
+	glShaderSource(result, 2, srcList, lengths);
+	glCompileShader(result);
+
+	GLint status;
+	glGetShaderiv(result, GL_COMPILE_STATUS, &status);
+	if (status != GL_TRUE) {
+		GLchar buf[256];
+		int len;
+		glGetShaderInfoLog(result, 256, &len, buf);
+		LOG(("%s %s\n", type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT", buf));
+		glDeleteShader(result);
+		return 0;
+	}
+	return result;
+}
+
+GLuint GLRenderBackend::createProgram(const GLchar* vsrc, const GLchar* fsrc)
+{
+	auto vert = compileShader(GL_VERTEX_SHADER, vsrc);
+	auto frag = compileShader(GL_FRAGMENT_SHADER, fsrc);
+	if (!vert || !frag) {
+		if (vert) { glDeleteShader(vert); }
+		if (frag) { glDeleteShader(frag); }
+		return 0;
+	}
+
+	GLuint prog = glCreateProgram();
+	glAttachShader(prog, vert);
+	glAttachShader(prog, frag);
+	glBindFragDataLocation(prog, 0, "outColor");
+	glLinkProgram(prog);
+
+	// the stages are only flagged for deletion, and go with the program
+	glDeleteShader(vert);
+	glDeleteShader(frag);
+
+	GLint status;
+	glGetProgramiv(prog, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE) {
+		GLchar buf[256];
+		int len;
+		glGetProgramInfoLog(prog, 256, &len, buf);
+		LOG(("LINK %s\n", buf));
+		glDeleteProgram(prog);
+		return 0;
+	}
+	return prog;
+}
+
+void GLRenderBackend::destroyProgram(GLuint prog)
+{
+	glDeleteProgram(prog);
+}
+
+void GLRenderBackend::useProgram(GLuint prog)
+{
+	glUseProgram(prog);
+}
+
+GLuint GLRenderBackend::uniformLocation(GLuint prog, const char* name)
+{
+	return glGetUniformLocation(prog, name);
+}
+
+GLuint GLRenderBackend::attribLocation(GLuint prog, const char* name)
+{
+	return glGetAttribLocation(prog, name);
+}
+
+void GLRenderBackend::setUniformMatrix(GLuint location, const GLfloat* values)
+{
+	glUniformMatrix4fv(location, 1, 0, values);
+}
+
+GLuint GLRenderBackend::createTexture(GLsizei w, GLsizei h, GLenum format, uint32_t flags, const GLvoid* pixels)
+{
+	GLuint result;
+	glGenTextures(1, &result);
+	glBindTexture(GL_TEXTURE_2D, result);
+	auto filter = (flags & TEXTURE_FLAG_FILTER) ? GL_LINEAR : GL_NEAREST;
+	auto wrap = (flags & TEXTURE_FLAG_REPEAT) ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, format, GL_UNSIGNED_BYTE, pixels);
+	return result;
+}
+
+void GLRenderBackend::destroyTexture(GLuint texture)
+{
+	glDeleteTextures(1, &texture);
+}
+
+void GLRenderBackend::bindTexture(GLuint texture)
+{
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GLRenderBackend::drawElements(GLuint vertexArray, GLenum mode, GLsizei count)
+{
+	glBindVertexArray(vertexArray);
+	glDrawElements(mode, count, GL_UNSIGNED_SHORT, 0);
+	glBindVertexArray(0);
+}
+
+void GLRenderBackend::drawArrays(GLuint vertexArray, GLenum mode, GLsizei count)
+{
+	glBindVertexArray(vertexArray);
+	glDrawArrays(mode, 0, count);
+	glBindVertexArray(0);
+}
+
+GLuint GLRenderBackend::createQuery()
+{
+	// GL_TIME_ELAPSED is core in 3.3 (or ARB_timer_query), and the context we
+	// create only asks for 3.2
+	if (!glGetQueryObjectui64v) {
+		return 0;
+	}
+	GLuint result;
+	glGenQueries(1, &result);
+	return result;
+}
+
+void GLRenderBackend::destroyQuery(GLuint query)
+{
+	glDeleteQueries(1, &query);
+}
+
+void GLRenderBackend::beginTimeQuery(GLuint query)
+{
+	glBeginQuery(GL_TIME_ELAPSED, query);
+}
+
+void GLRenderBackend::endTimeQuery()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+}
+
+bool GLRenderBackend::queryResult(GLuint query, uint64_t* outNanoseconds)
+{
+	GLint available;
+	glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available) {
+		return false;
+	}
+	GLuint64 result;
+	glGetQueryObjectui64v(query, GL_QUERY_RESULT, &result);
+	*outNanoseconds = result;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// NULL
+
+NullRenderBackend::NullRenderBackend() : mNextHandle(0)
+{
+	resetStats();
+}
+
+void NullRenderBackend::resetStats()
+{
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+GLuint NullRenderBackend::createBuffer(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage)
+{
+	if (data) {
+		++mStats.bufferUploads;
+		mStats.bytesUploaded += size;
+	}
+	return ++mNextHandle;
+}
+
+void NullRenderBackend::updateBuffer(GLenum target, GLuint buffer, GLsizeiptr size, const GLvoid* data)
+{
+	++mStats.bufferUploads;
+	mStats.bytesUploaded += size;
+}
+
+GLuint NullRenderBackend::createTexture(GLsizei w, GLsizei h, GLenum format, uint32_t flags, const GLvoid* pixels)
+{
+	++mStats.textureUploads;
+	return ++mNextHandle;
+}
+
+void NullRenderBackend::drawElements(GLuint vertexArray, GLenum mode, GLsizei count)
+{
+	++mStats.drawCalls;
+	mStats.verticesDrawn += count;
+}
+
+void NullRenderBackend::drawArrays(GLuint vertexArray, GLenum mode, GLsizei count)
+{
+	++mStats.drawCalls;
+	mStats.verticesDrawn += count;
+}
@@ -15,32 +15,41 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "littlepolygon/rig.h"
+#include "littlepolygon/profiler.h"
 
 Rig::Rig(const RigAsset* asset) :
 
 data(asset),
-timelineMask(data->ntimeslines),
-currentLayer(data->defaultLayer),
+timelineBegin(0),
+timelineEnd(0),
 currentAnimation(0),
-xformDirty(true)
+currentBake(0),
+currentLayer(data->defaultLayer),
+xformDirty(true),
+layerDirty(true)
 
 {
-	localAttitudes = (Attitude*) lpMalloc(
+	LP_MEMORY_TAG(MEMORY_TAG_RIG);
+	layerImages = (ImageAsset**) lpMalloc(
+		data->nattachments * (sizeof(ImageAsset*) + sizeof(lpMatrix) + sizeof(unsigned)) +
 		data->nbones * (sizeof(Attitude) + sizeof(lpMatrix) + sizeof(lpMatrix)) +
 		data->ntimeslines * sizeof(unsigned)
 	);
+	localAttitudes = (Attitude*) (layerImages + data->nattachments);
 	localTransforms = (lpMatrix*) (localAttitudes + data->nbones);
 	worldTransforms = localTransforms + data->nbones;
-	currentKeyframes = (unsigned*) (worldTransforms + data->nbones);
-
+	layerTransforms = worldTransforms + data->nbones;
+	currentKeyframes = (unsigned*) (layerTransforms + data->nattachments);
+	layerAttachments = currentKeyframes + data->ntimeslines;
 
+	updateLayerAttachments();
 	setDefaultPose();
 	setRootTransform(matIdentity());
 }
 
 Rig::~Rig()
 {
-	lpFree(localAttitudes);
+	lpFree(layerImages);
 }
 
 void Rig::setRootTransform(const lpMatrix& mat, bool updateChildren)
@@ -54,14 +63,31 @@ void Rig::setRootTransform(const lpMatrix& mat, bool updateChildren)
 	}
 }
 
-const lpMatrix* Rig::findTransform(const char *name) const
+template<typename T>
+static const T* findHash(const T* items, unsigned count, uint32_t hash)
 {
-	uint32_t hash = fnv1a(name);
-	for(unsigned i=0; i<data->nbones; ++i) {
-		if (data->bones[i].hash == hash) {
-			return worldTransforms + i;
+	// items are sorted on their hash, so we can binary search
+	int imin = 0;
+	int imax = count-1;
+	while (imax >= imin) {
+		int i = (imin + imax) >> 1;
+		if (items[i].hash == hash) {
+			return items + i;
+		} else if (items[i].hash < hash) {
+			imin = i+1;
+		} else {
+			imax = i-1;
 		}
 	}
+	return 0;
+}
+
+const lpMatrix* Rig::findTransform(const char *name) const
+{
+	auto entry = findHash(data->boneLookup, data->nbones, fnv1a(name));
+	if (entry) {
+		return worldTransforms + entry->index;
+	}
 	LOG(("Bone Undefined: %s\n", name));
 	return 0;
 }
@@ -76,26 +102,38 @@ void Rig::refreshTransforms()
 
 void Rig::draw(SpritePlotter* plotter, Color c)
 {
-	// OPTIMIZATION CANDIDATES:
-	// - maintain a layer-mask over attachments?
-
+	// attachment transforms are cached until the bones move or the layer changes
 	refreshTransforms();
-	for(unsigned i=0; i<data->nattachments; ++i)
-	{
-		auto& attach = data->attachments[i];
-		if (attach.layerHash == 0 || attach.layerHash == currentLayer) {
-			plotter->drawImage(
-				attach.image,
-				worldTransforms[attach.slot->boneIndex] * attach.xform,
-				0, c
-			);
+	if (layerDirty) {
+		for(unsigned i=0; i<nlayerAttachments; ++i) {
+			auto& attach = data->attachments[layerAttachments[i]];
+			layerTransforms[i] = worldTransforms[attach.slot->boneIndex] * attach.xform;
 		}
+		layerDirty = false;
 	}
+	plotter->drawImages(nlayerAttachments, layerImages, layerTransforms, c);
 }
 
 void Rig::setLayer(const char *layerName) {
 	uint32_t hash = fnv1a(layerName);
-	currentLayer = hash;
+	if (hash != currentLayer) {
+		currentLayer = hash;
+		updateLayerAttachments();
+	}
+}
+
+void Rig::updateLayerAttachments()
+{
+	nlayerAttachments = 0;
+	for(unsigned i=0; i<data->nattachments; ++i) {
+		auto& attach = data->attachments[i];
+		if (attach.layerHash == 0 || attach.layerHash == currentLayer) {
+			layerAttachments[nlayerAttachments] = i;
+			layerImages[nlayerAttachments] = attach.image;
+			++nlayerAttachments;
+		}
+	}
+	layerDirty = true;
 }
 
 void Rig::setAnimation(const char *animName)
@@ -103,43 +141,50 @@ void Rig::setAnimation(const char *animName)
 	uint32_t hash = fnv1a(animName);
 	
 	// VALIDATE
-	if (currentAnimation && hash == currentAnimation->hash) {
+	if (currentAnimation && !currentBake && hash == currentAnimation->hash) {
 		return;
 	} else {
-		bool found = false;
-		for(unsigned i=0; i<data->nanims; ++i) {
-			if (hash == data->anims[i].hash) {
-				currentAnimation = data->anims + i;
-				found = true;
-				break;
-			}
-		}
-		if (!found) {
+		auto anim = findHash(data->anims, data->nanims, hash);
+		if (!anim) {
 			LOG(("Animation Undefined: %s\n", animName));
 			return;
 		}
+		currentAnimation = anim;
 	}
 	
-	// RESET TIMER, UPDATE TIMELINE MASK
+	// RESET TIMER, UPDATE TIMELINE RANGE
+	currentBake = 0;
 	currentTime = 0.0f;
-	timelineMask.clear();
-	for(unsigned i=0; i<data->ntimeslines; ++i) {
-		if (data->timelines[i].animHash == hash) {
-			timelineMask.mark(i);
-			currentKeyframes[i] = 0;
-		}
-	}
+	timelineBegin = currentAnimation->firstTimeline;
+	timelineEnd = timelineBegin + currentAnimation->ntimelines;
 	
 	// APPLY FIRST FRAME
 	setDefaultPose();
 	resetTime();
 }
 
+void Rig::setAnimation(const RigBake* bake)
+{
+	// (a bake from another rig would point currentAnimation into that rig's asset)
+	ASSERT(bake->asset == data);
+	if (bake == currentBake || !bake->isValid()) {
+		return;
+	}
+	
+	// baked animations don't evaluate any timelines
+	currentAnimation = bake->anim;
+	currentBake = bake;
+	currentTime = 0.0f;
+	timelineBegin = timelineEnd = 0;
+	xformDirty = true;
+}
+
 
 void Rig::resetPose()
 {
 	currentAnimation = 0;
-	timelineMask.clear();
+	currentBake = 0;
+	timelineBegin = timelineEnd = 0;
 	setDefaultPose();
 	computeWorldTransforms();
 }
@@ -148,9 +193,9 @@ void Rig::resetTime()
 {
 	currentTime = 0.0f;
 	if (currentAnimation) {
-		for(BitLister i(&timelineMask); i.next(); ) {
-			currentKeyframes[i.index()] = 0;
-			applyTimeline(i.index());
+		for(unsigned i=timelineBegin; i<timelineEnd; ++i) {
+			currentKeyframes[i] = 0;
+			sampleTimeline(i, false);
 		}
 		xformDirty = true;
 	}
@@ -158,6 +203,7 @@ void Rig::resetTime()
 
 void Rig::tick(lpFloat dt)
 {
+	LP_PROFILE_ZONE("rig tick");
 	if (currentAnimation) {
 		// UPDATE TIME
 		// (just wrapping for now)
@@ -165,39 +211,86 @@ void Rig::tick(lpFloat dt)
 		if (currentTime < 0.0f) { currentTime += currentAnimation->duration; }
 		
 		// UPDATE TIMELINES
-		for(BitLister i(&timelineMask); i.next(); ) {
-			updateTimeline(i.index());
-			applyTimeline(i.index());
+		for(unsigned i=timelineBegin; i<timelineEnd; ++i) {
+			sampleTimeline(i);
 		}
 		
 		xformDirty = true;
 	}
 }
 
-void Rig::updateTimeline(int i)
+//------------------------------------------------------------------------------
+// KEY READERS
+// Timeline sampling is compiled once per key format, so the format is tested
+// once per timeline rather than on every key it reads.
+
+struct RigFloatKeys {
+	const RigTimelineAsset& tl;
+
+	RigFloatKeys(const RigTimelineAsset& atl) : tl(atl) {}
+
+	lpFloat time(unsigned i) const { return tl.times[i]; }
+	lpFloat radians(unsigned i) const { return tl.rotationValues[i]; }
+	lpVec vector(unsigned i) const { return tl.translationValues[i]; }
+};
+
+template<unsigned kStride>
+struct RigQuantizedKeys {
+	const uint16_t* keys;
+	lpFloat timeScale;
+	lpVec offset;
+	lpVec scale;
+
+	RigQuantizedKeys(const RigTimelineAsset& tl) :
+		keys(tl.packedKeys),
+		timeScale(tl.quantization->timeScale),
+		offset(tl.quantization->offset),
+		scale(tl.quantization->scale) {}
+
+	lpFloat time(unsigned i) const { return timeScale * keys[kStride * i]; }
+	lpFloat radians(unsigned i) const { return offset.x + scale.x * keys[kStride * i + 1]; }
+	lpVec vector(unsigned i) const {
+		auto key = keys + kStride * i;
+		return offset + scale * vec(key[1], key[2]);
+	}
+};
+
+//------------------------------------------------------------------------------
+// SAMPLING
+
+void Rig::sampleTimeline(int i, bool seek)
 {
 	auto& tl = data->timelines[i];
-	
-	// UPDATE KEYFRAME
-	auto& kf = currentKeyframes[i];
-	if (tl.times[kf] < currentTime) {
-		// SEARCH FORWARD
-		while (kf < tl.nkeyframes-1 && tl.times[kf+1] < currentTime) {
-			++kf;
-		}
+	if (!tl.quantized()) {
+		sampleTimeline(i, RigFloatKeys(tl), seek);
+	} else if (tl.type() == kTimelineRotation) {
+		sampleTimeline(i, RigQuantizedKeys<2>(tl), seek);
 	} else {
-		// SEARCH BACKWARD
-		while(kf > 0 && tl.times[kf] > currentTime) {
-			--kf;
-		}
+		sampleTimeline(i, RigQuantizedKeys<3>(tl), seek);
 	}
 }
 
-void Rig::applyTimeline(int i)
+template<typename Keys>
+void Rig::sampleTimeline(int i, const Keys& keys, bool seek)
 {
 	auto& tl = data->timelines[i];
 	auto& kf = currentKeyframes[i];
 	auto bi = tl.boneIndex;
+
+	// UPDATE KEYFRAME
+	if (seek) {
+		if (keys.time(kf) < currentTime) {
+			// SEARCH FORWARD
+			while (kf < tl.nkeyframes-1 && keys.time(kf+1) < currentTime) {
+				++kf;
+			}
+		} else {
+			// SEARCH BACKWARD
+			while(kf > 0 && keys.time(kf) > currentTime) {
+				--kf;
+			}
+		}
+	}
 	
 	// OPTIMIZATION CANDIDATES:
 	// - separate loop for different kinds of timelines?
@@ -206,16 +299,16 @@ void Rig::applyTimeline(int i)
 	if (kf == tl.nkeyframes-1) {
 
 		// APPLY KEYFRAME DIRECTLY
-		switch(tl.kind) {
+		switch(tl.type()) {
 			case kTimelineTranslation:
-				localTransforms[bi].t = tl.translationValues[kf];
+				localTransforms[bi].t = keys.vector(kf);
 				break;
 			case kTimelineRotation:
-				localAttitudes[bi].radians = tl.rotationValues[kf];
+				localAttitudes[bi].radians = keys.radians(kf);
 				localAttitudes[bi].applyTo(localTransforms[bi]);
 				break;
 			case kTimelineScale:
-				localAttitudes[bi].scale = tl.scaleValues[kf];
+				localAttitudes[bi].scale = keys.vector(kf);
 				localAttitudes[bi].applyTo(localTransforms[bi]);
 				break;
 			default:
@@ -225,18 +318,19 @@ void Rig::applyTimeline(int i)
 	} else {
 
 		// TWEEN KEYFRAME
-		auto tween = (currentTime - tl.times[kf]) / (tl.times[kf+1] - tl.times[kf]);
+		auto t0 = keys.time(kf);
+		auto tween = (currentTime - t0) / (keys.time(kf+1) - t0);
 		
-		switch(tl.kind) {
+		switch(tl.type()) {
 			case kTimelineTranslation:
-				localTransforms[bi].t = lerp(tl.translationValues[kf], tl.translationValues[kf+1], tween);
+				localTransforms[bi].t = lerp(keys.vector(kf), keys.vector(kf+1), tween);
 				break;
 			case kTimelineRotation:
-				localAttitudes[bi].radians = lerpRadians(tl.rotationValues[kf], tl.rotationValues[kf+1], tween);
+				localAttitudes[bi].radians = lerpRadians(keys.radians(kf), keys.radians(kf+1), tween);
 				localAttitudes[bi].applyTo(localTransforms[bi]);
 				break;
 			case kTimelineScale:
-				localAttitudes[bi].scale = lerp(tl.scaleValues[kf], tl.scaleValues[kf+1], tween);
+				localAttitudes[bi].scale = lerp(keys.vector(kf), keys.vector(kf+1), tween);
 				localAttitudes[bi].applyTo(localTransforms[bi]);
 				break;
 			default:
@@ -263,9 +357,73 @@ void Rig::computeWorldTransforms()
 	// OPTIMIZATION CANDIDATES:
 	// - maintain a dirty-mask over bones?
 	
-	for(unsigned i=1; i<data->nbones; ++i) {
-		worldTransforms[i] = worldTransforms[data->bones[i].parentIndex] * localTransforms[i];
+	if (currentBake) {
+		sampleBake();
+	} else {
+		for(unsigned i=1; i<data->nbones; ++i) {
+			worldTransforms[i] = worldTransforms[data->bones[i].parentIndex] * localTransforms[i];
+		}
 	}
 	xformDirty = false;
+	layerDirty = true;
+}
+
+void Rig::sampleBake()
+{
+	// NOTE: SKIPPING ROOT
+	
+	auto n = currentBake->nframes;
+	auto u = n > 1 ? currentTime / currentBake->frameDuration : 0.0f;
+	auto i0 = MIN((unsigned) floorToInt(u), n-1);
+	auto i1 = i0 + 1 < n ? i0 + 1 : 0;
+	u -= i0;
+	
+	auto f0 = currentBake->frame(i0);
+	auto f1 = currentBake->frame(i1);
+	for(unsigned i=1; i<data->nbones; ++i) {
+		worldTransforms[i] = worldTransforms[0] * lerp(f0[i], f1[i], u);
+	}
+}
+
+//------------------------------------------------------------------------------
+
+RigBake::RigBake(const RigAsset* anAsset, const char* animName, lpFloat framesPerSecond) :
+asset(anAsset),
+anim(0),
+nbones(anAsset->nbones),
+nframes(0),
+frameDuration(0.0f),
+frames(0)
+{
+	ASSERT(framesPerSecond > 0.0f);
+	
+	// sample with a scratch rig, relative to an identity root
+	Rig rig(asset);
+	rig.setAnimation(animName);
+	if (!rig.playing()) {
+		return;
+	}
+	
+	// round to a whole number of frames, so the bake loops seamlessly
+	anim = rig.currentAnimation;
+	nframes = (unsigned) lpCeil(anim->duration * framesPerSecond);
+	if (nframes == 0) { nframes = 1; }
+	frameDuration = anim->duration / nframes;
+	LP_MEMORY_TAG(MEMORY_TAG_RIG);
+	frames = (lpMatrix*) lpMalloc(rawSize());
+	
+	for(unsigned i=0; i<nframes; ++i) {
+		rig.currentTime = i * frameDuration;
+		for(unsigned j=rig.timelineBegin; j<rig.timelineEnd; ++j) {
+			rig.sampleTimeline(j);
+		}
+		rig.computeWorldTransforms();
+		memcpy(frames + i * nbones, rig.worldTransforms, nbones * sizeof(lpMatrix));
+	}
+}
+
+RigBake::~RigBake()
+{
+	lpFree(frames);
 }
 
@@ -15,6 +15,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "littlepolygon/assets.h"
+#include "littlepolygon/profiler.h"
 #include <zlib.h>
 
 struct WaveHeader {
@@ -49,8 +50,10 @@ struct WaveHeader {
 void SampleAsset::init()
 {
 	if (chunk == 0) {
+		LP_PROFILE_ZONE("sample init");
 		// Allocate a buffer for the RW_ops structure to read from 
-		Bytef *scratch = (Bytef*) lpMalloc(size + sizeof(WaveHeader));
+		auto& stack = lpScratch();
+		Bytef *scratch = (Bytef*) stack.alloc(size + sizeof(WaveHeader));
 		{
 		// Mixer expects a WAVE header on PCM data, so let's provide it :P
 		WaveHeader hdr = {{'R','I','F','F'},0,{'W','A','V','E'},{'f','m','t',' '},16,1,1,0,0,0,0,{'d','a','t','a'},0};
@@ -69,7 +72,7 @@ void SampleAsset::init()
 		// load the chunk
 		chunk = Mix_LoadWAV_RW(SDL_RWFromMem(scratch, sz+sizeof(WaveHeader)), 1);
 		ASSERT(chunk);
-		lpFree(scratch);
+		stack.release(scratch);
 	}
 }
 
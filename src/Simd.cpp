@@ -0,0 +1,278 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "littlepolygon/simd.h"
+
+// The x86 kernels work on interleaved (x,y) pairs directly, broadcasting each
+// point's x and y across the pair with duplicate-shuffles, so there's no
+// transpose.  NEON has de-interleaving loads, so it transposes for free.
+// lpConcatMatrices has no NEON path: there's no load which de-interleaves
+// six-float records, and transposing them by hand costs more than it saves.
+
+static_assert(sizeof(lpMatrix) == 6 * sizeof(lpFloat), "lpMatrix must be six packed floats");
+
+//--------------------------------------------------------------------------------
+// TRANSFORMS
+
+template<bool kTranslate>
+static void transformKernel(const lpMatrix& m, const lpVec* in, lpVec* out, int count)
+{
+	int i = 0;
+	auto tx = kTranslate ? m.t.x : 0.0f;
+	auto ty = kTranslate ? m.t.y : 0.0f;
+
+	#if LP_SIMD_AVX2
+	{
+		auto u = _mm256_setr_ps(m.u.x, m.u.y, m.u.x, m.u.y, m.u.x, m.u.y, m.u.x, m.u.y);
+		auto v = _mm256_setr_ps(m.v.x, m.v.y, m.v.x, m.v.y, m.v.x, m.v.y, m.v.x, m.v.y);
+		auto t = _mm256_setr_ps(tx, ty, tx, ty, tx, ty, tx, ty);
+		for(; i+4<=count; i+=4) {
+			auto p = _mm256_loadu_ps(&in[i].x);
+			auto r = _mm256_add_ps(_mm256_mul_ps(_mm256_moveldup_ps(p), u), _mm256_mul_ps(_mm256_movehdup_ps(p), v));
+			_mm256_storeu_ps(&out[i].x, _mm256_add_ps(r, t));
+		}
+	}
+	#endif
+
+	#if LP_SIMD_SSE
+	{
+		auto u = _mm_setr_ps(m.u.x, m.u.y, m.u.x, m.u.y);
+		auto v = _mm_setr_ps(m.v.x, m.v.y, m.v.x, m.v.y);
+		auto t = _mm_setr_ps(tx, ty, tx, ty);
+		for(; i+4<=count; i+=4) {
+			auto p0 = _mm_loadu_ps(&in[i].x);
+			auto p1 = _mm_loadu_ps(&in[i+2].x);
+			auto r0 = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(p0, p0, _MM_SHUFFLE(2,2,0,0)), u), t);
+			auto r1 = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(p1, p1, _MM_SHUFFLE(2,2,0,0)), u), t);
+			r0 = _mm_add_ps(r0, _mm_mul_ps(_mm_shuffle_ps(p0, p0, _MM_SHUFFLE(3,3,1,1)), v));
+			r1 = _mm_add_ps(r1, _mm_mul_ps(_mm_shuffle_ps(p1, p1, _MM_SHUFFLE(3,3,1,1)), v));
+			_mm_storeu_ps(&out[i].x, r0);
+			_mm_storeu_ps(&out[i+2].x, r1);
+		}
+		for(; i+2<=count; i+=2) {
+			auto p = _mm_loadu_ps(&in[i].x);
+			auto px = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2,2,0,0));
+			auto py = _mm_shuffle_ps(p, p, _MM_SHUFFLE(3,3,1,1));
+			auto r = _mm_add_ps(_mm_mul_ps(px, u), _mm_mul_ps(py, v));
+			_mm_storeu_ps(&out[i].x, _mm_add_ps(r, t));
+		}
+	}
+	#elif LP_SIMD_NEON
+	for(; i+4<=count; i+=4) {
+		auto p = vld2q_f32(&in[i].x);
+		float32x4x2_t r;
+		r.val[0] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(tx), p.val[0], m.u.x), p.val[1], m.v.x);
+		r.val[1] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(ty), p.val[0], m.u.y), p.val[1], m.v.y);
+		vst2q_f32(&out[i].x, r);
+	}
+	#endif
+
+	for(; i<count; ++i) {
+		out[i] = kTranslate ? m.transformPoint(in[i]) : m.transformVector(in[i]);
+	}
+}
+
+void lpTransformPoints(const lpMatrix& m, const lpVec* points, lpVec* outPoints, int count)
+{
+	transformKernel<true>(m, points, outPoints, count);
+}
+
+void lpTransformVectors(const lpMatrix& m, const lpVec* vectors, lpVec* outVectors, int count)
+{
+	transformKernel<false>(m, vectors, outVectors, count);
+}
+
+void lpConcatMatrices(const lpMatrix* lhs, const lpMatrix* rhs, lpMatrix* outMatrices, int count)
+{
+	int i = 0;
+
+	#if LP_SIMD_AVX2
+	// as below, with matrices i and i+1 in the low lanes and i+2 and i+3 in
+	// the high lanes
+	#define LP_LOAD_PAIR(_p, _q) _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(_p)), _mm_loadu_ps(_q), 1)
+	for(; i+4<=count; i+=4) {
+		auto a0 = LP_LOAD_PAIR(&lhs[i].u.x, &lhs[i+2].u.x);
+		auto a1 = LP_LOAD_PAIR(&lhs[i].t.x, &lhs[i+2].t.x);
+		auto a2 = LP_LOAD_PAIR(&lhs[i+1].v.x, &lhs[i+3].v.x);
+		auto b0 = LP_LOAD_PAIR(&rhs[i].u.x, &rhs[i+2].u.x);
+		auto b1 = LP_LOAD_PAIR(&rhs[i].t.x, &rhs[i+2].t.x);
+		auto b2 = LP_LOAD_PAIR(&rhs[i+1].v.x, &rhs[i+3].v.x);
+
+		auto uv0 = _mm256_add_ps(
+			_mm256_mul_ps(_mm256_shuffle_ps(a0, a0, _MM_SHUFFLE(1,0,1,0)), _mm256_moveldup_ps(b0)),
+			_mm256_mul_ps(_mm256_shuffle_ps(a0, a0, _MM_SHUFFLE(3,2,3,2)), _mm256_movehdup_ps(b0))
+		);
+		auto uv1 = _mm256_add_ps(
+			_mm256_mul_ps(_mm256_shuffle_ps(a1, a1, _MM_SHUFFLE(3,2,3,2)), _mm256_shuffle_ps(b1, b2, _MM_SHUFFLE(0,0,2,2))),
+			_mm256_mul_ps(_mm256_shuffle_ps(a2, a2, _MM_SHUFFLE(1,0,1,0)), _mm256_shuffle_ps(b1, b2, _MM_SHUFFLE(1,1,3,3)))
+		);
+		auto bt = _mm256_shuffle_ps(b1, b2, _MM_SHUFFLE(3,2,1,0));
+		auto t = _mm256_add_ps(
+			_mm256_add_ps(
+				_mm256_mul_ps(_mm256_shuffle_ps(a0, a1, _MM_SHUFFLE(3,2,1,0)), _mm256_moveldup_ps(bt)),
+				_mm256_mul_ps(_mm256_shuffle_ps(a0, a2, _MM_SHUFFLE(1,0,3,2)), _mm256_movehdup_ps(bt))
+			),
+			_mm256_shuffle_ps(a1, a2, _MM_SHUFFLE(3,2,1,0))
+		);
+
+		auto o1 = _mm256_shuffle_ps(t, uv1, _MM_SHUFFLE(1,0,1,0));
+		auto o2 = _mm256_shuffle_ps(uv1, t, _MM_SHUFFLE(3,2,3,2));
+		_mm_storeu_ps(&outMatrices[i].u.x, _mm256_castps256_ps128(uv0));
+		_mm_storeu_ps(&outMatrices[i].t.x, _mm256_castps256_ps128(o1));
+		_mm_storeu_ps(&outMatrices[i+1].v.x, _mm256_castps256_ps128(o2));
+		_mm_storeu_ps(&outMatrices[i+2].u.x, _mm256_extractf128_ps(uv0, 1));
+		_mm_storeu_ps(&outMatrices[i+2].t.x, _mm256_extractf128_ps(o1, 1));
+		_mm_storeu_ps(&outMatrices[i+3].v.x, _mm256_extractf128_ps(o2, 1));
+	}
+	#undef LP_LOAD_PAIR
+	#endif
+
+	#if LP_SIMD_SSE
+	// Two matrices are three registers: (u0 v0) (t0 u1) (v1 t1).  Each result
+	// column is lhs.u * col.x + lhs.v * col.y, (+ lhs.t for the translation),
+	// so the u/v columns of one matrix are done together, and the two
+	// translations are done together.
+	for(; i+2<=count; i+=2) {
+		auto a0 = _mm_loadu_ps(&lhs[i].u.x);
+		auto a1 = _mm_loadu_ps(&lhs[i].t.x);
+		auto a2 = _mm_loadu_ps(&lhs[i+1].v.x);
+		auto b0 = _mm_loadu_ps(&rhs[i].u.x);
+		auto b1 = _mm_loadu_ps(&rhs[i].t.x);
+		auto b2 = _mm_loadu_ps(&rhs[i+1].v.x);
+
+		auto uv0 = _mm_add_ps(
+			_mm_mul_ps(_mm_movelh_ps(a0, a0), _mm_shuffle_ps(b0, b0, _MM_SHUFFLE(2,2,0,0))),
+			_mm_mul_ps(_mm_movehl_ps(a0, a0), _mm_shuffle_ps(b0, b0, _MM_SHUFFLE(3,3,1,1)))
+		);
+		auto uv1 = _mm_add_ps(
+			_mm_mul_ps(_mm_movehl_ps(a1, a1), _mm_shuffle_ps(b1, b2, _MM_SHUFFLE(0,0,2,2))),
+			_mm_mul_ps(_mm_movelh_ps(a2, a2), _mm_shuffle_ps(b1, b2, _MM_SHUFFLE(1,1,3,3)))
+		);
+		auto bt = _mm_shuffle_ps(b1, b2, _MM_SHUFFLE(3,2,1,0));
+		auto t = _mm_add_ps(
+			_mm_add_ps(
+				_mm_mul_ps(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3,2,1,0)), _mm_shuffle_ps(bt, bt, _MM_SHUFFLE(2,2,0,0))),
+				_mm_mul_ps(_mm_shuffle_ps(a0, a2, _MM_SHUFFLE(1,0,3,2)), _mm_shuffle_ps(bt, bt, _MM_SHUFFLE(3,3,1,1)))
+			),
+			_mm_shuffle_ps(a1, a2, _MM_SHUFFLE(3,2,1,0))
+		);
+
+		_mm_storeu_ps(&outMatrices[i].u.x, uv0);
+		_mm_storeu_ps(&outMatrices[i].t.x, _mm_shuffle_ps(t, uv1, _MM_SHUFFLE(1,0,1,0)));
+		_mm_storeu_ps(&outMatrices[i+1].v.x, _mm_shuffle_ps(uv1, t, _MM_SHUFFLE(3,2,3,2)));
+	}
+	#endif
+
+	for(; i<count; ++i) {
+		outMatrices[i] = lhs[i] * rhs[i];
+	}
+}
+
+//--------------------------------------------------------------------------------
+// BOUNDS
+
+bool lpComputeAABB(const lpVec* points, int count, lpVec* outMin, lpVec* outMax)
+{
+	if (count <= 0) {
+		return false;
+	}
+
+	auto mn = points[0];
+	auto mx = points[0];
+	int i = 1;
+
+	#if LP_SIMD_SSE
+	if (count >= 3) {
+		// lanes are (x,y,x,y), folded together at the end
+		auto vmn = _mm_setr_ps(mn.x, mn.y, mn.x, mn.y);
+		auto vmx = vmn;
+		#if LP_SIMD_AVX2
+		if (i+4 <= count) {
+			auto wmn = _mm256_insertf128_ps(_mm256_castps128_ps256(vmn), vmn, 1);
+			auto wmx = wmn;
+			for(; i+4<=count; i+=4) {
+				auto p = _mm256_loadu_ps(&points[i].x);
+				wmn = _mm256_min_ps(wmn, p);
+				wmx = _mm256_max_ps(wmx, p);
+			}
+			vmn = _mm_min_ps(_mm256_castps256_ps128(wmn), _mm256_extractf128_ps(wmn, 1));
+			vmx = _mm_max_ps(_mm256_castps256_ps128(wmx), _mm256_extractf128_ps(wmx, 1));
+		}
+		#endif
+		for(; i+2<=count; i+=2) {
+			auto p = _mm_loadu_ps(&points[i].x);
+			vmn = _mm_min_ps(vmn, p);
+			vmx = _mm_max_ps(vmx, p);
+		}
+		vmn = _mm_min_ps(vmn, _mm_movehl_ps(vmn, vmn));
+		vmx = _mm_max_ps(vmx, _mm_movehl_ps(vmx, vmx));
+		float tmp[4];
+		_mm_storeu_ps(tmp, vmn);
+		mn = vec(tmp[0], tmp[1]);
+		_mm_storeu_ps(tmp, vmx);
+		mx = vec(tmp[0], tmp[1]);
+	}
+	#elif LP_SIMD_NEON
+	if (i+4 <= count) {
+		auto xmn = vdupq_n_f32(mn.x), ymn = vdupq_n_f32(mn.y);
+		auto xmx = xmn, ymx = ymn;
+		for(; i+4<=count; i+=4) {
+			auto p = vld2q_f32(&points[i].x);
+			xmn = vminq_f32(xmn, p.val[0]); ymn = vminq_f32(ymn, p.val[1]);
+			xmx = vmaxq_f32(xmx, p.val[0]); ymx = vmaxq_f32(ymx, p.val[1]);
+		}
+		auto fmn = vpmin_f32(vpmin_f32(vget_low_f32(xmn), vget_high_f32(xmn)), vpmin_f32(vget_low_f32(ymn), vget_high_f32(ymn)));
+		auto fmx = vpmax_f32(vpmax_f32(vget_low_f32(xmx), vget_high_f32(xmx)), vpmax_f32(vget_low_f32(ymx), vget_high_f32(ymx)));
+		mn = vec(vget_lane_f32(fmn, 0), vget_lane_f32(fmn, 1));
+		mx = vec(vget_lane_f32(fmx, 0), vget_lane_f32(fmx, 1));
+	}
+	#endif
+
+	for(; i<count; ++i) {
+		mn = vec(MIN(mn.x, points[i].x), MIN(mn.y, points[i].y));
+		mx = vec(MAX(mx.x, points[i].x), MAX(mx.y, points[i].y));
+	}
+	*outMin = mn;
+	*outMax = mx;
+	return true;
+}
+
+//--------------------------------------------------------------------------------
+// INTERPOLATION
+
+void lpLerp(const lpFloat* u, const lpFloat* v, lpFloat t, lpFloat* outValues, int count)
+{
+	int i = 0;
+
+	#if LP_SIMD_AVX2
+	{
+		auto wt = _mm256_set1_ps(t);
+		for(; i+8<=count; i+=8) {
+			auto a = _mm256_loadu_ps(u + i);
+			auto b = _mm256_loadu_ps(v + i);
+			_mm256_storeu_ps(outValues + i, _mm256_add_ps(a, _mm256_mul_ps(wt, _mm256_sub_ps(b, a))));
+		}
+	}
+	#endif
+
+	auto vt = lpFloat4x::splat(t);
+	for(; i+4<=count; i+=4) {
+		lerp(lpFloat4x::load(u + i), lpFloat4x::load(v + i), vt).store(outValues + i);
+	}
+	for(; i<count; ++i) {
+		outValues[i] = lerp(u[i], v[i], t);
+	}
+}
@@ -0,0 +1,151 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "littlepolygon/sprites.h"
+
+static inline int clampCell(int i, int n)
+{
+	return i < 0 ? 0 : i >= n ? n-1 : i;
+}
+
+SpriteGrid::SpriteGrid(SpriteBatch *aBatch, lpVec anOrigin, lpVec aCellSize, int aCols, int aRows) :
+batch(aBatch),
+origin(anOrigin),
+invCellSize(1.0f / aCellSize.x, 1.0f / aCellSize.y),
+maxExtent(0, 0),
+cols(aCols),
+rows(aRows)
+{
+	ASSERT(cols > 0 && rows > 0);
+	LP_MEMORY_TAG(MEMORY_TAG_SPRITES);
+	auto cap = batch->cap();
+	auto ncells = cols * rows;
+	handles = (SpriteHandle*) lpMalloc(cap * (sizeof(SpriteHandle) + 3 * sizeof(int)) + ncells * sizeof(int));
+	next = (int*) (handles + cap);
+	prev = next + cap;
+	cellOf = prev + cap;
+	heads = cellOf + cap;
+	clear();
+}
+
+SpriteGrid::~SpriteGrid()
+{
+	lpFree(handles);
+}
+
+void SpriteGrid::insert(SpriteHandle h)
+{
+	auto i = batch->indexOf(h);
+	ASSERT(cellOf[i] < 0);
+	handles[i] = h;
+	link(i, cellAt(h->position()));
+	growExtent(*h);
+}
+
+void SpriteGrid::update(SpriteHandle h)
+{
+	auto i = batch->indexOf(h);
+	ASSERT(cellOf[i] >= 0);
+	auto cell = cellAt(h->position());
+	if (cell != cellOf[i]) {
+		unlink(i);
+		link(i, cell);
+	}
+	growExtent(*h);
+}
+
+void SpriteGrid::remove(SpriteHandle h)
+{
+	auto i = batch->indexOf(h);
+	ASSERT(cellOf[i] >= 0);
+	unlink(i);
+	cellOf[i] = -1;
+}
+
+void SpriteGrid::clear()
+{
+	maxExtent = vec(0, 0);
+	memset(heads, 0xff, cols * rows * sizeof(int));
+	memset(cellOf, 0xff, batch->cap() * sizeof(int));
+}
+
+void SpriteGrid::draw(SpritePlotter *plotter)
+{
+	auto& view = plotter->viewport();
+	auto lo = (view.offset() - maxExtent - origin) * invCellSize;
+	auto hi = (view.extent() + maxExtent - origin) * invCellSize;
+
+	// the edge cells also hold everything outside the grid, so the range is
+	// clamped to them rather than clipped (even if the view is off the grid)
+	int x0 = clampCell(floorToInt(lo.x), cols);
+	int y0 = clampCell(floorToInt(lo.y), rows);
+	int x1 = clampCell(floorToInt(hi.x), cols);
+	int y1 = clampCell(floorToInt(hi.y), rows);
+
+	for(int y=y0; y<=y1; ++y)
+	for(int x=x0; x<=x1; ++x) {
+		for(int i=heads[y * cols + x]; i >= 0; i=next[i]) {
+			handles[i]->draw(plotter);
+		}
+	}
+}
+
+int SpriteGrid::cellAt(lpVec p) const
+{
+	auto cell = (p - origin) * invCellSize;
+	return clampCell(floorToInt(cell.y), rows) * cols + clampCell(floorToInt(cell.x), cols);
+}
+
+void SpriteGrid::link(int i, int cell)
+{
+	auto head = heads[cell];
+	next[i] = head;
+	prev[i] = -1;
+	if (head >= 0) {
+		prev[head] = i;
+	}
+	heads[cell] = i;
+	cellOf[i] = cell;
+}
+
+void SpriteGrid::unlink(int i)
+{
+	if (prev[i] >= 0) {
+		next[prev[i]] = next[i];
+	} else {
+		heads[cellOf[i]] = next[i];
+	}
+	if (next[i] >= 0) {
+		prev[next[i]] = prev[i];
+	}
+}
+
+void SpriteGrid::growExtent(const Sprite& sprite)
+{
+	// half-size of the bounds of the transformed image around its position
+	// (the extent only grows, until the grid is cleared)
+	auto p0 = sprite.xform.transformVector(-sprite.image->pivot);
+	auto du = sprite.xform.transformVector(vec(sprite.image->size.x, 0));
+	auto dv = sprite.xform.transformVector(vec(0, sprite.image->size.y));
+	lpVec corners[3] = { p0 + du, p0 + dv, p0 + du + dv };
+	auto extent = vec(lpAbs(p0.x), lpAbs(p0.y));
+	for(int i=0; i<3; ++i) {
+		extent.x = MAX(extent.x, lpAbs(corners[i].x));
+		extent.y = MAX(extent.y, lpAbs(corners[i].y));
+	}
+	maxExtent.x = MAX(maxExtent.x, extent.x);
+	maxExtent.y = MAX(maxExtent.y, extent.y);
+}
@@ -15,6 +15,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "littlepolygon/sprites.h"
+#include "littlepolygon/profiler.h"
 
 const GLchar SPRITE_VERT[] = GLSL(
 
@@ -59,6 +60,7 @@ count(-1),
 shader(SPRITE_VERT, SPRITE_FRAG),
 workingTexture(0)
 {
+	mStats.reset();
 	
 	// initialize shader
 	shader.use();
@@ -70,7 +72,7 @@ workingTexture(0)
 	aTint = shader.attribLocation("aTint");
 	
 	// setup element array buffer
-	Array<uint16_t> indices(6 * capacity());
+	Array<uint16_t> indices(6 * capacity(), &lpScratch());
 	for(uint16_t i=0; i<capacity(); ++i) {
 		indices[6*i+0] = 4*i;
 		indices[6*i+1] = 4*i+1;
@@ -79,45 +81,32 @@ workingTexture(0)
 		indices[6*i+4] = 4*i+1;
 		indices[6*i+5] = 4*i+3;
 	}
-	glGenBuffers(1, &elementBuf);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuf);
-	glBufferData(
+	elementBuf = lpRenderBackend()->createBuffer(
 		GL_ELEMENT_ARRAY_BUFFER, 
 		6 * capacity() * sizeof(uint16_t),
 		indices.ptr(),
 		GL_STATIC_DRAW
 	);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-	// initialize vbos
-	glGenVertexArrays(3, vao);
+	// initialize vaos
+	const VertexAttrib attribs[] = {
+		{ aPosition, 2, GL_FLOAT, GL_FALSE, 0 },
+		{ aUV, 2, GL_FLOAT, GL_FALSE, 8 },
+		{ aColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, 16 },
+		{ aTint, 4, GL_UNSIGNED_BYTE, GL_TRUE, 20 }
+	};
 	for(int i=0; i<3; ++i) {
-		glBindVertexArray(vao[i]);
-		glBindBuffer(GL_ARRAY_BUFFER, plotter->getVBO(i));
-		glEnableVertexAttribArray(aPosition);
-		glEnableVertexAttribArray(aUV);
-		glEnableVertexAttribArray(aColor);
-		glEnableVertexAttribArray(aTint);
-		glVertexAttribPointer(aPosition, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)0);
-		glVertexAttribPointer(aUV, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)8);
-		glVertexAttribPointer(aColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (GLvoid*)16);
-		glVertexAttribPointer(aTint, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (GLvoid*)20);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuf);
-		glBindVertexArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-		glDisableVertexAttribArray(aPosition);
-		glDisableVertexAttribArray(aUV);
-		glDisableVertexAttribArray(aColor);
-		glDisableVertexAttribArray(aTint);
+		vao[i] = lpRenderBackend()->createVertexArray(plotter->getVBO(i), elementBuf, sizeof(Vertex), arraysize(attribs), attribs);
 	}
 	
 }
 
 SpritePlotter::~SpritePlotter()
 {
-	glDeleteBuffers(1, &elementBuf);
-	glDeleteVertexArrays(3, vao);
+	lpRenderBackend()->destroyBuffer(elementBuf);
+	for(int i=0; i<3; ++i) {
+		lpRenderBackend()->destroyVertexArray(vao[i]);
+	}
 }
 
 void SpritePlotter::begin(const Viewport& aView)
@@ -126,6 +115,7 @@ void SpritePlotter::begin(const Viewport& aView)
 	count = 0;
 	view = aView;
 	shader.use();
+	++mStats.shaderBinds;
 	view.setMVP(uMVP);
 }
 
@@ -171,6 +161,53 @@ void SpritePlotter::drawImage(ImageAsset *img, const lpMatrix& xform, int frame,
 	);
 }
 
+void SpritePlotter::drawImages(int n, ImageAsset* const* images, const lpMatrix* xforms, Color c, Color tint)
+{
+	ASSERT(isBound());
+	auto viewCenter = view.center();
+	auto viewHalfSize = view.halfSize();
+	TextureAsset* texture = 0;
+	Vertex* slice = 0;
+	int room = 0;
+
+	for(int i=0; i<n; ++i) {
+
+		// only one point transform per image -- the corners are offset by the
+		// transformed edge vectors, which also give the bounds directly
+		auto *fr = images[i]->frames;
+		auto& xform = xforms[i];
+		auto p0 = xform.transformPoint(-fr->pivot);
+		auto du = xform.transformVector(vec(fr->size.x, 0));
+		auto dv = xform.transformVector(vec(0, fr->size.y));
+
+		auto halfSize = 0.5f * vec(lpAbs(du.x) + lpAbs(dv.x), lpAbs(du.y) + lpAbs(dv.y));
+		auto offset = p0 + 0.5f * (du + dv) - viewCenter;
+		auto sz = halfSize + viewHalfSize;
+		if (!(lpAbs(offset.x) < sz.x && lpAbs(offset.y) < sz.y)) {
+			++mStats.culled;
+			continue;
+		}
+
+		// the atlas and capacity are only checked when a run of images which
+		// share an atlas begins, or when the batch fills up
+		if (room == 0 || images[i]->texture != texture) {
+			texture = images[i]->texture;
+			setTextureAtlas(texture);
+			room = capacity() - count;
+			slice = nextSlice();
+		}
+
+		slice[0].set(p0, fr->uv0, c, tint);
+		slice[1].set(p0+dv, fr->uv1, c, tint);
+		slice[2].set(p0+du, fr->uv2, c, tint);
+		slice[3].set(p0+du+dv, fr->uv3, c, tint);
+		slice += 4;
+		--room;
+		++mStats.draws;
+		++count;
+	}
+}
+
 inline float min(float a, float b) { return a < b ? a : b;  }
 inline float max(float a, float b) { return a > b ? a : b;  }
 
@@ -207,7 +244,10 @@ void SpritePlotter::drawQuad(ImageAsset *img, lpVec p0, lpVec p1, lpVec p2, lpVe
 		slice[2].set(p2, fr->uv2, c, tint);
 		slice[3].set(p3, fr->uv3, c, tint);
 
+		++mStats.draws;
 		++count;
+	} else {
+		++mStats.culled;
 	}
 }
 
@@ -216,7 +256,7 @@ void SpritePlotter::drawQuad(ImageAsset *img, lpVec p0, lpVec p1, lpVec p2, lpVe
 void SpritePlotter::plotGlyph(const GlyphAsset& g, lpFloat x, lpFloat y, lpFloat h, Color c, Color t)
 {
 	if (count == capacity()) {
-		commitBatch();
+		commitBatch(FLUSH_CAPACITY);
 	}
 
 	auto slice = nextSlice();
@@ -235,6 +275,7 @@ void SpritePlotter::plotGlyph(const GlyphAsset& g, lpFloat x, lpFloat y, lpFloat
 	slice[2].set(vec(x+g.advance,y), uv+vec(du,0), c, t);
 	slice[3].set(vec(x+g.advance,y+h), uv+vec(du,dv), c, t);
 
+	++mStats.draws;
 	++count;
 }
 
@@ -304,6 +345,21 @@ void SpritePlotter::drawLabelRightJustified(FontAsset *font, lpVec p, Color c, c
 	
 }
 
+void SpritePlotter::drawStats(FontAsset *font, lpVec p, Color c, const PlotterStats& stats, Color tint)
+{
+	char buf[256];
+	snprintf(buf, sizeof(buf),
+		"draws %u (culled %u)\n"
+		"batches %u (full %u, atlas %u, flush %u)\n"
+		"vertices %u, uploaded %.1fKB\n"
+		"binds %u texture, %u shader",
+		stats.draws, stats.culled,
+		stats.batches, stats.flushes[FLUSH_CAPACITY], stats.flushes[FLUSH_ATLAS_CHANGE], stats.flushes[FLUSH_EXPLICIT],
+		stats.vertices, stats.bytesUploaded / 1024.0,
+		stats.textureBinds, stats.shaderBinds
+	);
+	drawLabel(font, p, c, buf, tint);
+}
 
 #define TILE_SLOP (0.001f)
 
@@ -354,8 +410,9 @@ void SpritePlotter::drawTilemap(TilemapAsset *map, lpVec position, Color tint)
 				slice[2].set(p+vec(tw,0),  uv+vec(uw,0),  rgba(0), tint);
 				slice[3].set(p+vec(tw,th), uv+vec(uw,uh), rgba(0), tint);
 
+				++mStats.draws;
 				if (++count == capacity()) {
-					commitBatch();
+					commitBatch(FLUSH_CAPACITY);
 				}
 			}
 		}
@@ -366,7 +423,7 @@ void SpritePlotter::flush()
 {
 	ASSERT(isBound()); 
 	if (count > 0) { 
-		commitBatch(); 
+		commitBatch(FLUSH_EXPLICIT); 
 	}
 }
 
@@ -376,19 +433,25 @@ void SpritePlotter::end()
 	flush();
 	count = -1;
 	workingTexture = 0;
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glUseProgram(0);
+	lpRenderBackend()->bindTexture(0);
+	lpRenderBackend()->useProgram(0);
 }
 
-void SpritePlotter::commitBatch()
+void SpritePlotter::commitBatch(FlushReason reason)
 {
+	LP_PROFILE_ZONE("sprite batch");
 	ASSERT(count > 0);
 	
+	++mStats.batches;
+	++mStats.flushes[reason];
+	mStats.vertices += count<<2;
+	mStats.bytesUploaded += (count<<2) * sizeof(Vertex);
 	plotter->bufferData(count<<2);
 
-	glBindVertexArray(vao[plotter->getCurrentArray()]);
-	glDrawElements(GL_TRIANGLES, 6 * count, GL_UNSIGNED_SHORT, 0);
-	glBindVertexArray(0);
+	{
+		LP_PROFILE_GPU_ZONE("sprite batch");
+		lpRenderBackend()->drawElements(vao[plotter->getCurrentArray()], GL_TRIANGLES, 6 * count);
+	}
 	
 	plotter->swapBuffer();
 	count = 0;
@@ -401,11 +464,12 @@ void SpritePlotter::setTextureAtlas(TextureAsset *texture)
 	// emit a draw call if we're at capacity or if the atlas is changing.
 	// (assuming that count will be 0 if workingTexture is null)
 	if (count == capacity() || (count > 0 && atlasChange)) {
-		commitBatch();
+		commitBatch(count == capacity() ? FLUSH_CAPACITY : FLUSH_ATLAS_CHANGE);
 	}
 
 	// check if we need to bind a new texture
 	if (atlasChange) {
+		++mStats.textureBinds;
 		texture->bind();
 		workingTexture = texture;		
 	}
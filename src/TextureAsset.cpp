@@ -15,44 +15,30 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "littlepolygon/assets.h"
+#include "littlepolygon/profiler.h"
 #include <zlib.h>
 
 void TextureAsset::init()
 {
 	if(handle == 0) {
-		glGenTextures(1, &handle);
-		glBindTexture(GL_TEXTURE_2D, handle);
-		if (flags & TEXTURE_FLAG_FILTER) {
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		} else {
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		}
-		if (flags & TEXTURE_FLAG_REPEAT) {
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		} else {
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		}
+		LP_PROFILE_ZONE("texture init");
 		uLongf size = 4 * w * h;
-		Bytef *scratch = (Bytef *) lpCalloc(w*h, 4);
+		auto& stack = lpScratch();
+		Bytef *scratch = (Bytef *) stack.alloc(size);
 		#if DEBUG
 		int result =
 		#endif
 		uncompress(scratch, &size, (const Bytef*)compressedData, compressedSize);
 		ASSERT(result == Z_OK);
-		int fmt = format();
-		glTexImage2D(GL_TEXTURE_2D, 0, fmt, w, h, 0, fmt, GL_UNSIGNED_BYTE, scratch);
-		lpFree(scratch);
+		handle = lpRenderBackend()->createTexture(w, h, format(), flags, scratch);
+		stack.release(scratch);
 	}
 }
 
 void TextureAsset::release()
 {
 	if (handle) {
-		glDeleteTextures(1, &handle);
+		lpRenderBackend()->destroyTexture(handle);
 		handle = 0;
 	}
 }
@@ -60,6 +46,6 @@ void TextureAsset::release()
 void TextureAsset::bind()
 {
 	init();
-	glBindTexture(GL_TEXTURE_2D, handle);
+	lpRenderBackend()->bindTexture(handle);
 }
 
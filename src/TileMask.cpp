@@ -0,0 +1,308 @@
+// Little Polygon SDK
+// Copyright (C) 2013 Max Kaufmann
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "littlepolygon/collision.h"
+
+// the last cell whose interior is left of (or above) x
+static inline int lastCellBefore(lpFloat x)
+{
+	return (int) lpCeil(x) - 1;
+}
+
+TileMask::TileMask(int width, int height, const uint8_t* bits) :
+mWidth(width),
+mHeight(height),
+wordsPerRow((width + 63) >> 6)
+{
+	ASSERT(width > 0 && height > 0);
+	words = (uint64_t*) lpMalloc(wordsPerRow * height * sizeof(uint64_t));
+	memset(words, 0, wordsPerRow * height * sizeof(uint64_t));
+	if (bits) {
+		for(int y=0; y<height; ++y)
+		for(int x=0; x<width; ++x) {
+			int i = x + width * y;
+			if (bits[i >> 3] & (1 << (i & 7))) {
+				mark(x, y);
+			}
+		}
+	}
+}
+
+TileMask::~TileMask()
+{
+	lpFree(words);
+}
+
+bool TileMask::get(int x, int y) const
+{
+	if (x < 0 || x >= mWidth) {
+		return true;
+	}
+	if (y < 0 || y >= mHeight) {
+		return false;
+	}
+	return (words[y * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+}
+
+void TileMask::mark(int x, int y)
+{
+	ASSERT(x >= 0 && x < mWidth);
+	ASSERT(y >= 0 && y < mHeight);
+	words[y * wordsPerRow + (x >> 6)] |= (uint64_t) 1 << (x & 63);
+}
+
+void TileMask::clear(int x, int y)
+{
+	ASSERT(x >= 0 && x < mWidth);
+	ASSERT(y >= 0 && y < mHeight);
+	words[y * wordsPerRow + (x >> 6)] &= ~((uint64_t) 1 << (x & 63));
+}
+
+//--------------------------------------------------------------------------------
+// ROW SPANS
+// The columns either side of the mask are handled up-front, so the word loops
+// only ever see cells inside it.  Bits past the width in a row's last word are
+// never marked.
+
+bool TileMask::findSolid(int y, int x0, int x1, bool forward, int* outX) const
+{
+	if (x0 > x1) {
+		return false;
+	}
+	if (forward ? x0 < 0 : x1 >= mWidth) {
+		*outX = forward ? x0 : x1;
+		return true;
+	}
+
+	int a = MAX(x0, 0);
+	int b = MIN(x1, mWidth-1);
+	if (y >= 0 && y < mHeight && a <= b) {
+		auto row = words + y * wordsPerRow;
+		int k0 = a >> 6;
+		int k1 = b >> 6;
+		auto lowMask = ~(uint64_t)0 << (a & 63);
+		auto highMask = ~(uint64_t)0 >> (63 - (b & 63));
+		if (forward) {
+			for(int k=k0; k<=k1; ++k) {
+				auto bits = row[k] & (k == k0 ? lowMask : ~(uint64_t)0) & (k == k1 ? highMask : ~(uint64_t)0);
+				if (bits) {
+					*outX = (k << 6) + CTZ64(bits);
+					return true;
+				}
+			}
+		} else {
+			for(int k=k1; k>=k0; --k) {
+				auto bits = row[k] & (k == k0 ? lowMask : ~(uint64_t)0) & (k == k1 ? highMask : ~(uint64_t)0);
+				if (bits) {
+					*outX = (k << 6) + 63 - CLZ64(bits);
+					return true;
+				}
+			}
+		}
+	}
+
+	if (forward ? x1 >= mWidth : x0 < 0) {
+		*outX = forward ? MAX(x0, mWidth) : MIN(x1, -1);
+		return true;
+	}
+	return false;
+}
+
+bool TileMask::anySolid(int y0, int y1, int x0, int x1) const
+{
+	if (y0 > y1 || x0 > x1) {
+		return false;
+	}
+	if (x0 < 0 || x1 >= mWidth) {
+		return true;
+	}
+	y0 = MAX(y0, 0);
+	y1 = MIN(y1, mHeight-1);
+	int k0 = x0 >> 6;
+	int k1 = x1 >> 6;
+	auto lowMask = ~(uint64_t)0 << (x0 & 63);
+	auto highMask = ~(uint64_t)0 >> (63 - (x1 & 63));
+	for(int y=y0; y<=y1; ++y) {
+		auto row = words + y * wordsPerRow;
+		if (k0 == k1) {
+			if (row[k0] & lowMask & highMask) {
+				return true;
+			}
+		} else {
+			uint64_t bits = (row[k0] & lowMask) | (row[k1] & highMask);
+			for(int k=k0+1; k<k1; ++k) {
+				bits |= row[k];
+			}
+			if (bits) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+//--------------------------------------------------------------------------------
+// BOX QUERIES
+
+bool TileMask::check(lpVec lo, lpVec hi) const
+{
+	return anySolid(floorToInt(lo.y), floorToInt(hi.y), floorToInt(lo.x), floorToInt(hi.x));
+}
+
+bool TileMask::checkLeft(lpVec lo, lpVec hi, lpFloat* outResult, lpFloat slop) const
+{
+	int left = floorToInt(lo.x);
+	int right = floorToInt(hi.x);
+	int top = floorToInt(lo.y);
+	int bottom = floorToInt(hi.y);
+
+	// each row only needs searching up to the best column so far
+	int best = right + 1;
+	for(int y=top; y<=bottom; ++y) {
+		int x;
+		if (findSolid(y, left, best-1, true, &x)) {
+			best = x;
+		}
+	}
+	if (best <= right) {
+		*outResult = best + 1.0f - lo.x + slop;
+		return true;
+	}
+	*outResult = 0.0f;
+	return false;
+}
+
+bool TileMask::checkRight(lpVec lo, lpVec hi, lpFloat* outResult, lpFloat slop) const
+{
+	int left = floorToInt(lo.x);
+	int right = floorToInt(hi.x);
+	int top = floorToInt(lo.y);
+	int bottom = floorToInt(hi.y);
+
+	int best = left - 1;
+	for(int y=top; y<=bottom; ++y) {
+		int x;
+		if (findSolid(y, best+1, right, false, &x)) {
+			best = x;
+		}
+	}
+	if (best >= left) {
+		*outResult = best - hi.x - slop;
+		return true;
+	}
+	*outResult = 0.0f;
+	return false;
+}
+
+bool TileMask::checkTop(lpVec lo, lpVec hi, lpFloat* outResult, lpFloat slop) const
+{
+	int left = floorToInt(lo.x);
+	int right = floorToInt(hi.x);
+	int top = floorToInt(lo.y);
+	int bottom = floorToInt(hi.y);
+	for(int y=bottom; y>=top; --y) {
+		if (anySolid(y, y, left, right)) {
+			*outResult = y + 1.0f - lo.y + slop;
+			return true;
+		}
+	}
+	*outResult = 0.0f;
+	return false;
+}
+
+bool TileMask::checkBottom(lpVec lo, lpVec hi, lpFloat* outResult, lpFloat slop) const
+{
+	int left = floorToInt(lo.x);
+	int right = floorToInt(hi.x);
+	int top = floorToInt(lo.y);
+	int bottom = floorToInt(hi.y);
+	for(int y=top; y<=bottom; ++y) {
+		if (anySolid(y, y, left, right)) {
+			*outResult = y - hi.y - slop;
+			return true;
+		}
+	}
+	*outResult = 0.0f;
+	return false;
+}
+
+//--------------------------------------------------------------------------------
+// SWEEP
+// Rows are visited in the order the box reaches them.  For each, the box's
+// x-extent over the interval it overlaps the row gives a span, and the first
+// solid cell in the span (in the direction of motion) is the first one it can
+// hit there.  Later rows are reached later, so the walk stops once a row is
+// reached after the best impact so far.
+
+bool TileMask::sweep(lpVec lo, lpVec hi, lpVec displacement, lpFloat* outTime) const
+{
+	ASSERT(lo.x <= hi.x && lo.y <= hi.y);
+	auto d = displacement;
+	int y0, y1, step;
+	if (d.y >= 0) {
+		y0 = floorToInt(lo.y);
+		y1 = lastCellBefore(hi.y + d.y);
+		step = 1;
+	} else {
+		y0 = lastCellBefore(hi.y);
+		y1 = floorToInt(lo.y + d.y);
+		step = -1;
+	}
+
+	bool hit = false;
+	lpFloat best = 1;
+	for(int y=y0; step * (y1 - y) >= 0; y+=step) {
+
+		// when the box's interior overlaps the row
+		lpFloat t0 = 0;
+		lpFloat t1 = 1;
+		if (d.y > 0) {
+			t0 = (y - hi.y) / d.y;
+			t1 = (y + 1 - lo.y) / d.y;
+		} else if (d.y < 0) {
+			t0 = (y + 1 - lo.y) / d.y;
+			t1 = (y - hi.y) / d.y;
+		}
+		t0 = MAX(t0, 0);
+		t1 = MIN(t1, 1);
+		if (hit && t0 >= best) {
+			break;
+		}
+		if (t0 >= t1) {
+			continue;
+		}
+
+		// the cells it passes over meanwhile
+		auto x0 = lo.x + d.x * (d.x < 0 ? t1 : t0);
+		auto x1 = hi.x + d.x * (d.x < 0 ? t0 : t1);
+		int x;
+		if (findSolid(y, floorToInt(x0), lastCellBefore(x1), d.x >= 0, &x)) {
+			auto t = t0;
+			if (d.x > 0) {
+				t = MAX(t0, (x - hi.x) / d.x);
+			} else if (d.x < 0) {
+				t = MAX(t0, (x + 1 - lo.x) / d.x);
+			}
+			if (!hit || t < best) {
+				hit = true;
+				best = t;
+			}
+		}
+	}
+
+	*outTime = best;
+	return hit;
+}
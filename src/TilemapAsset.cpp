@@ -15,12 +15,15 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "littlepolygon/assets.h"
+#include "littlepolygon/profiler.h"
 #include <zlib.h>
 
 void TilemapAsset::init()
 {
 	tileAtlas.init();
 	if (!data) {
+		LP_PROFILE_ZONE("tilemap init");
+		LP_MEMORY_TAG(MEMORY_TAG_ASSETS);
 		data = (TileAsset*) lpCalloc( mw * mh, sizeof(TileAsset) );
 		uLongf size = sizeof(TileAsset) * mw * mh;
 		int result = uncompress((Bytef*)data, &size, (const Bytef*)compressedData, compressedSize);
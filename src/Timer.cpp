@@ -16,49 +16,173 @@
 
 #include <littlepolygon/events.h>
 
-void TimerQueue::enqueue(TimerCallback *newListener, lpFloat duration)
+TimerQueue::TimerQueue() : time(0.0f), currentTick(0)
 {
-	ASSERT(!newListener->isBound());
-	if (hasQueue()) {
-		
-		// we need to determine if we're appending to the end of the list (common case)
-		// or if we need to find a spot in the middle
-		
-		newListener->time = duration+time;
-		if (head.prevTime() < newListener->time) {
-			newListener->attachBefore(&head);
-		} else {
-			auto p = &head;
-			while(p->nextTime() < newListener->time) {
-				p = static_cast<TimerCallback*>(p->next);
+	memset(occupied, 0, sizeof(occupied));
+}
+
+bool TimerQueue::hasQueue() const
+{
+	// occupancy bits are set eagerly but cleared lazily, since timers can be
+	// cancelled by unbinding them without the queue knowing about it
+	
+	for(int level=0; level<kLevelCount; ++level) {
+		auto bits = occupied[level];
+		while(bits) {
+			auto slot = CTZ64(bits);
+			if (wheel[level][slot].isBound()) {
+				return true;
 			}
-			newListener->attachAfter(p);
+			occupied[level] &= ~(1ULL << slot);
+			bits &= bits - 1;
 		}
-		
-	} else {
+	}
+	return overflow.isBound();
+}
+
+void TimerQueue::clear()
+{
+	for(int level=0; level<kLevelCount; ++level) {
+		for(int slot=0; slot<kSlotCount; ++slot) {
+			auto& head = wheel[level][slot];
+			while(head.isBound()) { head.next->unbind(); }
+		}
+		occupied[level] = 0;
+	}
+	while(overflow.isBound()) { overflow.next->unbind(); }
+}
+
+void TimerQueue::enqueue(TimerCallback *newListener, lpFloat duration)
+{
+	ASSERT(!newListener->isBound());
+	if (!hasQueue()) {
 		
 		// the first listener resets the timer (staying near zero feels like
 		// a good idea over the long term :P)
 		
 		time = 0;
-		newListener->time = duration;
-		newListener->attachAfter(&head);
+		currentTick = 0;
 		
 	}
-		
+	
+	newListener->time = time + MAX(duration, 0.0f);
+	place(newListener);
+}
+
+void TimerQueue::place(TimerCallback *listener)
+{
+	// the level is determined by the highest group of bits in which the
+	// expiration tick differs from the current tick
+	
+	auto tick = MAX(ticksAt(listener->time), currentTick);
+	auto diff = tick ^ currentTick;
+	for(int level=0; level<kLevelCount; ++level) {
+		if ((diff >> (kSlotBits * (level+1))) == 0) {
+			auto slot = (tick >> (kSlotBits * level)) & kSlotMask;
+			listener->attachBefore(&wheel[level][slot]);
+			occupied[level] |= 1ULL << slot;
+			return;
+		}
+	}
+	listener->attachBefore(&overflow);
+}
+
+void TimerQueue::cascade(Slot *slot)
+{
+	// detach the whole list first, since overflow timers may land right back
+	// in the overflow slot
+	
+	Slot pending;
+	if (slot->isBound()) {
+		pending.attachAfter(slot);
+		slot->unbind();
+	}
+	while(pending.isBound()) {
+		auto p = static_cast<TimerCallback*>(pending.next);
+		p->unbind();
+		place(p);
+	}
+}
+
+void TimerQueue::cascadeAt(uint32_t tick)
+{
+	// outermost first, so that everything ends up in its final slot
+	
+	const int span = kSlotBits * kLevelCount;
+	if (((tick >> span) << span) == tick) {
+		cascade(&overflow);
+	}
+	for(int level=kLevelCount-1; level>0; --level) {
+		auto shift = kSlotBits * level;
+		if (((tick >> shift) << shift) == tick) {
+			auto index = (tick >> shift) & kSlotMask;
+			cascade(&wheel[level][index]);
+			occupied[level] &= ~(1ULL << index);
+		}
+	}
+}
+
+bool TimerQueue::fireSlot(Slot *slot, bool all)
+{
+	// we use a bookmark to allow timers to be cancelled or enqueued by
+	// callbacks without losing our place in the list.  Returns false if the
+	// queue was cleared by a callback.
+	
+	Slot bookmark;
+	EventCallback<>* p = slot->next;
+	while(p != slot) {
+		if (all || static_cast<TimerCallback*>(p)->time <= time) {
+			bookmark.attachAfter(p);
+			p->unbind();
+			p->callback();
+			if (!bookmark.isBound()) {
+				return false;
+			}
+			p = bookmark.next;
+			bookmark.unbind();
+		} else {
+			p = p->next;
+		}
+	}
+	return true;
 }
 
 void TimerQueue::tick(lpFloat dt)
 {
 	if (hasQueue()) {
 		
-		// dequeue everything that's passed below the time threshold
+		// walk the innermost level tick-by-tick, cascading outer slots down as
+		// we cross into each of their spans.  Every timer in a slot we've passed
+		// is due; in the final slot we only take those below the threshold.
 		
 		time += dt;
-		while(hasQueue() && head.nextTime() <= time) {
-			auto p = head.next;
-			p->unbind();
-			p->callback();
+		auto target = ticksAt(time);
+		for(;;) {
+			auto index = currentTick & kSlotMask;
+			auto slot = &wheel[0][index];
+			if (slot->isBound() && !fireSlot(slot, currentTick != target)) {
+				return;
+			}
+			if (!slot->isBound()) {
+				occupied[0] &= ~(1ULL << index);
+			}
+			if (currentTick == target) {
+				break;
+			}
+			
+			// skip the rest of this span if the innermost level is empty
+			
+			if (occupied[0] == 0) {
+				currentTick = MIN(currentTick | kSlotMask, target);
+				if (currentTick == target) {
+					continue;
+				}
+			}
+			
+			++currentTick;
+			if ((currentTick & kSlotMask) == 0) {
+				cascadeAt(currentTick);
+			}
 		}
 		
 	}
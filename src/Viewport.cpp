@@ -72,6 +72,6 @@ void Viewport::setMVP(GLuint amvp) const
 		0, 0, 2.f/fsn, 0,
 		t.x, -t.y, -fan/fsn, 1
 	};
-	glUniformMatrix4fv(amvp, 1, GL_FALSE, buf);
+	lpRenderBackend()->setUniformMatrix(amvp, buf);
 }
 
@@ -412,15 +412,30 @@ def compressed_userdata(id, data):
 ################################################################################
 # RIG ASSET (based on Spine)
 
+# Optional params:
+#   tolerance - drop keys (and bind-pose timelines) reproducible within this error
+#   quantize  - export 16-bit interleaved keys instead of float arrays
+
 def _parse_yaml_rig(context, id, params):
-	return RigAsset(context, id, _parse_yaml_path(context, params))
+	if isinstance(params, dict):
+		return RigAsset(
+			context, id, 
+			_parse_yaml_path(context, params['path']),
+			float(params.get('tolerance', 0)),
+			bool(params.get('quantize', False))
+		)
+	else:
+		return RigAsset(context, id, _parse_yaml_path(context, params))
 
 class RigAsset:
-	def __init__(self, context, id, path):
+	def __init__(self, context, id, path, tolerance=0, quantize=False):
 		self.context = context
 		_set_id(self, id)
 		self.model = rig.Rig(path)
 		self.model.asset = self
+		if tolerance > 0:
+			self.model.optimize(tolerance)
+		self.quantize = quantize
 
 		# LINK ATTACHMENTS TO IMAGES
 		failed = False
@@ -31,6 +31,8 @@ ASSET_TYPE_PALETTE = 6
 ASSET_TYPE_USERDATA = 7
 ASSET_TYPE_RIG = 8
 
+RIG_TIMELINE_QUANTIZED = 0x100
+
 def export_native_assets(assetGroup, outpath, bpp):
 	print '-' * 80
 	print 'BUILDING BINARY IMAGE'
@@ -215,6 +217,7 @@ def export_native_assets(assetGroup, outpath, bpp):
 		def attach_name(attachment): return "%s.attachment[%d]" % (attachment.slot.rig.asset.id, attachment.index)
 		def anim_name(anim): return "%s.anim[%d]" % (anim.rig.asset.id, anim.index)
 		def timeline_name(timeline): return "%s.timeline[%d]" % (timeline.bone_anim.anim.rig.asset.id, timeline.index)
+		bone_lookup_name = "%s.boneLookup" % rig.id
 
 		print 'Writing Rig (%s)' % rig.id
 		# RIG FORMAT
@@ -229,8 +232,9 @@ def export_native_assets(assetGroup, outpath, bpp):
 		# attachments  : Attachment*
 		# animations   : Animation*
 		# timelines    : Timeline*
+		# boneLookup   : HashIndex*
 		records.append(bintools.Record(
-			rig.id, 'IIIIII#####',
+			rig.id, 'IIIIII######',
 			(
 				rig.model.defaultLayer.hash, 
 				len(rig.model.bones), 
@@ -242,7 +246,8 @@ def export_native_assets(assetGroup, outpath, bpp):
 				slot_name(rig.model.slots[0]), 
 				attach_name(rig.model.attachments[0]),
 				anim_name(rig.model.anims[0]),
-				timeline_name(rig.model.timelines[0])
+				timeline_name(rig.model.timelines[0]),
+				bone_lookup_name
 			)
 		))
 
@@ -269,6 +274,16 @@ def export_native_assets(assetGroup, outpath, bpp):
 				)
 			))
 
+		# RIG::HASHINDEX FORMAT
+		# (sorted by hash, so we can bin-search at runtime)
+		# hash  : uint32
+		# index : uint32
+		bone_lookup = sorted(rig.model.bones, key = lambda bone: bone.hash)
+		records.append(bintools.Record(
+			bone_lookup_name, 'II' * len(bone_lookup),
+			tuple(e for bone in bone_lookup for e in (bone.hash, bone.index))
+		))
+
 		# RIG::SLOT FORMAT
 		# boneIdx       : uint32
 		# defaultAttach : uint32
@@ -309,17 +324,20 @@ def export_native_assets(assetGroup, outpath, bpp):
 			))
 
 		# RIG::ANIMATION FORMAT
-		# hash     : uint32
-		# duration : float
+		# (sorted by hash, so we can bin-search at runtime)
+		# hash          : uint32
+		# duration      : float
+		# firstTimeline : uint32
+		# ntimelines    : uint32
 		for anim in rig.model.anims:
 			records.append(bintools.Record(
-				anim_name(anim), "If",
-				(anim.hash, anim.duration)
+				anim_name(anim), "IfII",
+				(anim.hash, anim.duration, anim.first_timeline, anim.timeline_count)
 			))
 
 		# RIG::TIMELINE FORMAT
-		# times      : *float
-		# values     : *void
+		# times      : *float (*uint16 keys when quantized)
+		# values     : *void (*Quantization when quantized)
 		# nkeyframes : uint32
 		# animHash   : uint32
 		# targetIdx  : uint32
@@ -334,17 +352,32 @@ def export_native_assets(assetGroup, outpath, bpp):
 					len(timeline.times),
 					timeline.bone_anim.anim.hash,
 					timeline.bone_anim.bone.index,
-					timeline.kind
+					timeline.kind | (RIG_TIMELINE_QUANTIZED if rig.quantize else 0)
 				)
 			))
 		for timeline in rig.model.timelines:
-			tlname = timeline_name(timeline)			
-			records.append(bintools.Record(
-				tlname+".times", "f" * len(timeline.times), timeline.times
-			))
-			records.append(bintools.Record(
-				tlname+".values", "f" * len(timeline.values), timeline.values
-			))
+			tlname = timeline_name(timeline)
+			if rig.quantize:
+				# RIG::QUANTIZATION FORMAT
+				# timeScale : float32
+				# offsetX   : float32
+				# offsetY   : float32
+				# scaleX    : float32
+				# scaleY    : float32
+				timeScale, offset, scale, keys = timeline.quantize(timeline.bone_anim.anim.duration)
+				records.append(bintools.Record(
+					tlname+".times", "H" * len(keys), keys
+				))
+				records.append(bintools.Record(
+					tlname+".values", "fffff", (timeScale,) + offset + scale
+				))
+			else:
+				records.append(bintools.Record(
+					tlname+".times", "f" * len(timeline.times), timeline.times
+				))
+				records.append(bintools.Record(
+					tlname+".values", "f" * len(timeline.values), timeline.values
+				))
 
 
 	for data in assetGroup.userdata:
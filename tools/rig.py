@@ -43,6 +43,15 @@ def _make_index(li):
 def _vadd(u, v): return (u[0] + v[0], u[1] + v[1])
 def _vmul(u, v): return (u[0] * v[0], u[1] * v[1])
 
+# Key helpers (values are tuples so rotations and vectors share code paths)
+def _wrap_angle(angle): return math.atan2(math.sin(angle), math.cos(angle))
+def _key_error(kind, u, v):
+	if kind == TimelineRotation: return abs(_wrap_angle(u[0] - v[0]))
+	return max(abs(a - b) for a,b in zip(u, v))
+def _key_lerp(kind, u, v, t):
+	if kind == TimelineRotation: return (u[0] + t * _wrap_angle(v[0] - u[0]),)
+	return tuple(a + t * (b - a) for a,b in zip(u, v))
+
 class Rig:
 	def __init__(self, path):
 		assert os.path.exists(path)
@@ -92,20 +101,44 @@ class Rig:
 		self.name_to_event = _name_dict(self.events)
 
 		# ANIMATIONS
+		# (sorted by hash, so we can bin-search at runtime)
 		self.anims = [ Animation(self, key, val) for key, val in self.doc.get('animations', {}).iteritems() ]
+		self.anims.sort(key = lambda anim: anim.hash)
 		assert _hashes_unique(self.anims)
 		self.name_to_anim = _name_dict(self.anims)
 		_make_index(self.anims)
 
-		# Flatten timelines list
-		self.timelines = [
-			timeline 
-			for anim in self.anims 
-			for bone_anim in anim.bone_animations
-			for timeline in bone_anim.timelines
-		]
+		self._flatten_timelines()
+
+	# Timelines are grouped by animation, so each animation can refer to
+	# a contiguous range of them.
+	def _flatten_timelines(self):
+		self.timelines = []
+		for anim in self.anims:
+			anim.first_timeline = len(self.timelines)
+			self.timelines += [
+				timeline 
+				for bone_anim in anim.bone_animations
+				for timeline in bone_anim.timelines
+			]
+			anim.timeline_count = len(self.timelines) - anim.first_timeline
 		_make_index(self.timelines)
 
+	# Drop keys that linear interpolation reproduces within tolerance, and then
+	# drop timelines that never leave the bind pose (the runtime restores the
+	# bind pose whenever the animation changes, so they're redundant).
+	def optimize(self, tolerance):
+		for anim in self.anims:
+			for bone_anim in anim.bone_animations:
+				for timeline in bone_anim.timelines:
+					timeline.reduce(tolerance)
+				bone_anim.timelines = [ 
+					timeline 
+					for timeline in bone_anim.timelines 
+					if not timeline.is_bind_pose(tolerance) 
+				]
+		self._flatten_timelines()
+
 class Bone:
 	def __init__(self, rig, doc):
 		self.rig = rig
@@ -251,6 +284,67 @@ class Timeline:
 		elif kind == TimelineScale:
 			self.values = [ comp for k in keys for comp in _vmul(self.bone.scale, (k['x'], k['y'])) ]
 
+	def component_count(self):
+		return 1 if self.kind == TimelineRotation else 2
+
+	def keys(self):
+		n = self.component_count()
+		return [ (t, tuple(self.values[i*n:(i+1)*n])) for i,t in enumerate(self.times) ]
+
+	def set_keys(self, keys):
+		self.times = [ t for t,_ in keys ]
+		self.values = [ comp for _,v in keys for comp in v ]
+
+	def bind_pose(self):
+		if self.kind == TimelineTranslation: return self.bone.pos
+		elif self.kind == TimelineRotation: return (self.bone.radians,)
+		else: return self.bone.scale
+
+	def is_bind_pose(self, tolerance):
+		return len(self.times) == 1 and \
+			_key_error(self.kind, self.keys()[0][1], self.bind_pose()) <= tolerance
+
+	# Greedy curve-fit: a key is dropped if every key between the last kept key
+	# and its successor is reproduced by the runtime lerp within tolerance.
+	# Constant timelines collapse to a single key.
+	def reduce(self, tolerance):
+		keys = self.keys()
+		if len(keys) < 2: return
+		def fits(i0, i1):
+			t0,v0 = keys[i0]
+			t1,v1 = keys[i1]
+			for t,v in keys[i0+1:i1]:
+				u = (t - t0) / float(t1 - t0) if t1 > t0 else 0.0
+				if _key_error(self.kind, v, _key_lerp(self.kind, v0, v1, u)) > tolerance: 
+					return False
+			return True
+		kept = [0]
+		for i in xrange(1, len(keys)-1):
+			if not fits(kept[-1], i+1): kept.append(i)
+		kept.append(len(keys)-1)
+		if len(kept) == 2 and _key_error(self.kind, keys[0][1], keys[-1][1]) <= tolerance:
+			kept = [0]
+		self.set_keys([ keys[i] for i in kept ])
+
+	# Quantize to 16-bit keys interleaved as (time, value...) so that sampling
+	# a keyframe pair touches a single cache line at runtime.  Returns the
+	# dequantization parameters (timeScale, offset, scale) and the packed keys.
+	def quantize(self, duration):
+		n = self.component_count()
+		lo = [ min(self.values[c::n]) for c in xrange(n) ]
+		hi = [ max(self.values[c::n]) for c in xrange(n) ]
+		scale = [ (h - l) / 65535.0 for l,h in zip(lo, hi) ]
+		time_scale = duration / 65535.0
+		def q(x, l, k): return 0 if k <= 0 else min(65535, max(0, int(round((x - l) / k))))
+		packed = []
+		for t,v in self.keys():
+			packed.append(q(t, 0.0, time_scale))
+			packed += [ q(x, l, k) for x,l,k in zip(v, lo, scale) ]
+		if n == 1:
+			lo.append(0.0)
+			scale.append(0.0)
+		return time_scale, tuple(lo), tuple(scale), packed
+
 class SlotAnimation:
 	def __init__(self, anim, slot_name, doc):
 		self.anim = anim